@@ -0,0 +1,284 @@
+﻿// BatchConvert.cpp : 批量转换的任务收集与调度
+//
+
+#include "BatchConvert.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <filesystem>
+#include <cctype>
+
+#include "Mesh.h"
+#include "MeshBinary.h"
+#include "ParallelChunks.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// 文件名通配符匹配，* 匹配任意长度 (包括空)，? 匹配单个字符
+bool wildcardMatch(const string& pattern, const string& name) {
+    size_t p = 0, n = 0, star = string::npos, resume = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            ++p; ++n;
+        }
+        else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = n;
+        }
+        else if (star != string::npos) {
+            p = star + 1;
+            n = ++resume;
+        }
+        else return false;
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+// 去掉压缩扩展名 (.gz / .zst) 后的路径
+fs::path withoutCompressionExtension(const fs::path& path) {
+    return compressionForPath(path.string()) == Compression::None ? path : fs::path(path).replace_extension();
+}
+
+// .ply，以及压缩的 .ply.gz / .ply.zst
+bool hasPlyExtension(const fs::path& path) {
+    string ext = withoutCompressionExtension(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return ext == ".ply";
+}
+
+// 列出目录中满足 accept 的普通文件，按路径排序
+bool listDirectory(const fs::path& dir, bool (*accept)(const fs::path&, const string&), const string& pattern,
+    vector<fs::path>& files) {
+    std::error_code ec;
+    fs::directory_iterator it(dir, ec);
+    if (ec) {
+        cerr << "错误: 无法列出目录 " << dir.string() << ": " << ec.message() << endl;
+        return false;
+    }
+    for (const auto& entry : it) {
+        if (entry.is_regular_file(ec) && accept(entry.path(), pattern)) files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    return true;
+}
+
+bool collectBatchJobs(const string& source, const string& outputDir, vector<BatchJob>& jobs) {
+    vector<pair<fs::path, fs::path>> pairs; // 输入路径，输出路径 (为空时由输入文件名决定)
+    std::error_code ec;
+    const fs::path sourcePath(source);
+
+    if (fs::is_directory(sourcePath, ec)) {
+        vector<fs::path> files;
+        if (!listDirectory(sourcePath, [](const fs::path& p, const string&) { return hasPlyExtension(p); }, "", files)) {
+            return false;
+        }
+        for (const auto& f : files) pairs.push_back({ f, fs::path() });
+    }
+    else if (source.find_first_of("*?") != string::npos) {
+        fs::path dir = sourcePath.parent_path();
+        if (dir.empty()) dir = ".";
+        if (dir.string().find_first_of("*?") != string::npos) {
+            cerr << "错误: 通配符只能出现在文件名中: " << source << endl;
+            return false;
+        }
+        vector<fs::path> files;
+        if (!listDirectory(dir, [](const fs::path& p, const string& pattern) { return wildcardMatch(pattern, p.filename().string()); },
+            sourcePath.filename().string(), files)) {
+            return false;
+        }
+        for (const auto& f : files) pairs.push_back({ f, fs::path() });
+    }
+    else {
+        ifstream manifest(source);
+        if (!manifest.is_open()) {
+            cerr << "错误: 无法打开批量转换的输入 " << source << " (应为目录、通配符模式或清单文件)" << endl;
+            return false;
+        }
+        string line;
+        while (getline(manifest, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            const size_t tab = line.find('\t');
+            pairs.push_back({ fs::path(line.substr(0, tab)), tab == string::npos ? fs::path() : fs::path(line.substr(tab + 1)) });
+        }
+    }
+
+    const fs::path outDir(outputDir);
+    for (const auto& p : pairs) {
+        BatchJob job;
+        job.input = p.first.string();
+        fs::path output = p.second.empty() ? fs::path(withoutCompressionExtension(p.first).stem().string() + ".obj") : p.second;
+        job.output = (output.is_absolute() ? output : outDir / output).string();
+        const uintmax_t size = fs::file_size(p.first, ec);
+        job.inputBytes = ec ? 0 : static_cast<uint64_t>(size);
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+// OBJ旁的二进制网格路径：去掉压缩扩展名后把 .obj 换成 .pmesh
+string binaryOutputPath(const string& objPath, Compression compression) {
+    fs::path path(objPath);
+    if (compression != Compression::None && path.extension() == compressionExtension(compression)) {
+        path.replace_extension();
+    }
+    return path.replace_extension(".pmesh").string();
+}
+
+// 同一线程上依次转换的文件共用一个网格，复用已分配的数组以减少分配器的调用和线程间的争用。
+// 转换后占用超过该大小的网格被释放，避免大文件的内存一直保留到批量转换结束。
+const size_t kReusableMeshBytes = size_t(256) << 20;
+
+// 转换一个文件，内部使用 threadCount 个线程
+BatchResult convertBatchJob(const BatchJob& job, const BatchOptions& options, unsigned threadCount) {
+    auto start = std::chrono::steady_clock::now();
+    PlyReadOptions readOptions = options.readOptions;
+    ObjWriteOptions writeOptions = options.writeOptions;
+    readOptions.threadCount = writeOptions.threadCount = writeOptions.compression.threadCount = threadCount;
+    // 未指定压缩方式时按输出文件的扩展名决定 (清单中可以直接写 .obj.gz)
+    if (writeOptions.compression.method == Compression::None) {
+        writeOptions.compression.method = compressionForPath(job.output);
+    }
+
+    BatchResult result;
+    result.polygons = readOptions.keepPolygons;
+    std::error_code ec;
+    const fs::path parent = fs::path(job.output).parent_path();
+    if (!parent.empty()) fs::create_directories(parent, ec);
+
+    bool has_normals = false, has_colors = false, has_texCoords = false;
+    if (options.streaming) {
+        result.ok = convertPLYToOBJStreaming(job.input, job.output, readOptions, writeOptions, options.streamOptions,
+            result.vertexCount, result.triangleCount, has_normals, has_colors, has_texCoords);
+        if (!result.ok) result.error = "流式转换出错";
+    }
+    else {
+        thread_local Mesh mesh;
+        bool read_ok = readPLYCached(job.input, mesh, has_normals, has_colors, has_texCoords, readOptions,
+            options.meshCache, result.cacheHit);
+        if (read_ok && options.weld) {
+            WeldOptions weldOptions = options.weldOptions;
+            weldOptions.threadCount = threadCount;
+            weldVertices(mesh, weldOptions);
+        }
+        if (read_ok && options.computeNormals) {
+            NormalOptions normalOptions = options.normalOptions;
+            normalOptions.threadCount = threadCount;
+            if (computeVertexNormals(mesh, normalOptions).computed) has_normals = true;
+        }
+        if (read_ok && options.optimizeCache) {
+            optimizeVertexCache(mesh, options.cacheOptions);
+        }
+        if (!read_ok) {
+            result.error = "PLY文件读取错误或格式不受支持";
+        }
+        else if (!writeOBJ(job.output, mesh, has_normals, has_colors, has_texCoords, writeOptions)) {
+            result.error = "OBJ文件写入错误";
+        }
+        else if (options.writeBinary && !writeMeshBinaryOutput(binaryOutputPath(job.output, writeOptions.compression.method),
+            mesh, has_normals, has_colors, has_texCoords)) {
+            result.error = "二进制网格写入错误";
+        }
+        else {
+            result.ok = true;
+            result.vertexCount = mesh.vertexCount();
+            result.triangleCount = mesh.faceCount();
+        }
+        const size_t meshBytes = Mesh::vertexBytes(mesh.presence) * mesh.positions.capacity() +
+            sizeof(Triangle) * mesh.triangles.capacity() +
+            sizeof(size_t) * mesh.polygons.offsets.capacity() + sizeof(MeshIndex) * mesh.polygons.indices.capacity();
+        if (meshBytes > kReusableMeshBytes) mesh = Mesh();
+    }
+    result.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// 比较输出路径用的键：绝对路径的规范形式 (Windows 的文件名不区分大小写)
+string outputKey(const string& path) {
+    std::error_code ec;
+    fs::path absolute = fs::absolute(fs::path(path), ec);
+    string key = (ec ? fs::path(path) : absolute).lexically_normal().string();
+#ifdef _WIN32
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+#endif
+    return key;
+}
+
+// 输出文件 (及 .pmesh) 与之前的任务相同的任务不转换，在结果中报告为失败，避免后者覆盖前者
+// 或两个线程同时写同一个文件
+void markDuplicateOutputs(const vector<BatchJob>& jobs, const BatchOptions& options, vector<BatchResult>& results) {
+    map<string, size_t> owners; // 输出路径的键 -> 任务序号
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        vector<string> outputs = { jobs[i].output };
+        if (options.writeBinary && !options.streaming) {
+            Compression compression = options.writeOptions.compression.method;
+            if (compression == Compression::None) compression = compressionForPath(jobs[i].output);
+            outputs.push_back(binaryOutputPath(jobs[i].output, compression));
+        }
+        bool duplicate = false;
+        for (const string& output : outputs) {
+            auto it = owners.find(outputKey(output));
+            if (it == owners.end()) continue;
+            results[i].error = "输出文件 " + output + " 与 " + jobs[it->second].input + " 的输出相同，未转换";
+            duplicate = true;
+            break;
+        }
+        if (duplicate) continue;
+        for (const string& output : outputs) owners[outputKey(output)] = i;
+    }
+}
+
+vector<BatchResult> runBatch(const vector<BatchJob>& jobs, const BatchOptions& options) {
+    vector<BatchResult> results(jobs.size());
+    const unsigned threadCount = std::max(1u, options.threadCount);
+    markDuplicateOutputs(jobs, options, results);
+
+    vector<size_t> large, small;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (!results[i].error.empty()) continue;
+        if (threadCount > 1 && jobs[i].inputBytes >= options.largeFileBytes) large.push_back(i);
+        else small.push_back(i);
+    }
+
+    // 大文件：逐个转换，文件内部并行
+    for (size_t i : large) {
+        results[i] = convertBatchJob(jobs[i], options, threadCount);
+    }
+
+    // 小文件：先领取大的，最后剩下的小文件填满各线程的空闲时间
+    std::stable_sort(small.begin(), small.end(), [&jobs](size_t a, size_t b) { return jobs[a].inputBytes > jobs[b].inputBytes; });
+    runParallel(small.size(), threadCount, [&](size_t k) {
+        results[small[k]] = convertBatchJob(jobs[small[k]], options, 1);
+    });
+    return results;
+}
+
+size_t printBatchSummary(ostream& out, const vector<BatchJob>& jobs, const vector<BatchResult>& results) {
+    size_t failed = 0;
+    size_t vertices = 0, triangles = 0;
+    bool polygons = false;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const BatchResult& r = results[i];
+        if (r.ok) {
+            out << "  成功: " << jobs[i].input << " -> " << jobs[i].output << " (" << r.vertexCount << " 个顶点, "
+                << r.triangleCount << (r.polygons ? " 个多边形面, " : " 个三角形面, ") << r.milliseconds << "毫秒" << (r.cacheHit ? ", 缓存命中" : "") << ")\n";
+            vertices += r.vertexCount;
+            triangles += r.triangleCount;
+            polygons = polygons || r.polygons;
+        }
+        else {
+            out << "  失败: " << jobs[i].input << " (" << r.error << ")\n";
+            ++failed;
+        }
+    }
+    out << "批量转换完成: " << (jobs.size() - failed) << " 个成功, " << failed << " 个失败; 共 "
+        << vertices << " 个顶点, " << triangles << (polygons ? " 个面" : " 个三角形面") << endl;
+    return failed;
+}
@@ -0,0 +1,67 @@
+﻿// BatchConvert.h : 批量转换多个PLY文件
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "MeshCache.h"
+#include "ObjWriter.h"
+#include "PlyReader.h"
+#include "StreamConvert.h"
+#include "VertexCache.h"
+#include "VertexNormals.h"
+#include "VertexWeld.h"
+
+// 一个转换任务
+struct BatchJob {
+    std::string input;
+    std::string output;
+    uint64_t inputBytes = 0;
+};
+
+// 批量转换选项
+struct BatchOptions {
+    unsigned threadCount = 1;     // 工作线程数
+    uint64_t largeFileBytes = uint64_t(64) << 20; // 不小于此大小的文件单独转换，由全部线程在文件内部并行
+    PlyReadOptions readOptions;   // threadCount 字段由调度决定
+    ObjWriteOptions writeOptions; // 同上
+    bool streaming = false;       // 每个文件使用流式转换
+    StreamOptions streamOptions;
+    bool weld = false;            // 读取后焊接重复顶点 (不能与流式转换同时使用)
+    WeldOptions weldOptions;      // threadCount 字段由调度决定
+    bool computeNormals = false;  // 焊接之后计算顶点法线 (不能与流式转换同时使用)
+    NormalOptions normalOptions;  // threadCount 字段由调度决定
+    bool optimizeCache = false;   // 焊接之后重排三角形以优化顶点缓存 (不能与流式转换同时使用)
+    VertexCacheOptions cacheOptions;
+    MeshCacheOptions meshCache;   // 解码后网格的磁盘缓存 (流式转换不使用)
+    bool writeBinary = false;     // 同时在OBJ旁写入扩展名为 .pmesh 的二进制网格 (不能与流式转换同时使用)
+};
+
+// 单个文件的转换结果
+struct BatchResult {
+    bool ok = false;
+    std::string error; // 失败原因，详细信息已输出到 cerr
+    size_t vertexCount = 0, triangleCount = 0; // 保留多边形时 triangleCount 为多边形数
+    bool polygons = false;
+    long long milliseconds = 0;
+    bool cacheHit = false; // 网格来自缓存
+};
+
+// 由输入源收集转换任务，输出文件放在 outputDir 下 (与输入同名，扩展名为 .obj)。输入源可以是:
+//   目录             其中所有扩展名为 .ply 的文件 (不递归)
+//   通配符模式       如 tiles/*.ply，支持文件名中的 * 和 ?
+//   清单文件         每行一个输入路径，可用制表符分隔后跟输出路径 (相对路径相对于 outputDir)；
+//                    空行和以 # 开头的行被忽略
+bool collectBatchJobs(const std::string& source, const std::string& outputDir, std::vector<BatchJob>& jobs);
+
+// 转换全部任务，results[i] 对应 jobs[i]。
+// 大文件依次转换，每个文件使用全部线程；小文件按大小从大到小由线程池动态领取，每个文件单线程转换，
+// 使大量小文件和少数大文件都能让所有线程保持忙碌。输出文件与之前的任务相同的任务不转换，报告为失败。
+std::vector<BatchResult> runBatch(const std::vector<BatchJob>& jobs, const BatchOptions& options);
+
+// 输出每个文件的结果与汇总，返回失败的文件数
+size_t printBatchSummary(std::ostream& out, const std::vector<BatchJob>& jobs, const std::vector<BatchResult>& results);
@@ -0,0 +1,42 @@
+﻿// Converter.cpp : 读取器、写出器与转换器对象
+//
+
+#include "Converter.h"
+
+using namespace std;
+
+bool PlyMeshReader::readFile(const string& path) {
+    return readPLY(path, mesh_, has_normals_, has_colors_, has_texCoords_, options_);
+}
+
+bool PlyMeshReader::readMemory(const void* data, size_t size) {
+    return readPLYMemory(data, size, mesh_, has_normals_, has_colors_, has_texCoords_, options_);
+}
+
+bool ObjMeshWriter::write(const Mesh& mesh, bool has_normals, bool has_colors, bool has_texCoords, OutputSink& sink) const {
+    const bool ok = writeOBJ(sink, mesh, has_normals, has_colors, has_texCoords, options_);
+    return sink.finish() && ok;
+}
+
+bool ObjMeshWriter::write(const PlyMeshReader& reader, OutputSink& sink) const {
+    return write(reader.mesh(), reader.hasNormals(), reader.hasColors(), reader.hasTexCoords(), sink);
+}
+
+bool ObjMeshWriter::write(const PlyMeshReader& reader, string& out) const {
+    out.clear();
+    StringSink sink(out);
+    return write(reader, sink);
+}
+
+bool PlyToObjConverter::convert(const void* data, size_t size, OutputSink& sink) {
+    return reader_.readMemory(data, size) && writer_.write(reader_, sink);
+}
+
+bool PlyToObjConverter::convert(const void* data, size_t size, const CallbackSink::Callback& callback) {
+    CallbackSink sink(callback);
+    return convert(data, size, sink);
+}
+
+bool PlyToObjConverter::convert(const void* data, size_t size, string& out) {
+    return reader_.readMemory(data, size) && writer_.write(reader_, out);
+}
@@ -0,0 +1,76 @@
+﻿// Converter.h : 供长期运行的服务嵌入使用的读取器、写出器与转换器对象
+//
+// 对象保存解码后的网格、解码计划所需的临时缓冲区与输出块缓冲区，同一个对象反复转换时复用已有的容量，
+// 不再为每次调用重新分配。对象之间不共享状态 (也不使用全局状态)，不同线程可以各自持有对象同时转换；
+// 同一个对象同一时刻只能在一个线程上使用。
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "Mesh.h"
+#include "ObjWriter.h"
+#include "OutputSink.h"
+#include "PlyReader.h"
+
+// 读取PLY到内部网格。字节源可以是文件 (普通文件内存映射，也支持压缩文件与 "-") 或内存缓冲区。
+class PlyMeshReader {
+public:
+    explicit PlyMeshReader(const PlyReadOptions& options = PlyReadOptions()) : options_(options) {}
+
+    PlyReadOptions& options() { return options_; }
+    const PlyReadOptions& options() const { return options_; }
+
+    bool readFile(const std::string& path);
+    // data 为完整的PLY文件 (含文件头)，读取期间必须有效；调用方映射的区域或请求内容都可以直接传入
+    bool readMemory(const void* data, size_t size);
+
+    // 最近一次成功读取的结果。网格可以被调用方修改 (如焊接)，下次读取时被覆盖。
+    Mesh& mesh() { return mesh_; }
+    const Mesh& mesh() const { return mesh_; }
+    bool hasNormals() const { return has_normals_; }
+    bool hasColors() const { return has_colors_; }
+    bool hasTexCoords() const { return has_texCoords_; }
+
+private:
+    PlyReadOptions options_;
+    Mesh mesh_;
+    bool has_normals_ = false, has_colors_ = false, has_texCoords_ = false;
+};
+
+// 把网格格式化为OBJ文本交给输出。输出块缓冲区在同一线程上的多次写出之间保留。
+class ObjMeshWriter {
+public:
+    explicit ObjMeshWriter(const ObjWriteOptions& options = ObjWriteOptions()) : options_(options) {}
+
+    ObjWriteOptions& options() { return options_; }
+    const ObjWriteOptions& options() const { return options_; }
+
+    // 写出后调用 sink.finish()。options.compression 不起作用。
+    bool write(const Mesh& mesh, bool has_normals, bool has_colors, bool has_texCoords, OutputSink& sink) const;
+    bool write(const PlyMeshReader& reader, OutputSink& sink) const;
+    // 把OBJ文本写入 out (先清空，保留容量)
+    bool write(const PlyMeshReader& reader, std::string& out) const;
+
+private:
+    ObjWriteOptions options_;
+};
+
+// 读取内存中的PLY并写出OBJ，不经过文件系统
+class PlyToObjConverter {
+public:
+    PlyToObjConverter(const PlyReadOptions& readOptions = PlyReadOptions(),
+        const ObjWriteOptions& writeOptions = ObjWriteOptions())
+        : reader_(readOptions), writer_(writeOptions) {}
+
+    PlyMeshReader& reader() { return reader_; }
+    ObjMeshWriter& writer() { return writer_; }
+
+    bool convert(const void* data, size_t size, OutputSink& sink);
+    bool convert(const void* data, size_t size, const CallbackSink::Callback& callback);
+    bool convert(const void* data, size_t size, std::string& out);
+
+private:
+    PlyMeshReader reader_;
+    ObjMeshWriter writer_;
+};
@@ -0,0 +1,339 @@
+﻿// InputStream.cpp : 后台线程读取与解压，经环形缓冲区交给解析线程
+//
+// 后台线程把 (解压后的) 数据依次填入 kBlockCount 个固定大小的块，解析线程的 streambuf
+// 逐块读取，读完的块还给后台线程复用。内存占用固定，解压与解析并行进行。
+
+#include "InputStream.h"
+#include "OutputSink.h"
+#include "Profile.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+#ifdef PLYTOOBJ_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PLYTOOBJ_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+const size_t kBlockCount = 4;
+const size_t kBlockBytes = 1 << 20;
+const size_t kRawBytes = 1 << 20; // 压缩数据的读取缓冲区
+
+// 原始 (可能是压缩的) 输入
+struct RawInput {
+    istream& in;
+    vector<char> buffer;
+    size_t pos = 0, end = 0;
+
+    explicit RawInput(istream& input) : in(input), buffer(kRawBytes) {}
+
+    // 缓冲区读完时读入下一段，返回 false 表示输入已结束
+    bool fill() {
+        if (pos < end) return true;
+        pos = end = 0;
+        if (!in) return false;
+        ProfileScope scope(ProfileStage::InputRead);
+        in.read(buffer.data(), buffer.size());
+        end = static_cast<size_t>(in.gcount());
+        profileAdd(ProfileCounter::BytesRead, end);
+        return end > 0;
+    }
+    bool failed() const { return in.bad(); }
+};
+
+// 解压器：read 写出至多 size 字节，返回 0 表示数据结束，出错时 error 非空
+class Decoder {
+public:
+    virtual ~Decoder() = default;
+    virtual size_t read(RawInput& raw, char* out, size_t size, string& error) = 0;
+};
+
+class PassThroughDecoder : public Decoder {
+public:
+    size_t read(RawInput& raw, char* out, size_t size, string& error) override {
+        if (!raw.fill()) {
+            if (raw.failed()) error = "读取输入失败";
+            return 0;
+        }
+        const size_t n = std::min(size, raw.end - raw.pos);
+        memcpy(out, raw.buffer.data() + raw.pos, n);
+        raw.pos += n;
+        return n;
+    }
+};
+
+#ifdef PLYTOOBJ_WITH_ZLIB
+class GzipDecoder : public Decoder {
+public:
+    GzipDecoder() {
+        memset(&stream_, 0, sizeof(stream_));
+        ok_ = inflateInit2(&stream_, 15 + 32) == Z_OK; // 加 32 自动识别 gzip / zlib 文件头
+    }
+    ~GzipDecoder() override {
+        if (ok_) inflateEnd(&stream_);
+    }
+    bool valid() const { return ok_; }
+
+    size_t read(RawInput& raw, char* out, size_t size, string& error) override {
+        size_t produced = 0;
+        while (produced < size && !ended_) {
+            if (!raw.fill()) {
+                if (raw.failed()) error = "读取输入失败";
+                else if (started_) error = "gzip 数据不完整";
+                ended_ = true;
+                break;
+            }
+            stream_.next_in = reinterpret_cast<Bytef*>(raw.buffer.data() + raw.pos);
+            stream_.avail_in = static_cast<uInt>(raw.end - raw.pos);
+            stream_.next_out = reinterpret_cast<Bytef*>(out + produced);
+            stream_.avail_out = static_cast<uInt>(size - produced);
+            started_ = true;
+            const int ret = inflate(&stream_, Z_NO_FLUSH);
+            raw.pos = raw.end - stream_.avail_in;
+            produced = size - stream_.avail_out;
+            if (ret == Z_STREAM_END) {
+                // 多个 gzip 成员首尾相接时继续解压下一个
+                inflateReset(&stream_);
+                started_ = false;
+            }
+            else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                error = string("gzip 解压失败: ") + (stream_.msg ? stream_.msg : "数据损坏");
+                ended_ = true;
+            }
+        }
+        return produced;
+    }
+
+private:
+    z_stream stream_;
+    bool ok_ = false;
+    bool started_ = false; // 当前成员已开始解压但尚未结束
+    bool ended_ = false;
+};
+#endif
+
+#ifdef PLYTOOBJ_WITH_ZSTD
+class ZstdDecoder : public Decoder {
+public:
+    ZstdDecoder() : context_(ZSTD_createDStream()) {}
+    ~ZstdDecoder() override {
+        ZSTD_freeDStream(context_);
+    }
+    bool valid() const { return context_ != nullptr; }
+
+    size_t read(RawInput& raw, char* out, size_t size, string& error) override {
+        ZSTD_outBuffer output = { out, size, 0 };
+        while (output.pos < output.size && !ended_) {
+            if (!raw.fill()) {
+                if (raw.failed()) error = "读取输入失败";
+                else if (pending_) error = "zstd 数据不完整";
+                ended_ = true;
+                break;
+            }
+            ZSTD_inBuffer input = { raw.buffer.data(), raw.end, raw.pos };
+            const size_t ret = ZSTD_decompressStream(context_, &output, &input);
+            raw.pos = input.pos;
+            if (ZSTD_isError(ret)) {
+                error = string("zstd 解压失败: ") + ZSTD_getErrorName(ret);
+                ended_ = true;
+            }
+            else pending_ = ret != 0; // 0 表示一帧结束，后续输入中可能还有下一帧
+        }
+        return output.pos;
+    }
+
+private:
+    ZSTD_DStream* context_;
+    bool pending_ = false;
+    bool ended_ = false;
+};
+#endif
+
+// 后台线程与解析线程之间的环形缓冲区，同时作为解析线程读取用的 streambuf
+struct InputStream::Pipeline : public streambuf {
+    unique_ptr<istream> source;  // 原始输入 (文件或标准输入)
+    RawInput raw;
+    unique_ptr<Decoder> decoder;
+
+    vector<vector<char>> blocks;
+    vector<size_t> blockSizes;
+    size_t readIndex = 0, writeIndex = 0, filled = 0; // filled: 已填满而未还回的块数
+    bool producerDone = false, closing = false, reported = false;
+    bool holdingBlock = false; // 解析线程正在读取 readIndex 块
+    string error;
+    mutex lock;
+    condition_variable blockFilled, blockFreed;
+    thread worker;
+
+    Pipeline(unique_ptr<istream> input, istream& in, unique_ptr<Decoder> dec)
+        : source(std::move(input)), raw(in), decoder(std::move(dec)),
+          blocks(kBlockCount, vector<char>(kBlockBytes)), blockSizes(kBlockCount, 0) {}
+
+    ~Pipeline() override {
+        {
+            lock_guard<mutex> guard(lock);
+            closing = true;
+            blockFreed.notify_all();
+        }
+        if (worker.joinable()) worker.join();
+    }
+
+    void start() {
+        worker = thread([this] { produce(); });
+    }
+
+    void produce() {
+        for (;;) {
+            size_t index;
+            {
+                unique_lock<mutex> guard(lock);
+                // filled 包括解析线程正在读取的块，写入位置不会覆盖它
+                blockFreed.wait(guard, [this] { return closing || filled < kBlockCount; });
+                if (closing) break;
+                index = writeIndex;
+            }
+            vector<char>& block = blocks[index];
+            size_t size = 0;
+            string blockError;
+            ProfileScope scope(ProfileStage::Decompress);
+            while (size < block.size()) {
+                const size_t n = decoder->read(raw, block.data() + size, block.size() - size, blockError);
+                if (n == 0) break;
+                size += n;
+            }
+            lock_guard<mutex> guard(lock);
+            if (size > 0) {
+                blockSizes[index] = size;
+                writeIndex = (writeIndex + 1) % kBlockCount;
+                ++filled;
+            }
+            if (size < block.size()) {
+                error = blockError;
+                producerDone = true;
+            }
+            blockFilled.notify_one();
+            if (producerDone) break;
+        }
+        lock_guard<mutex> guard(lock);
+        producerDone = true;
+        blockFilled.notify_one();
+    }
+
+    int_type underflow() override {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+        unique_lock<mutex> guard(lock);
+        if (holdingBlock) {
+            holdingBlock = false;
+            --filled;
+            readIndex = (readIndex + 1) % kBlockCount;
+            blockFreed.notify_one();
+        }
+        blockFilled.wait(guard, [this] { return filled > 0 || producerDone; });
+        if (filled == 0) {
+            // 在解析线程上报告错误，保证与后续的解析错误信息顺序一致
+            if (!error.empty() && !reported) {
+                cerr << "错误: " << error << endl;
+                reported = true;
+            }
+            setg(nullptr, nullptr, nullptr);
+            return traits_type::eof();
+        }
+        holdingBlock = true;
+        char* data = blocks[readIndex].data();
+        setg(data, data, data + blockSizes[readIndex]);
+        return traits_type::to_int_type(*gptr());
+    }
+};
+
+InputStream::InputStream() = default;
+InputStream::~InputStream() = default;
+
+istream& InputStream::stream() {
+    return *file_;
+}
+
+bool InputStream::open(const string& path) {
+    pipeline_.reset();
+    file_.reset();
+    plainFile_ = false;
+
+    unique_ptr<istream> source;
+    istream* in = nullptr;
+    if (path == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        in = &cin;
+    }
+    else {
+        source.reset(new ifstream(path, ios::in | ios::binary));
+        if (!static_cast<ifstream&>(*source).is_open()) {
+            cerr << "错误: 无法打开PLY文件 " << path << endl;
+            return false;
+        }
+        in = source.get();
+    }
+
+    // 先读开头几个字节按魔数识别压缩格式，不看扩展名：魔数不符的按未压缩文件读取
+    char head[4];
+    in->read(head, sizeof(head));
+    const size_t headBytes = static_cast<size_t>(in->gcount());
+    static const unsigned char kGzipMagic[] = { 0x1f, 0x8b };
+    static const unsigned char kZstdMagic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+    Compression method = Compression::None;
+    if (headBytes >= 2 && memcmp(head, kGzipMagic, 2) == 0) method = Compression::Gzip;
+    else if (headBytes >= 4 && memcmp(head, kZstdMagic, 4) == 0) method = Compression::Zstd;
+
+    if (method == Compression::None && source) {
+        // 未压缩的文件：能定位回开头就直接读取 (命名管道等不能定位的输入仍经后台线程读取)
+        in->clear();
+        if (in->seekg(0)) {
+            file_ = std::move(source);
+            plainFile_ = true;
+            return true;
+        }
+        in->clear();
+    }
+
+    unique_ptr<Decoder> decoder;
+    if (method == Compression::None) decoder.reset(new PassThroughDecoder());
+#ifdef PLYTOOBJ_WITH_ZLIB
+    if (method == Compression::Gzip) {
+        unique_ptr<GzipDecoder> gzip(new GzipDecoder());
+        if (gzip->valid()) decoder = std::move(gzip);
+    }
+#endif
+#ifdef PLYTOOBJ_WITH_ZSTD
+    if (method == Compression::Zstd) {
+        unique_ptr<ZstdDecoder> zstd(new ZstdDecoder());
+        if (zstd->valid()) decoder = std::move(zstd);
+    }
+#endif
+    if (!decoder) {
+        cerr << "错误: 无法读取 " << (method == Compression::Gzip ? "gzip" : "zstd") << " 压缩的PLY文件 "
+            << path << (compressionAvailable(method) ? " (初始化失败)" : " (编译时未启用)") << endl;
+        return false;
+    }
+
+    pipeline_.reset(new Pipeline(std::move(source), *in, std::move(decoder)));
+    memcpy(pipeline_->raw.buffer.data(), head, headBytes); // 已读出的开头字节
+    pipeline_->raw.end = headBytes;
+    pipeline_->start();
+    file_.reset(new istream(pipeline_.get()));
+    return true;
+}
@@ -0,0 +1,33 @@
+﻿// InputStream.h : PLY输入流 (普通文件、标准输入或 gzip / zstd 压缩文件)
+//
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <string>
+
+// 打开PLY输入。路径为 "-" 时读取标准输入。
+// 压缩文件按文件开头的魔数 (gzip / zstd) 识别，在后台线程上解压到环形缓冲区，
+// stream() 从缓冲区读取解压后的数据；管道和标准输入也经同一后台线程读取。
+// 这类输入不能定位 (seek) 也不能内存映射，调用方跳过数据时只能读出后丢弃。
+class InputStream {
+public:
+    InputStream();
+    ~InputStream();
+
+    InputStream(const InputStream&) = delete;
+    InputStream& operator=(const InputStream&) = delete;
+
+    // 打开失败时输出错误并返回 false
+    bool open(const std::string& path);
+
+    std::istream& stream();
+    // 未压缩的普通文件：可以定位，也可以内存映射
+    bool isPlainFile() const { return plainFile_; }
+
+private:
+    struct Pipeline;
+    std::unique_ptr<std::istream> file_;     // 普通文件
+    std::unique_ptr<Pipeline> pipeline_;     // 后台线程读取 / 解压
+    bool plainFile_ = false;
+};
@@ -0,0 +1,123 @@
+﻿// MappedFile.cpp : MappedFile 的平台相关实现
+//
+
+#include "MappedFile.h"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    // 空文件无法映射；超过地址空间的文件 (Win32 构建) 也无法整体映射
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 ||
+        static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (mappingHandle_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle_));
+        mappingHandle_ = nullptr;
+    }
+    if (fileHandle_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(fileHandle_));
+        fileHandle_ = nullptr;
+    }
+    size_ = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    // 空文件无法映射
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 ||
+        static_cast<uint64_t>(st.st_size) > SIZE_MAX) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t length = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // 映射建立后文件描述符即可关闭
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    // 顶点和面数据按顺序解码，提示内核积极预读
+    madvise(addr, length, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const char*>(addr);
+    size_ = length;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+    }
+    size_ = 0;
+}
+
+#endif
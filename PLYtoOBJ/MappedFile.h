@@ -0,0 +1,32 @@
+﻿// MappedFile.h : 只读内存映射文件 (Linux/POSIX 使用 mmap, Windows 使用 MapViewOfFile)
+//
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// 将整个文件以只读方式映射到内存。映射失败时 isOpen() 返回 false，
+// 调用方应回退到普通的流式读取。
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;    // HANDLE
+    void* mappingHandle_ = nullptr; // HANDLE
+#endif
+};
@@ -0,0 +1,121 @@
+﻿// Mesh.h : 网格数据结构 (按属性分开存储的顶点数组与三角形)
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// 自定义二维向量结构 (用于纹理坐标)
+struct Vec2 {
+    float u, v;
+    Vec2(float u = 0.0f, float v = 0.0f) : u(u), v(v) {}
+};
+
+// 自定义三维向量结构
+struct Vec3 {
+    float x, y, z;
+    Vec3(float x = 0.0f, float y = 0.0f, float z = 0.0f) : x(x), y(y), z(z) {}
+};
+
+// 网格内部的顶点索引类型。默认32位，顶点数超过 2^31 - 1 的网格需要定义 PLYTOOBJ_INDEX_64 编译。
+#ifdef PLYTOOBJ_INDEX_64
+typedef int64_t MeshIndex;
+#else
+typedef int32_t MeshIndex;
+#endif
+
+// MeshIndex 能表示的最大顶点数
+const int64_t kMaxMeshVertices = std::numeric_limits<MeshIndex>::max();
+
+// 三角形面结构（存储三个顶点索引）
+struct Triangle {
+    MeshIndex v0, v1, v2;
+};
+
+// 多边形面，按 CSR 形式连续存储：第 f 个面的顶点索引为 indices[offsets[f], offsets[f + 1])。
+// 没有面时 offsets 为空，否则 offsets[0] == 0 且共有 面数 + 1 项。每个面至少有3个顶点。
+struct PolygonFaces {
+    std::vector<size_t> offsets;
+    std::vector<MeshIndex> indices;
+
+    size_t faceCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    // 扇形三角化后的三角形数
+    size_t triangleCount() const { return indices.size() - 2 * faceCount(); }
+    bool empty() const { return offsets.empty(); }
+    void clear() {
+        offsets.clear();
+        indices.clear();
+    }
+    // 结束一个面：indices 中上一个面之后追加的索引组成新面
+    void closeFace() {
+        if (offsets.empty()) offsets.push_back(0);
+        offsets.push_back(indices.size());
+    }
+};
+
+// 网格中存在的可选顶点属性
+const uint8_t kPresenceNormal = 1;
+const uint8_t kPresenceColor = 2;
+const uint8_t kPresenceTexCoord = 4;
+const uint8_t kPresenceAll = kPresenceNormal | kPresenceColor | kPresenceTexCoord;
+
+// 顶点属性数组的写入视图：各属性数组中第一个待写顶点的位置，未分配的属性为 nullptr
+struct VertexStreams {
+    Vec3* positions;
+    Vec3* normals;
+    Vec3* colors;
+    Vec2* texCoords;
+};
+
+// 网格数据：每种顶点属性各自连续存储 (SoA)。
+// 法线、颜色和纹理坐标只在文件声明了对应属性时分配，长度与 positions 相同；presence 记录已分配的属性。
+// 面默认三角化后存入 triangles；读取时要求保留多边形则存入 polygons，此时 triangles 为空。
+struct Mesh {
+    std::vector<Vec3> positions;
+    std::vector<Vec3> normals;
+    std::vector<Vec3> colors; // 存储为 0.0f - 1.0f 的浮点数
+    std::vector<Vec2> texCoords;
+    std::vector<Triangle> triangles;
+    PolygonFaces polygons;
+    uint8_t presence = 0; // kPresence* 标志
+
+    size_t vertexCount() const { return positions.size(); }
+    bool hasPolygons() const { return !polygons.empty(); }
+    // OBJ中的面数：保留多边形时为多边形数，否则为三角形数
+    size_t faceCount() const { return hasPolygons() ? polygons.faceCount() : triangles.size(); }
+    bool hasNormals() const { return (presence & kPresenceNormal) != 0; }
+    bool hasColors() const { return (presence & kPresenceColor) != 0; }
+    bool hasTexCoords() const { return (presence & kPresenceTexCoord) != 0; }
+
+    // 每个顶点占用的字节数
+    static size_t vertexBytes(uint8_t attributes) {
+        return sizeof(Vec3) * (1 + ((attributes & kPresenceNormal) ? 1 : 0) + ((attributes & kPresenceColor) ? 1 : 0)) +
+            ((attributes & kPresenceTexCoord) ? sizeof(Vec2) : 0);
+    }
+
+    // 重置为 count 个默认顶点，只分配 attributes 中的属性。已有的容量会被复用。
+    void resetVertices(size_t count, uint8_t attributes) {
+        presence = attributes;
+        positions.assign(count, Vec3());
+        normals.assign(hasNormals() ? count : 0, Vec3());
+        colors.assign(hasColors() ? count : 0, Vec3());
+        texCoords.assign(hasTexCoords() ? count : 0, Vec2());
+    }
+
+    // 清空所有面，保留已分配的容量
+    void clearFaces() {
+        triangles.clear();
+        polygons.clear();
+    }
+
+    VertexStreams streams(size_t first = 0) {
+        return {
+            positions.data() + first,
+            hasNormals() ? normals.data() + first : nullptr,
+            hasColors() ? colors.data() + first : nullptr,
+            hasTexCoords() ? texCoords.data() + first : nullptr
+        };
+    }
+};
@@ -0,0 +1,244 @@
+﻿// MeshBinary.cpp : 二进制网格文件的读写
+//
+
+#include "MeshBinary.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>      // for std::rename, std::remove
+#include <cstring>
+#include <atomic>
+#include <thread>
+
+#include "MappedFile.h"
+#include "Profile.h"
+
+using namespace std;
+
+const char kMeshBinaryMagic[8] = { 'P', 'L', 'Y', 'M', 'E', 'S', 'H', '\0' };
+
+// 数组直接在内存与文件之间复制，因此只支持小端系统
+bool hostIsLittleEndian() {
+    const uint16_t one = 1;
+    unsigned char first;
+    memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// 能无损保存所有三角形索引的最窄宽度
+uint32_t meshIndexBytes(const vector<Triangle>& triangles) {
+    int64_t lowest = 0, highest = 0;
+    for (const Triangle& t : triangles) {
+        lowest = std::min<int64_t>(lowest, std::min({ t.v0, t.v1, t.v2 }));
+        highest = std::max<int64_t>(highest, std::max({ t.v0, t.v1, t.v2 }));
+    }
+    if (lowest >= 0 && highest <= UINT16_MAX) return sizeof(uint16_t);
+    if (lowest >= INT32_MIN && highest <= INT32_MAX) return sizeof(int32_t);
+    return sizeof(int64_t);
+}
+
+// 按文件中的索引宽度调用 f(Stored())
+template<typename F>
+bool withStoredIndexType(uint32_t indexBytes, F&& f) {
+    switch (indexBytes) {
+    case sizeof(uint16_t): return f(uint16_t());
+    case sizeof(int32_t): return f(int32_t());
+    case sizeof(int64_t): return f(int64_t());
+    default: return false;
+    }
+}
+
+// 确定每个数组的偏移和文件总大小
+MeshBinaryHeader planMeshBinary(size_t vertexCount, size_t triangleCount, uint8_t attributes, uint32_t indexBytes) {
+    MeshBinaryHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, kMeshBinaryMagic, sizeof(h.magic));
+    h.version = kMeshBinaryVersion;
+    h.headerBytes = sizeof(MeshBinaryHeader);
+    h.vertexCount = vertexCount;
+    h.triangleCount = triangleCount;
+    h.attributes = attributes;
+    h.indexBytes = indexBytes;
+    h.alignment = kMeshBinaryAlignment;
+
+    uint64_t offset = alignUp(sizeof(MeshBinaryHeader), kMeshBinaryAlignment);
+    auto place = [&offset](uint64_t bytes) {
+        const uint64_t at = offset;
+        offset = alignUp(offset + bytes, kMeshBinaryAlignment);
+        return at;
+    };
+    h.positionsOffset = place(vertexCount * sizeof(Vec3));
+    if (attributes & kPresenceNormal) h.normalsOffset = place(vertexCount * sizeof(Vec3));
+    if (attributes & kPresenceColor) h.colorsOffset = place(vertexCount * sizeof(Vec3));
+    if (attributes & kPresenceTexCoord) h.texCoordsOffset = place(vertexCount * sizeof(Vec2));
+    h.indicesOffset = place(triangleCount * 3 * static_cast<uint64_t>(indexBytes));
+    h.fileBytes = offset;
+    return h;
+}
+
+// 写入一个数组，文件中缺少该属性时写入 count 个默认值
+template<typename T>
+bool writeArray(ofstream& out, uint64_t offset, const vector<T>& values, size_t count, const T& fallback) {
+    out.seekp(static_cast<streamoff>(offset));
+    if (!values.empty()) {
+        out.write(reinterpret_cast<const char*>(values.data()), static_cast<streamsize>(count * sizeof(T)));
+        return static_cast<bool>(out);
+    }
+    const vector<T> block(std::min<size_t>(count, 1 << 16), fallback);
+    for (size_t done = 0; done < count; done += block.size()) {
+        const size_t n = std::min(block.size(), count - done);
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<streamsize>(n * sizeof(T)));
+    }
+    return static_cast<bool>(out);
+}
+
+// 写入三角形索引，宽度与 MeshIndex 不同时分块转换
+template<typename Stored>
+bool writeIndices(ofstream& out, uint64_t offset, const vector<Triangle>& triangles) {
+    out.seekp(static_cast<streamoff>(offset));
+    if (sizeof(Stored) == sizeof(MeshIndex)) {
+        out.write(reinterpret_cast<const char*>(triangles.data()), static_cast<streamsize>(triangles.size() * sizeof(Triangle)));
+        return static_cast<bool>(out);
+    }
+    vector<Stored> block;
+    const size_t kBlockTriangles = 1 << 16;
+    for (size_t done = 0; done < triangles.size(); done += kBlockTriangles) {
+        const size_t n = std::min(kBlockTriangles, triangles.size() - done);
+        block.resize(n * 3);
+        for (size_t t = 0; t < n; ++t) {
+            const Triangle& tri = triangles[done + t];
+            block[t * 3] = static_cast<Stored>(tri.v0);
+            block[t * 3 + 1] = static_cast<Stored>(tri.v1);
+            block[t * 3 + 2] = static_cast<Stored>(tri.v2);
+        }
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<streamsize>(block.size() * sizeof(Stored)));
+    }
+    return static_cast<bool>(out);
+}
+
+// 读取三角形索引，宽度与 MeshIndex 不同时逐个转换
+template<typename Stored>
+void readIndices(const char* data, vector<Triangle>& triangles) {
+    if (sizeof(Stored) == sizeof(MeshIndex)) {
+        if (!triangles.empty()) memcpy(triangles.data(), data, triangles.size() * sizeof(Triangle));
+        return;
+    }
+    for (size_t t = 0; t < triangles.size(); ++t) {
+        Stored v[3];
+        memcpy(v, data + t * sizeof(v), sizeof(v));
+        triangles[t] = { static_cast<MeshIndex>(v[0]), static_cast<MeshIndex>(v[1]), static_cast<MeshIndex>(v[2]) };
+    }
+}
+
+bool writeMeshBinary(const string& path, const Mesh& mesh, uint8_t attributes, uint8_t sourceFlags, uint64_t key) {
+    if (!hostIsLittleEndian()) {
+        cerr << "错误: 二进制网格文件只支持小端系统" << endl;
+        return false;
+    }
+    MeshBinaryHeader h = planMeshBinary(mesh.vertexCount(), mesh.triangles.size(), attributes, meshIndexBytes(mesh.triangles));
+    h.sourceFlags = sourceFlags;
+    h.key = key;
+
+    // 同一路径可能同时被多个线程或进程写入，临时文件名需要唯一
+    static std::atomic<unsigned> serial(0);
+    const string tempPath = path + ".tmp" + to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) % 100000) +
+        "_" + to_string(serial++);
+    {
+        ofstream out(tempPath, ios::out | ios::binary | ios::trunc);
+        if (!out.is_open()) {
+            cerr << "错误: 无法创建二进制网格文件 " << tempPath << endl;
+            return false;
+        }
+        ProfileScope scope(ProfileStage::Write);
+        static_assert(sizeof(Triangle) == 3 * sizeof(MeshIndex), "Triangle 必须是三个紧密排列的索引");
+        const size_t n = mesh.vertexCount();
+        bool ok = static_cast<bool>(out.write(reinterpret_cast<const char*>(&h), sizeof(h)));
+        ok = ok && writeArray(out, h.positionsOffset, mesh.positions, n, Vec3());
+        if (ok && h.normalsOffset) ok = writeArray(out, h.normalsOffset, mesh.normals, n, Vec3(0.0f, 0.0f, 1.0f));
+        if (ok && h.colorsOffset) ok = writeArray(out, h.colorsOffset, mesh.colors, n, Vec3());
+        if (ok && h.texCoordsOffset) ok = writeArray(out, h.texCoordsOffset, mesh.texCoords, n, Vec2());
+        ok = ok && withStoredIndexType(h.indexBytes, [&](auto stored) {
+            return writeIndices<decltype(stored)>(out, h.indicesOffset, mesh.triangles);
+        });
+        // 把文件补齐到 fileBytes，使最后一个数组之后的对齐填充也存在
+        if (ok && h.fileBytes > 0) {
+            out.seekp(static_cast<streamoff>(h.fileBytes - 1));
+            ok = static_cast<bool>(out.put('\0'));
+        }
+        out.close();
+        if (!ok || out.fail()) {
+            cerr << "错误: 写入二进制网格文件 " << tempPath << " 失败" << endl;
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        profileAdd(ProfileCounter::BytesWritten, h.fileBytes);
+    }
+    std::remove(path.c_str()); // Windows 上 rename 不会覆盖已存在的文件
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        cerr << "错误: 无法把 " << tempPath << " 改名为 " << path << endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool writeMeshBinaryOutput(const string& path, const Mesh& mesh, bool has_normals, bool has_colors, bool has_texCoords) {
+    const uint8_t attributes = static_cast<uint8_t>((has_normals ? kPresenceNormal : 0) |
+        (has_colors && mesh.hasColors() ? kPresenceColor : 0) | (has_texCoords ? kPresenceTexCoord : 0));
+    const uint8_t sourceFlags = static_cast<uint8_t>((has_normals ? kPresenceNormal : 0) |
+        (has_colors ? kPresenceColor : 0) | (has_texCoords ? kPresenceTexCoord : 0));
+    return writeMeshBinary(path, mesh, attributes, sourceFlags);
+}
+
+bool readMeshBinary(const string& path, Mesh& mesh_out, uint8_t& sourceFlags, uint64_t expectedKey) {
+    ProfileScope scope(ProfileStage::BodyRead);
+    MappedFile mapped;
+    if (!hostIsLittleEndian() || !mapped.open(path) || mapped.size() < sizeof(MeshBinaryHeader)) return false;
+
+    MeshBinaryHeader h;
+    memcpy(&h, mapped.data(), sizeof(h));
+    if (memcmp(h.magic, kMeshBinaryMagic, sizeof(h.magic)) != 0 || h.version != kMeshBinaryVersion ||
+        h.headerBytes != sizeof(MeshBinaryHeader) || h.fileBytes != mapped.size() ||
+        (expectedKey != 0 && h.key != expectedKey)) {
+        return false;
+    }
+    // 比 MeshIndex 宽的索引 (64 位索引编译写出的文件) 无法读入，顶点数同理
+    if ((h.indexBytes != sizeof(uint16_t) && h.indexBytes != sizeof(int32_t) && h.indexBytes != sizeof(int64_t)) ||
+        h.indexBytes > sizeof(MeshIndex) || h.vertexCount > static_cast<uint64_t>(kMaxMeshVertices)) {
+        return false;
+    }
+    // 重新计算布局并与文件头比较，保证所有数组都在文件范围内
+    const MeshBinaryHeader expected = planMeshBinary(static_cast<size_t>(h.vertexCount), static_cast<size_t>(h.triangleCount),
+        static_cast<uint8_t>(h.attributes), h.indexBytes);
+    if (h.attributes > 7 || expected.fileBytes != h.fileBytes || expected.positionsOffset != h.positionsOffset ||
+        expected.normalsOffset != h.normalsOffset || expected.colorsOffset != h.colorsOffset ||
+        expected.texCoordsOffset != h.texCoordsOffset || expected.indicesOffset != h.indicesOffset) {
+        return false;
+    }
+
+    const size_t n = static_cast<size_t>(h.vertexCount);
+    mesh_out.clearFaces();
+    mesh_out.resetVertices(n, static_cast<uint8_t>(h.attributes));
+    auto copyArray = [&mapped](auto& values, uint64_t offset) {
+        if (!values.empty()) memcpy(values.data(), mapped.data() + offset, values.size() * sizeof(values[0]));
+    };
+    copyArray(mesh_out.positions, h.positionsOffset);
+    copyArray(mesh_out.normals, h.normalsOffset);
+    copyArray(mesh_out.colors, h.colorsOffset);
+    copyArray(mesh_out.texCoords, h.texCoordsOffset);
+    mesh_out.triangles.resize(static_cast<size_t>(h.triangleCount));
+    withStoredIndexType(h.indexBytes, [&](auto stored) {
+        readIndices<decltype(stored)>(mapped.data() + h.indicesOffset, mesh_out.triangles);
+        return true;
+    });
+    sourceFlags = static_cast<uint8_t>(h.sourceFlags);
+    profileAdd(ProfileCounter::BytesRead, h.fileBytes);
+    return true;
+}
@@ -0,0 +1,54 @@
+﻿// MeshBinary.h : 可直接内存映射的紧凑二进制网格格式
+//
+// 文件布局 (小端)：固定长度的 MeshBinaryHeader，之后是各属性数组和三角形索引，
+// 每个数组的起始偏移按 kMeshBinaryAlignment 对齐，未写入的属性偏移为 0：
+//   positions: float[3 * vertexCount]
+//   normals:   float[3 * vertexCount]
+//   colors:    float[3 * vertexCount] (0-1)
+//   texCoords: float[2 * vertexCount]
+//   indices:   index[3 * triangleCount]，宽度见 indexBytes
+// 写入时按索引的取值范围选择最窄的宽度：全部在 [0, 65535] 内为 uint16，在 int32 范围内为 int32，否则为 int64。
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Mesh.h"
+
+const uint32_t kMeshBinaryVersion = 1;
+const uint32_t kMeshBinaryAlignment = 64;
+
+// 固定长度的文件头，所有字段自然对齐，可直接从映射的内存中读取
+struct MeshBinaryHeader {
+    char magic[8];          // "PLYMESH" + '\0'
+    uint32_t version;       // kMeshBinaryVersion
+    uint32_t headerBytes;   // sizeof(MeshBinaryHeader)
+    uint64_t vertexCount;
+    uint64_t triangleCount;
+    uint32_t attributes;    // 已写入的可选属性 (kPresence* 标志)
+    uint32_t sourceFlags;   // 源文件声明的属性 (kPresence* 标志)，对应 readPLY 的 file_has_*
+    uint32_t indexBytes;    // 每个索引的字节数 (2、4 或 8)
+    uint32_t alignment;     // kMeshBinaryAlignment
+    uint64_t positionsOffset;
+    uint64_t normalsOffset;
+    uint64_t colorsOffset;
+    uint64_t texCoordsOffset;
+    uint64_t indicesOffset;
+    uint64_t fileBytes;     // 整个文件的字节数，用于检测截断
+    uint64_t key;           // 写入方定义的标识 (如网格缓存的键)，不使用时为 0
+};
+
+static_assert(sizeof(MeshBinaryHeader) == 104, "MeshBinaryHeader 的布局必须固定");
+
+// 把网格写为二进制文件。attributes 选择要写入的可选属性 (kPresence* 标志)，
+// 网格中不存在的属性按 writeOBJ 的约定填充默认值 (法线 0 0 1，颜色和纹理坐标为 0)。
+// 先写入临时文件再改名，读取方不会看到写了一半的文件。
+bool writeMeshBinary(const std::string& path, const Mesh& mesh, uint8_t attributes, uint8_t sourceFlags, uint64_t key = 0);
+
+// 与 writeOBJ 并列的输出目标，使用相同的 has_* 标志：has_normals / has_texCoords 时写入法线 / 纹理坐标流
+// (网格缺少时为默认值)，颜色流只在网格有颜色时写入，与 OBJ 的 v 行一致。
+bool writeMeshBinaryOutput(const std::string& path, const Mesh& mesh, bool has_normals, bool has_colors, bool has_texCoords);
+
+// 读取并校验二进制网格文件。expectedKey 不为 0 时要求文件头中的 key 与之相同。
+bool readMeshBinary(const std::string& path, Mesh& mesh_out, uint8_t& sourceFlags, uint64_t expectedKey = 0);
@@ -0,0 +1,153 @@
+﻿// MeshCache.cpp : 网格缓存的键计算、查找、写入与按最近使用时间淘汰
+//
+// 每个条目是缓存目录中的一个二进制网格文件，文件名为键的十六进制表示。
+// 命中时更新文件的修改时间，淘汰时按修改时间从旧到新删除。
+
+#include "MeshCache.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>      // for snprintf
+#include <cstring>
+#include <filesystem>
+
+#include "MappedFile.h"
+#include "MeshBinary.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// 解码结果的格式版本。解码行为变化 (会影响缓存中的网格) 时递增，使旧条目失效。
+const uint64_t kMeshCacheDecoderVersion = 1;
+const char* const kMeshCacheExtension = ".pmesh";
+
+inline uint64_t mixCacheHash(uint64_t h, uint64_t value) {
+    h ^= value + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    h *= 0xFF51AFD7ED558CCDull;
+    return h ^ (h >> 32);
+}
+
+// 快速的64位内容哈希：四路独立累加，每次处理 32 字节
+uint64_t hashBytes(const char* data, size_t size) {
+    uint64_t lanes[4] = { 0x243F6A8885A308D3ull, 0x13198A2E03707344ull, 0xA4093822299F31D0ull, 0x082EFA98EC4E6C89ull };
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int k = 0; k < 4; ++k) {
+            uint64_t word;
+            memcpy(&word, data + i + k * 8, sizeof(word));
+            lanes[k] = (lanes[k] ^ word) * 0x9E3779B97F4A7C15ull;
+            lanes[k] ^= lanes[k] >> 31;
+        }
+    }
+    uint64_t h = size;
+    for (uint64_t lane : lanes) h = mixCacheHash(h, lane);
+    for (; i < size; ++i) h = mixCacheHash(h, static_cast<unsigned char>(data[i]));
+    return h;
+}
+
+uint64_t hashString(const string& text) {
+    return hashBytes(text.data(), text.size());
+}
+
+// 缓存键。返回 0 表示无法确定 (如文件不存在)，此时不使用缓存。
+uint64_t meshCacheKey(const string& plyPath, bool hashContents) {
+    std::error_code ec;
+    const uintmax_t size = fs::file_size(plyPath, ec);
+    if (ec) return 0;
+    uint64_t key = mixCacheHash(kMeshCacheDecoderVersion, static_cast<uint64_t>(size));
+    if (hashContents) {
+        MappedFile mapped;
+        if (!mapped.open(plyPath)) return 0;
+        key = mixCacheHash(key, hashBytes(mapped.data(), mapped.size()));
+    }
+    else {
+        const fs::file_time_type mtime = fs::last_write_time(plyPath, ec);
+        if (ec) return 0;
+        fs::path absolute = fs::absolute(plyPath, ec);
+        if (ec) absolute = plyPath;
+        key = mixCacheHash(key, hashString(absolute.lexically_normal().string()));
+        key = mixCacheHash(key, static_cast<uint64_t>(mtime.time_since_epoch().count()));
+    }
+    return key == 0 ? 1 : key;
+}
+
+fs::path meshCachePath(const string& directory, uint64_t key) {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return fs::path(directory) / (string(name) + kMeshCacheExtension);
+}
+
+// 删除最久未使用的条目，直到总大小不超过上限。keep 是刚写入的条目，不删除。
+void evictMeshCache(const string& directory, uint64_t sizeLimitBytes, const fs::path& keep) {
+    struct Entry { fs::path path; fs::file_time_type time; uint64_t bytes; };
+    vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != kMeshCacheExtension || !it->is_regular_file(ec)) continue;
+        Entry e{ it->path(), it->last_write_time(ec), static_cast<uint64_t>(it->file_size(ec)) };
+        if (ec) continue;
+        total += e.bytes;
+        entries.push_back(e);
+    }
+    if (total <= sizeLimitBytes) return;
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (const Entry& e : entries) {
+        if (total <= sizeLimitBytes) break;
+        if (e.path == keep) continue;
+        // 其他进程可能正在读取该条目，删除失败时跳过
+        if (fs::remove(e.path, ec)) total -= e.bytes;
+    }
+}
+
+uint8_t presenceFlags(bool normals, bool colors, bool texCoords) {
+    return static_cast<uint8_t>((normals ? kPresenceNormal : 0) | (colors ? kPresenceColor : 0) | (texCoords ? kPresenceTexCoord : 0));
+}
+
+bool readPLYCached(const string& plyPath, Mesh& mesh_out,
+    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords,
+    const PlyReadOptions& readOptions, const MeshCacheOptions& cacheOptions, bool& cacheHit) {
+    cacheHit = false;
+    // 缓存条目只保存三角形，保留多边形时不使用缓存
+    uint64_t key = cacheOptions.directory.empty() || readOptions.keepPolygons
+        ? 0 : meshCacheKey(plyPath, cacheOptions.hashContents);
+    if (key != 0 && readOptions.attributes != kPresenceAll) {
+        // 只读取部分属性的网格单独缓存；读取全部属性时键不变，已有的条目仍然有效
+        key = mixCacheHash(key, readOptions.attributes);
+        if (key == 0) key = 1;
+    }
+    if (key == 0) {
+        return readPLY(plyPath, mesh_out, file_has_normals, file_has_colors, file_has_texCoords, readOptions);
+    }
+
+    const fs::path entry = meshCachePath(cacheOptions.directory, key);
+    std::error_code ec;
+    uint8_t sourceFlags = 0;
+    if (readMeshBinary(entry.string(), mesh_out, sourceFlags, key)) {
+        file_has_normals = (sourceFlags & kPresenceNormal) != 0;
+        file_has_colors = (sourceFlags & kPresenceColor) != 0;
+        file_has_texCoords = (sourceFlags & kPresenceTexCoord) != 0;
+        fs::last_write_time(entry, fs::file_time_type::clock::now(), ec); // 记录最近使用时间
+        cacheHit = true;
+        return true;
+    }
+
+    if (!readPLY(plyPath, mesh_out, file_has_normals, file_has_colors, file_has_texCoords, readOptions)) {
+        return false;
+    }
+    const uint64_t entryBytes = Mesh::vertexBytes(mesh_out.presence) * mesh_out.vertexCount() +
+        sizeof(Triangle) * mesh_out.triangles.size();
+    if (entryBytes > cacheOptions.sizeLimitBytes) return true; // 单个条目超过上限，不缓存
+
+    fs::create_directories(cacheOptions.directory, ec);
+    if (writeMeshBinary(entry.string(), mesh_out, mesh_out.presence,
+        presenceFlags(file_has_normals, file_has_colors, file_has_texCoords), key)) {
+        evictMeshCache(cacheOptions.directory, cacheOptions.sizeLimitBytes, entry);
+    }
+    else {
+        cerr << "警告: 无法写入网格缓存 " << entry.string() << endl;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+﻿// MeshCache.h : 解码后网格的磁盘缓存，重复转换同一个PLY时跳过解析
+//
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Mesh.h"
+#include "PlyReader.h"
+
+struct MeshCacheOptions {
+    std::string directory;                        // 缓存目录，为空表示不使用缓存
+    uint64_t sizeLimitBytes = uint64_t(4) << 30;  // 缓存目录的总大小上限，超出时删除最久未使用的条目
+    bool hashContents = false; // 键由文件内容的哈希决定 (需要读取整个文件)；默认由路径、大小和修改时间决定
+};
+
+// 与 readPLY 相同，但先在缓存中查找。未命中时读取PLY并把结果写入缓存 (二进制网格格式)。
+// cacheHit 返回是否从缓存中读取。缓存不可用时自动退回到直接读取，不影响结果。
+bool readPLYCached(const std::string& plyPath, Mesh& mesh_out,
+    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords,
+    const PlyReadOptions& readOptions, const MeshCacheOptions& cacheOptions, bool& cacheHit);
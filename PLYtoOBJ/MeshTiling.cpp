@@ -0,0 +1,322 @@
+﻿// MeshTiling.cpp : 空间分块输出
+//
+// 第一遍并行计算包围盒，第二遍并行求每个面的重心所在的格子，按格子计数排序得到各块的面列表；
+// 之后各块在工作线程上独立收集顶点、重新编号并写出，每块写完即释放。
+
+#include "MeshTiling.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+#include "ParallelChunks.h"
+#include "Profile.h"
+
+using namespace std;
+
+// 并行任务的粒度 (顶点或面的个数)
+const size_t kTileBlock = 1 << 16;
+const unsigned kMaxTileGrid = 1024;   // 每个轴的最大等分数
+const size_t kMaxTiles = 1 << 20;
+const uint32_t kNoTile = 0xFFFFFFFFu; // 无法确定位置的面
+
+bool parseTileGrid(const string& text, TileOptions& options) {
+    unsigned values[3];
+    size_t n = 0;
+    const char* p = text.c_str();
+    for (;;) {
+        char* end;
+        const unsigned long value = strtoul(p, &end, 10);
+        if (end == p || value == 0 || value > kMaxTileGrid) return false;
+        values[n++] = static_cast<unsigned>(value);
+        if (*end == '\0') break;
+        if ((*end != 'x' && *end != 'X') || n == 3) return false;
+        p = end + 1;
+    }
+    if (n == 2) return false;
+    const unsigned x = values[0], y = n == 3 ? values[1] : values[0], z = n == 3 ? values[2] : values[0];
+    if (static_cast<size_t>(x) * y * z > kMaxTiles) return false;
+    options.gridX = x;
+    options.gridY = y;
+    options.gridZ = z;
+    return true;
+}
+
+string tilePath(const string& objPath, unsigned x, unsigned y, unsigned z) {
+    const size_t slash = objPath.find_last_of("/\\");
+    const size_t nameStart = slash == string::npos ? 0 : slash + 1;
+    // 以点开头的文件名 (如 .obj) 不把开头的点当作扩展名
+    size_t dot = objPath.find('.', nameStart + 1);
+    if (dot == string::npos) dot = objPath.size();
+    return objPath.substr(0, dot) + "_" + to_string(x) + "_" + to_string(y) + "_" + to_string(z) + objPath.substr(dot);
+}
+
+// 所有有限顶点位置的包围盒，没有有限顶点时 lo > hi
+struct TileBounds {
+    Vec3 lo, hi;
+    TileBounds() : lo(numeric_limits<float>::infinity(), numeric_limits<float>::infinity(), numeric_limits<float>::infinity()),
+        hi(-numeric_limits<float>::infinity(), -numeric_limits<float>::infinity(), -numeric_limits<float>::infinity()) {}
+    void add(const Vec3& p) {
+        lo = Vec3(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+        hi = Vec3(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+    }
+};
+
+TileBounds computeBounds(const vector<Vec3>& positions, unsigned threadCount) {
+    const size_t blocks = (positions.size() + kTileBlock - 1) / kTileBlock;
+    vector<TileBounds> partial(blocks);
+    runParallel(blocks, threadCount, [&](size_t b) {
+        const size_t end = std::min(positions.size(), (b + 1) * kTileBlock);
+        for (size_t v = b * kTileBlock; v < end; ++v) partial[b].add(positions[v]);
+    });
+    TileBounds bounds;
+    for (const TileBounds& part : partial) {
+        bounds.add(part.lo);
+        bounds.add(part.hi);
+    }
+    return bounds;
+}
+
+// 坐标在一个轴上所在的格子。scale 为该轴的等分数除以包围盒的边长，边长为 0 时为 0。
+inline unsigned cellOf(float value, float lo, float scale, unsigned cells) {
+    const float t = (value - lo) * scale;
+    if (!(t > 0.0f)) return 0; // 包括 NaN
+    return t >= static_cast<float>(cells) ? cells - 1 : static_cast<unsigned>(t);
+}
+
+// 第 f 个面的顶点索引及个数。三角形的索引复制到 triangle 中。
+inline const MeshIndex* faceCorners(const Mesh& mesh, size_t f, MeshIndex (&triangle)[3], size_t& count) {
+    if (mesh.hasPolygons()) {
+        count = mesh.polygons.offsets[f + 1] - mesh.polygons.offsets[f];
+        return mesh.polygons.indices.data() + mesh.polygons.offsets[f];
+    }
+    const Triangle& t = mesh.triangles[f];
+    triangle[0] = t.v0;
+    triangle[1] = t.v1;
+    triangle[2] = t.v2;
+    count = 3;
+    return triangle;
+}
+
+inline unsigned popCount(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return static_cast<unsigned>((x * 0x0101010101010101ull) >> 56);
+}
+
+// 一块引用的顶点集合：[lowest, highest] 范围上的位图。局部序号为范围内排在它之前的已引用顶点数，
+// 因此块内顶点保持原顺序。内存与块的索引范围成正比，不需要与整个网格等长的重映射数组。
+// 范围的起点向下对齐到64，位图的字与整个网格的顶点位图的字一一对应。
+class TileVertexSet {
+public:
+    void reset(MeshIndex lowest, MeshIndex highest) {
+        lowest_ = lowest - lowest % 64;
+        const size_t words = static_cast<size_t>(highest - lowest_) / 64 + 1;
+        bits_.assign(words, 0);
+        rank_.assign(words, 0);
+    }
+    void add(MeshIndex v) {
+        const size_t bit = static_cast<size_t>(v - lowest_);
+        bits_[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    // 全部加入后调用，返回顶点数
+    size_t finish() {
+        size_t count = 0;
+        for (size_t w = 0; w < bits_.size(); ++w) {
+            rank_[w] = count;
+            count += popCount(bits_[w]);
+        }
+        return count;
+    }
+    MeshIndex local(MeshIndex v) const {
+        const size_t bit = static_cast<size_t>(v - lowest_);
+        const uint64_t below = (uint64_t(1) << (bit % 64)) - 1;
+        return static_cast<MeshIndex>(rank_[bit / 64] + popCount(bits_[bit / 64] & below));
+    }
+    // 按局部序号的顺序对每个顶点调用 f(原序号)
+    template<typename F>
+    void forEach(F&& f) const {
+        for (size_t w = 0; w < bits_.size(); ++w) {
+            for (uint64_t word = bits_[w], b = 0; word != 0; word >>= 1, ++b) {
+                if (word & 1) f(static_cast<size_t>(lowest_) + w * 64 + static_cast<size_t>(b));
+            }
+        }
+    }
+
+    // 把集合并入整个网格的顶点位图 (可在多个线程上同时调用)，返回此前不在其中的顶点数
+    size_t mergeInto(vector<std::atomic<uint64_t>>& all) const {
+        const size_t first = static_cast<size_t>(lowest_) / 64;
+        size_t added = 0;
+        for (size_t w = 0; w < bits_.size(); ++w) {
+            if (bits_[w] == 0) continue;
+            const uint64_t before = all[first + w].fetch_or(bits_[w], std::memory_order_relaxed);
+            added += popCount(bits_[w] & ~before);
+        }
+        return added;
+    }
+
+private:
+    MeshIndex lowest_ = 0;
+    vector<uint64_t> bits_;
+    vector<size_t> rank_; // 每个字之前的顶点数
+};
+
+bool writeOBJTiles(const string& objPath, const Mesh& mesh, bool has_normals, bool has_colors, bool has_texCoords,
+    const TileOptions& tiles, const ObjWriteOptions& options, TileStats& stats) {
+    stats = TileStats();
+    const size_t vertexCount = mesh.vertexCount();
+    const size_t faceCount = mesh.faceCount();
+    const unsigned gx = std::max(1u, tiles.gridX), gy = std::max(1u, tiles.gridY), gz = std::max(1u, tiles.gridZ);
+    const size_t tileCount = static_cast<size_t>(gx) * gy * gz;
+
+    // 1. 每个面的重心所在的块
+    ProfileScope scope(ProfileStage::Tile);
+    const TileBounds bounds = computeBounds(mesh.positions, tiles.threadCount);
+    auto scaleOf = [](float lo, float hi, unsigned cells) {
+        const float extent = hi - lo;
+        return extent > 0.0f && extent < numeric_limits<float>::infinity() ? static_cast<float>(cells) / extent : 0.0f;
+    };
+    const float sx = scaleOf(bounds.lo.x, bounds.hi.x, gx);
+    const float sy = scaleOf(bounds.lo.y, bounds.hi.y, gy);
+    const float sz = scaleOf(bounds.lo.z, bounds.hi.z, gz);
+
+    vector<uint32_t> tileOf(faceCount);
+    const size_t faceBlocks = (faceCount + kTileBlock - 1) / kTileBlock;
+    vector<size_t> dropped(faceBlocks, 0);
+    runParallel(faceBlocks, tiles.threadCount, [&](size_t b) {
+        const size_t end = std::min(faceCount, (b + 1) * kTileBlock);
+        MeshIndex triangle[3];
+        for (size_t f = b * kTileBlock; f < end; ++f) {
+            size_t n;
+            const MeshIndex* corners = faceCorners(mesh, f, triangle, n);
+            float cx = 0.0f, cy = 0.0f, cz = 0.0f;
+            bool valid = true;
+            for (size_t k = 0; k < n && valid; ++k) {
+                valid = corners[k] >= 0 && static_cast<size_t>(corners[k]) < vertexCount;
+                if (!valid) break;
+                const Vec3& p = mesh.positions[corners[k]];
+                cx += p.x; cy += p.y; cz += p.z;
+            }
+            if (!valid) {
+                tileOf[f] = kNoTile;
+                ++dropped[b];
+                continue;
+            }
+            const float inv = 1.0f / static_cast<float>(n);
+            const unsigned x = cellOf(cx * inv, bounds.lo.x, sx, gx);
+            const unsigned y = cellOf(cy * inv, bounds.lo.y, sy, gy);
+            const unsigned z = cellOf(cz * inv, bounds.lo.z, sz, gz);
+            tileOf[f] = static_cast<uint32_t>((static_cast<size_t>(z) * gy + y) * gx + x);
+        }
+    });
+    for (size_t d : dropped) stats.droppedFaces += d;
+    if (stats.droppedFaces > 0) {
+        cerr << "警告: " << stats.droppedFaces << " 个面包含超出范围的顶点索引，分块输出时已忽略" << endl;
+    }
+
+    // 2. 按块计数排序，块内保持面的原顺序
+    vector<size_t> tileStart(tileCount + 1, 0);
+    for (uint32_t t : tileOf) {
+        if (t != kNoTile) ++tileStart[t + 1];
+    }
+    for (size_t t = 0; t < tileCount; ++t) tileStart[t + 1] += tileStart[t];
+    vector<size_t> faceOrder(tileStart[tileCount]);
+    {
+        vector<size_t> cursor(tileStart.begin(), tileStart.end() - 1);
+        for (size_t f = 0; f < faceCount; ++f) {
+            if (tileOf[f] != kNoTile) faceOrder[cursor[tileOf[f]]++] = f;
+        }
+    }
+    vector<uint32_t>().swap(tileOf);
+    vector<uint32_t> nonEmpty;
+    for (size_t t = 0; t < tileCount; ++t) {
+        if (tileStart[t + 1] > tileStart[t]) nonEmpty.push_back(static_cast<uint32_t>(t));
+    }
+    scope.restart(ProfileStage::OutputWait);
+
+    // 3. 各块并行写出。块数少于线程数时剩余的线程分给各块的格式化和压缩。
+    const unsigned parallelTiles = static_cast<unsigned>(std::min<size_t>(std::max(1u, tiles.threadCount), std::max<size_t>(nonEmpty.size(), 1)));
+    ObjWriteOptions tileWrite = options;
+    tileWrite.threadCount = std::max(1u, options.threadCount / parallelTiles);
+    tileWrite.compression.threadCount = tileWrite.threadCount;
+    vector<size_t> tileVertices(nonEmpty.size(), 0);
+    // 被引用的顶点数 (各块顶点集合之并) 由各块的位图合并得到，每个顶点一位
+    vector<std::atomic<uint64_t>> referencedBits((vertexCount + 63) / 64);
+    std::atomic<size_t> referenced(0);
+    std::atomic<bool> failed(false);
+    runParallel(nonEmpty.size(), parallelTiles, [&](size_t job) {
+        if (failed.load(std::memory_order_relaxed)) return;
+        const uint32_t t = nonEmpty[job];
+        const size_t first = tileStart[t], last = tileStart[t + 1];
+        Mesh tile;
+        {
+            ProfileScope gatherScope(ProfileStage::Tile);
+            MeshIndex triangle[3];
+            MeshIndex lowest = numeric_limits<MeshIndex>::max(), highest = 0;
+            for (size_t k = first; k < last; ++k) {
+                size_t n;
+                const MeshIndex* corners = faceCorners(mesh, faceOrder[k], triangle, n);
+                for (size_t j = 0; j < n; ++j) {
+                    lowest = std::min(lowest, corners[j]);
+                    highest = std::max(highest, corners[j]);
+                }
+            }
+            TileVertexSet used;
+            used.reset(lowest, highest);
+            for (size_t k = first; k < last; ++k) {
+                size_t n;
+                const MeshIndex* corners = faceCorners(mesh, faceOrder[k], triangle, n);
+                for (size_t j = 0; j < n; ++j) used.add(corners[j]);
+            }
+            const size_t usedCount = used.finish();
+            tileVertices[job] = usedCount;
+            referenced += used.mergeInto(referencedBits);
+
+            tile.resetVertices(usedCount, mesh.presence);
+            size_t v = 0;
+            used.forEach([&](size_t src) {
+                tile.positions[v] = mesh.positions[src];
+                if (mesh.hasNormals()) tile.normals[v] = mesh.normals[src];
+                if (mesh.hasColors()) tile.colors[v] = mesh.colors[src];
+                if (mesh.hasTexCoords()) tile.texCoords[v] = mesh.texCoords[src];
+                ++v;
+            });
+            auto local = [&used](MeshIndex index) { return used.local(index); };
+            if (mesh.hasPolygons()) {
+                for (size_t k = first; k < last; ++k) {
+                    size_t n;
+                    const MeshIndex* corners = faceCorners(mesh, faceOrder[k], triangle, n);
+                    for (size_t j = 0; j < n; ++j) tile.polygons.indices.push_back(local(corners[j]));
+                    tile.polygons.closeFace();
+                }
+            }
+            else {
+                tile.triangles.resize(last - first);
+                for (size_t k = first; k < last; ++k) {
+                    const Triangle& tri = mesh.triangles[faceOrder[k]];
+                    tile.triangles[k - first] = { local(tri.v0), local(tri.v1), local(tri.v2) };
+                }
+            }
+        }
+        const unsigned x = static_cast<unsigned>(t % gx);
+        const unsigned y = static_cast<unsigned>(t / gx % gy);
+        const unsigned z = static_cast<unsigned>(t / gx / gy);
+        if (!writeOBJ(tilePath(objPath, x, y, z), tile, has_normals, has_colors, has_texCoords, tileWrite)) failed = true;
+    });
+    if (failed) return false;
+
+    stats.tileCount = nonEmpty.size();
+    size_t totalVertices = 0;
+    for (size_t n : tileVertices) {
+        totalVertices += n;
+        stats.maxTileVertices = std::max(stats.maxTileVertices, n);
+    }
+    stats.duplicatedVertices = totalVertices - referenced.load();
+    return true;
+}
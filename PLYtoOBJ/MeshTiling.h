@@ -0,0 +1,36 @@
+﻿// MeshTiling.h : 按均匀空间网格把网格切分为若干块，每块写为独立的OBJ
+//
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "Mesh.h"
+#include "ObjWriter.h"
+
+struct TileOptions {
+    unsigned gridX = 1, gridY = 1, gridZ = 1; // 包围盒在各轴上的等分数
+    unsigned threadCount = 1; // > 1 时各块在工作线程上并行写出
+};
+
+struct TileStats {
+    size_t tileCount = 0;         // 写出的非空块数
+    size_t maxTileVertices = 0;   // 最大的块中的顶点数
+    size_t duplicatedVertices = 0; // 各块顶点数之和减去被引用的顶点数 (跨块边界的面使顶点重复)
+    size_t droppedFaces = 0;      // 含超出范围索引、无法确定位置的面
+};
+
+// 解析 "XxYxZ" 或 "N" (N x N x N) 形式的网格划分
+bool parseTileGrid(const std::string& text, TileOptions& options);
+
+// 第 (x, y, z) 块的输出路径：在 objPath 文件名的第一个扩展名之前插入 "_x_y_z"
+// (model.obj.gz -> model_0_1_0.obj.gz)
+std::string tilePath(const std::string& objPath, unsigned x, unsigned y, unsigned z);
+
+// 按面的重心所在的格子把面分配到各块，每块只包含自己的面引用的顶点，按原顺序重新编号，
+// 用 writeOBJ 写为独立的OBJ文件 (写出选项与整体输出相同)。没有面的块不写出。
+// 同时处理的块数不超过线程数，额外内存与面数 (每面一个块序号和一个面序号) 及正在写出的块的大小
+// (块的顶点、面和索引范围上的位图) 成正比，不需要整个网格的重映射数组；
+// 统计重复的顶点数另需每个顶点一位的位图 (由各块的位图合并)。
+bool writeOBJTiles(const std::string& objPath, const Mesh& mesh, bool has_normals, bool has_colors, bool has_texCoords,
+    const TileOptions& tiles, const ObjWriteOptions& options, TileStats& stats);
@@ -0,0 +1,74 @@
+﻿// NumberFormat.cpp : TextBuffer 与浮点格式设置的实现
+//
+
+#include "NumberFormat.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+
+namespace {
+
+// 单个数值写入前预留的空间。float 的 fixed 表示最长为 符号 + 39位整数 + 小数点 + precision。
+const size_t kMaxNumberChars = 64;
+const int kMaxPrecision = 17;
+
+} // namespace
+
+bool parseFloatFormat(const std::string& spec, FloatFormat& format) {
+    if (spec == "shortest") {
+        format.style = FloatStyle::Shortest;
+        return true;
+    }
+    std::string digits = spec;
+    FloatStyle style = FloatStyle::General;
+    if (spec.rfind("fixed", 0) == 0) {
+        digits = spec.substr(5);
+        style = FloatStyle::Fixed;
+    }
+    if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) return false;
+    int precision = std::atoi(digits.c_str());
+    if (precision > kMaxPrecision || (style == FloatStyle::General && precision < 1)) return false;
+    format.style = style;
+    format.precision = precision;
+    return true;
+}
+
+TextBuffer::TextBuffer(std::string& storage, const FloatFormat& format)
+    : storage_(storage), used_(storage.size()), format_(format) {
+}
+
+void TextBuffer::grow(size_t n) {
+    storage_.resize(std::max(storage_.size() * 2, used_ + std::max<size_t>(n, 4096)));
+}
+
+void TextBuffer::appendFloat(float value) {
+    ensure(kMaxNumberChars);
+    char* first = &storage_[used_];
+    char* last = first + kMaxNumberChars;
+    std::to_chars_result r;
+    switch (format_.style) {
+    case FloatStyle::Shortest: r = std::to_chars(first, last, value); break;
+    case FloatStyle::Fixed: r = std::to_chars(first, last, value, std::chars_format::fixed, format_.precision); break;
+    default: r = std::to_chars(first, last, value, std::chars_format::general, format_.precision); break;
+    }
+    used_ = static_cast<size_t>(r.ptr - storage_.data());
+}
+
+void TextBuffer::appendInt(int64_t value) {
+    ensure(kMaxNumberChars);
+    char* first = &storage_[used_];
+    std::to_chars_result r = std::to_chars(first, first + kMaxNumberChars, value);
+    used_ = static_cast<size_t>(r.ptr - storage_.data());
+}
+
+void TextBuffer::appendUInt(uint64_t value) {
+    ensure(kMaxNumberChars);
+    char* first = &storage_[used_];
+    std::to_chars_result r = std::to_chars(first, first + kMaxNumberChars, value);
+    used_ = static_cast<size_t>(r.ptr - storage_.data());
+}
+
+void TextBuffer::finish() {
+    storage_.resize(used_);
+}
@@ -0,0 +1,62 @@
+﻿// NumberFormat.h : 基于 std::to_chars 的数值格式化与可复用的文本缓冲区
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// 浮点数输出方式
+enum class FloatStyle : uint8_t {
+    General,  // precision 位有效数字，同 printf("%g")。默认6位，与 iostream 的默认输出逐字节一致
+    Shortest, // 能精确往返 (round-trip) 的最短表示
+    Fixed     // 小数点后固定 precision 位
+};
+
+struct FloatFormat {
+    FloatStyle style = FloatStyle::General;
+    int precision = 6;
+};
+
+// 解析命令行中的精度设置: "shortest"、"N" (N位有效数字) 或 "fixedN" (小数点后N位)
+bool parseFloatFormat(const std::string& spec, FloatFormat& format);
+
+// 在 std::string 尾部直接格式化写入文本。storage 的容量按需倍增并在多次使用间保留，
+// 析构或 finish() 时把 storage 截断为实际写入的长度。
+class TextBuffer {
+public:
+    TextBuffer(std::string& storage, const FloatFormat& format);
+    ~TextBuffer() { finish(); }
+
+    TextBuffer(const TextBuffer&) = delete;
+    TextBuffer& operator=(const TextBuffer&) = delete;
+
+    void put(char c) {
+        ensure(1);
+        storage_[used_++] = c;
+    }
+    void write(const char* s, size_t n) {
+        ensure(n);
+        memcpy(&storage_[used_], s, n);
+        used_ += n;
+    }
+    template<size_t N>
+    void literal(const char (&s)[N]) { write(s, N - 1); }
+
+    void appendFloat(float value);
+    void appendInt(int64_t value);
+    void appendUInt(uint64_t value);
+
+    void finish();
+
+private:
+    void ensure(size_t n) {
+        if (storage_.size() - used_ < n) grow(n);
+    }
+    void grow(size_t n);
+
+    std::string& storage_;
+    size_t used_;
+    FloatFormat format_;
+};
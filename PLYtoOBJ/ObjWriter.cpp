@@ -0,0 +1,253 @@
+﻿// ObjWriter.cpp : OBJ 文本格式化与 writeOBJ 的实现
+//
+
+#include "ObjWriter.h"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+
+#include "ParallelChunks.h"
+#include "Profile.h"
+
+using namespace std;
+
+// 一个可独立格式化的输出块：某一段中 [begin, end) 范围内的元素
+struct ObjChunk {
+    ObjSection section;
+    size_t begin, end;
+    bool endsSection; // 该段的最后一块，v/vt/vn 段之后输出一个空行
+};
+
+// 每个输出块包含的行数
+const size_t kObjChunkLines = 1 << 16;
+
+// 按 OBJ 的段顺序把输出切分成块
+vector<ObjChunk> planOBJChunks(size_t vertexCount, size_t faceCount, bool has_normals, bool has_texCoords) {
+    vector<ObjChunk> chunks;
+    chunks.push_back({ ObjSection::Header, 0, 0, true });
+    auto addSection = [&chunks](ObjSection section, size_t count) {
+        if (count == 0) {
+            chunks.push_back({ section, 0, 0, true });
+            return;
+        }
+        for (size_t begin = 0; begin < count; begin += kObjChunkLines) {
+            const size_t end = std::min(count, begin + kObjChunkLines);
+            chunks.push_back({ section, begin, end, end == count });
+        }
+    };
+    addSection(ObjSection::Vertices, vertexCount);
+    if (has_texCoords) addSection(ObjSection::TexCoords, vertexCount);
+    if (has_normals) addSection(ObjSection::Normals, vertexCount);
+    if (faceCount > 0) addSection(ObjSection::Faces, faceCount);
+    return chunks;
+}
+
+// 写入文件头
+void formatOBJHeader(TextBuffer& out, size_t vertexCount, size_t faceCount,
+    bool has_normals, bool has_colors, bool has_texCoords) {
+    out.literal("# Converted from PLY to OBJ by PLYtoOBJ_Converter\n");
+    out.literal("# Vertices: "); out.appendUInt(vertexCount); out.put('\n');
+    out.literal("# Faces: "); out.appendUInt(faceCount); out.put('\n');
+    if (has_normals) out.literal("# Has Normals\n");
+    if (has_colors) out.literal("# Has Vertex Colors (appended to 'v' lines as r g b)\n");
+    if (has_texCoords) out.literal("# Has Texture Coordinates\n");
+    out.put('\n');
+}
+
+// 写入顶点数据 (格式: v x y z [r g b])，colors 为 nullptr 时不写颜色
+void formatVertexLines(TextBuffer& out, const Vec3* positions, const Vec3* colors, size_t count) {
+    if (colors == nullptr) {
+        for (size_t i = 0; i < count; ++i) {
+            out.literal("v ");
+            out.appendFloat(positions[i].x); out.put(' ');
+            out.appendFloat(positions[i].y); out.put(' ');
+            out.appendFloat(positions[i].z); out.put('\n');
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out.literal("v ");
+        out.appendFloat(positions[i].x); out.put(' ');
+        out.appendFloat(positions[i].y); out.put(' ');
+        out.appendFloat(positions[i].z); out.put(' ');
+        out.appendFloat(colors[i].x); out.put(' ');
+        out.appendFloat(colors[i].y); out.put(' ');
+        out.appendFloat(colors[i].z); out.put('\n');
+    }
+}
+
+// 写入纹理坐标 (格式: vt u v)
+void formatTexCoordLines(TextBuffer& out, const Vec2* texCoords, size_t count) {
+    if (texCoords == nullptr) { // OBJ需要为每个顶点提供vt，网格没有纹理坐标时输出0 0
+        for (size_t i = 0; i < count; ++i) out.literal("vt 0 0\n");
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out.literal("vt ");
+        out.appendFloat(texCoords[i].u); out.put(' ');
+        out.appendFloat(texCoords[i].v); out.put('\n');
+    }
+}
+
+// 写入法线数据 (格式: vn x y z)
+void formatNormalLines(TextBuffer& out, const Vec3* normals, size_t count) {
+    if (normals == nullptr) { // OBJ需要为每个顶点提供vn，网格没有法线时输出0 0 1 (默认向上)
+        for (size_t i = 0; i < count; ++i) out.literal("vn 0 0 1\n");
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out.literal("vn ");
+        out.appendFloat(normals[i].x); out.put(' ');
+        out.appendFloat(normals[i].y); out.put(' ');
+        out.appendFloat(normals[i].z); out.put('\n');
+    }
+}
+
+// 写入面的一个顶点 ( v[/vt][/vn])，OBJ索引从1开始
+inline void appendFaceCorner(TextBuffer& out, MeshIndex v_idx, bool has_normals, bool has_texCoords) {
+    const int64_t objIndex = static_cast<int64_t>(v_idx) + 1;
+    out.put(' '); out.appendInt(objIndex); // 顶点索引
+
+    if (has_texCoords) {
+        out.put('/'); out.appendInt(objIndex); // 纹理坐标索引 (与顶点索引相同)
+    }
+    else if (has_normals) { // 如果没有纹理坐标但有法线
+        out.put('/');
+    }
+
+    if (has_normals) {
+        out.put('/'); out.appendInt(objIndex); // 法线索引 (与顶点索引相同)
+    }
+}
+
+// 写入面数据
+// 格式: f v1[/vt1][/vn1] v2[/vt2][/vn2] v3[/vt3][/vn3]
+void formatFaceLines(TextBuffer& out, const Triangle* triangles, size_t count, bool has_normals, bool has_texCoords) {
+    for (size_t i = 0; i < count; ++i) {
+        const Triangle& tri = triangles[i];
+        out.put('f');
+        appendFaceCorner(out, tri.v0, has_normals, has_texCoords);
+        appendFaceCorner(out, tri.v1, has_normals, has_texCoords);
+        appendFaceCorner(out, tri.v2, has_normals, has_texCoords);
+        out.put('\n');
+    }
+}
+
+void formatPolygonLines(TextBuffer& out, const PolygonFaces& polygons, size_t first, size_t count,
+    bool has_normals, bool has_texCoords) {
+    const MeshIndex* indices = polygons.indices.data();
+    for (size_t f = first; f < first + count; ++f) {
+        out.put('f');
+        for (size_t k = polygons.offsets[f]; k < polygons.offsets[f + 1]; ++k) {
+            appendFaceCorner(out, indices[k], has_normals, has_texCoords);
+        }
+        out.put('\n');
+    }
+}
+
+// 格式化一个输出块。顺序写入与并行写入都走这里，保证两者输出逐字节一致。
+void formatOBJChunk(TextBuffer& out, const ObjChunk& chunk, const Mesh& mesh,
+    bool has_normals, bool has_colors, bool has_texCoords) {
+    const size_t count = chunk.end - chunk.begin;
+    switch (chunk.section) {
+    case ObjSection::Header:
+        formatOBJHeader(out, mesh.vertexCount(), mesh.faceCount(), has_normals, has_colors, has_texCoords);
+        return;
+    case ObjSection::Vertices:
+        formatVertexLines(out, mesh.positions.data() + chunk.begin, attributeFrom(mesh.colors, chunk.begin), count);
+        break;
+    case ObjSection::TexCoords:
+        formatTexCoordLines(out, attributeFrom(mesh.texCoords, chunk.begin), count);
+        break;
+    case ObjSection::Normals:
+        formatNormalLines(out, attributeFrom(mesh.normals, chunk.begin), count);
+        break;
+    case ObjSection::Faces:
+        if (mesh.hasPolygons()) formatPolygonLines(out, mesh.polygons, chunk.begin, count, has_normals, has_texCoords);
+        else formatFaceLines(out, mesh.triangles.data() + chunk.begin, count, has_normals, has_texCoords);
+        return;
+    }
+    if (chunk.endsSection) out.put('\n');
+}
+
+uint64_t estimateOBJBytes(uint64_t vertexCount, double faceLines, double faceCorners, uint8_t presence,
+    bool has_normals, bool has_texCoords, const FloatFormat& floatFormat) {
+    // 各类行的平均长度：浮点数的长度由输出精度决定，索引的长度取 1..顶点数 的平均十进制位数
+    double floatChars;
+    switch (floatFormat.style) {
+    case FloatStyle::Shortest: floatChars = 10.0; break;
+    case FloatStyle::Fixed: floatChars = floatFormat.precision + 3.0; break;
+    default: floatChars = floatFormat.precision + 2.0; break;
+    }
+    const double field = floatChars + 1.0; // 含前面的空格
+    double indexDigits = 1.0;
+    if (vertexCount > 0) {
+        double digitSum = 0.0;
+        uint64_t low = 1;
+        for (int digits = 1; low <= vertexCount; ++digits) {
+            const uint64_t high = low > vertexCount / 10 ? vertexCount : low * 10 - 1;
+            digitSum += static_cast<double>(high - low + 1) * digits;
+            if (high == vertexCount) break;
+            low *= 10;
+        }
+        indexDigits = digitSum / static_cast<double>(vertexCount);
+    }
+    const bool meshNormals = (presence & kPresenceNormal) != 0;
+    const bool meshColors = (presence & kPresenceColor) != 0;
+    const bool meshTexCoords = (presence & kPresenceTexCoord) != 0;
+    double vertexLine = 2.0 + 3.0 * field + (meshColors ? 3.0 * field : 0.0);
+    if (has_texCoords) vertexLine += meshTexCoords ? 3.0 + 2.0 * field : 7.0;
+    if (has_normals) vertexLine += meshNormals ? 3.0 + 3.0 * field : 9.0;
+    double corner = 1.0 + indexDigits;
+    if (has_texCoords) corner += 1.0 + indexDigits;
+    else if (has_normals) corner += 1.0;
+    if (has_normals) corner += 1.0 + indexDigits;
+    const double kHeaderChars = 200.0;
+    return static_cast<uint64_t>(kHeaderChars + vertexLine * static_cast<double>(vertexCount) +
+        2.0 * faceLines + corner * faceCorners);
+}
+
+bool writeOBJ(OutputSink& sink, const Mesh& mesh,
+    bool has_normals, bool has_colors, bool has_texCoords, const ObjWriteOptions& options) {
+    const vector<ObjChunk> chunks = planOBJChunks(mesh.vertexCount(), mesh.faceCount(), has_normals, has_texCoords);
+    return processChunksInOrder(chunks.size(), options.threadCount,
+        [&](size_t job, string& buffer) {
+            // to_chars 不受区域设置影响，浮点数总是用点号表示
+            ProfileScope scope(ProfileStage::Format);
+            TextBuffer out(buffer, options.floatFormat);
+            formatOBJChunk(out, chunks[job], mesh, has_normals, has_colors, has_texCoords);
+        },
+        [&sink](const string& buffer) {
+            ProfileScope scope(ProfileStage::OutputWait);
+            return sink.write(buffer.data(), buffer.size());
+        });
+}
+
+bool writeOBJ(const string& objPath, const Mesh& mesh,
+    bool has_normals, bool has_colors, bool has_texCoords, const ObjWriteOptions& options) {
+    uint64_t sizeHint = 0;
+    if (options.asyncWrite.enabled) {
+        const double corners = mesh.hasPolygons() ? static_cast<double>(mesh.polygons.indices.size())
+            : 3.0 * static_cast<double>(mesh.triangles.size());
+        sizeHint = estimateOBJBytes(mesh.vertexCount(), static_cast<double>(mesh.faceCount()), corners, mesh.presence,
+            has_normals, has_texCoords, options.floatFormat);
+    }
+    unique_ptr<OutputSink> file = openOutputSink(objPath, options.compression, false, options.asyncWrite, sizeHint);
+    if (!file) {
+        cerr << "错误: 无法创建OBJ文件 " << objPath << endl;
+        return false;
+    }
+
+    const bool ok = writeOBJ(*file, mesh, has_normals, has_colors, has_texCoords, options);
+
+    ProfileScope finishScope(ProfileStage::OutputWait);
+    if (!file->finish() || !ok) {
+        cerr << "错误: 写入OBJ文件 " << objPath << " 失败" << endl;
+        return false;
+    }
+    return true;
+}
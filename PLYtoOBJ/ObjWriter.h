@@ -0,0 +1,67 @@
+﻿// ObjWriter.h : 把网格格式化为OBJ文本并写入文件
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "NumberFormat.h"
+#include "OutputSink.h"
+
+// OBJ 写入选项
+struct ObjWriteOptions {
+    unsigned threadCount = 1; // > 1 时各输出块在工作线程上并行格式化
+    FloatFormat floatFormat;  // 浮点数输出精度，默认与 iostream 的默认输出一致
+    CompressionOptions compression; // 输出压缩，默认不压缩
+    AsyncWriteOptions asyncWrite;   // 大块异步写入 (可绕过页缓存)，不压缩时按估计的大小预分配文件
+};
+
+// 不压缩时OBJ文本的估计字节数。faceLines 为 f 行数，faceCorners 为所有 f 行的顶点数之和；
+// presence 为网格中实际有的属性，has_normals / has_texCoords 决定是否输出 vn / vt (缺少时按默认值的长度计算)
+uint64_t estimateOBJBytes(uint64_t vertexCount, double faceLines, double faceCorners, uint8_t presence,
+    bool has_normals, bool has_texCoords, const FloatFormat& floatFormat);
+
+// 将网格写入OBJ文件。has_normals / has_texCoords 决定是否输出 vn / vt 段，网格缺少对应属性时输出默认值。
+// 网格保留了多边形时按多边形输出 f 行。
+// 多线程时各输出块在工作线程上并行格式化，再按顺序写入文件，输出与单线程完全相同
+bool writeOBJ(const std::string& objPath, const Mesh& mesh,
+    bool has_normals, bool has_colors, bool has_texCoords, const ObjWriteOptions& options = ObjWriteOptions());
+
+// 按同样的格式把OBJ文本依次交给 sink，不调用 sink.finish()，也不报错，由调用方决定。
+// options.compression 不起作用 (压缩只用于输出文件)。sink.write 返回 false 时停止并返回 false。
+bool writeOBJ(OutputSink& sink, const Mesh& mesh,
+    bool has_normals, bool has_colors, bool has_texCoords, const ObjWriteOptions& options = ObjWriteOptions());
+
+// ---- 逐段的行格式化，供流式转换按块调用 ----
+
+// OBJ文件中的一段连续输出
+enum class ObjSection : uint8_t { Header, Vertices, TexCoords, Normals, Faces };
+
+// 写入文件头，faceCount 为输出的面 (三角形或多边形) 数
+void formatOBJHeader(TextBuffer& out, size_t vertexCount, size_t faceCount,
+    bool has_normals, bool has_colors, bool has_texCoords);
+
+// 写入顶点数据 (格式: v x y z [r g b])，colors 为 nullptr 时不写颜色
+void formatVertexLines(TextBuffer& out, const Vec3* positions, const Vec3* colors, size_t count);
+
+// 写入纹理坐标 (格式: vt u v)，texCoords 为 nullptr 时输出 vt 0 0
+void formatTexCoordLines(TextBuffer& out, const Vec2* texCoords, size_t count);
+
+// 写入法线数据 (格式: vn x y z)，normals 为 nullptr 时输出 vn 0 0 1
+void formatNormalLines(TextBuffer& out, const Vec3* normals, size_t count);
+
+// 写入面数据 (f v[/vt][/vn] ...，OBJ索引从1开始)
+void formatFaceLines(TextBuffer& out, const Triangle* triangles, size_t count, bool has_normals, bool has_texCoords);
+
+// 写入多边形面 [first, first + count)，每个面一行，顶点数与原多边形相同
+void formatPolygonLines(TextBuffer& out, const PolygonFaces& polygons, size_t first, size_t count,
+    bool has_normals, bool has_texCoords);
+
+// 属性数组中从 first 开始的部分，数组未分配时为 nullptr
+template<typename T>
+const T* attributeFrom(const std::vector<T>& values, size_t first) {
+    return values.empty() ? nullptr : values.data() + first;
+}
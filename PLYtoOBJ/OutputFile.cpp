@@ -0,0 +1,156 @@
+﻿// OutputFile.cpp : OutputFile 的平台相关实现
+//
+
+#include "OutputFile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+OutputFile::~OutputFile() {
+    release();
+}
+
+#ifdef _WIN32
+
+bool OutputFile::open(const std::string& path, bool unbuffered) {
+    release();
+    const DWORD flags = FILE_ATTRIBUTE_NORMAL | (unbuffered ? FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH : 0);
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE && unbuffered) {
+        unbuffered = false;
+        file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    }
+    if (file == INVALID_HANDLE_VALUE) return false;
+    handle_ = file;
+    unbuffered_ = unbuffered;
+    return true;
+}
+
+bool OutputFile::isOpen() const {
+    return handle_ != nullptr;
+}
+
+void OutputFile::preallocate(uint64_t bytes) {
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = static_cast<LONGLONG>(bytes);
+    SetFileInformationByHandle(static_cast<HANDLE>(handle_), FileAllocationInfo, &info, sizeof(info));
+}
+
+bool OutputFile::writeAt(const char* data, size_t size, uint64_t offset) {
+    // 句柄不是以 FILE_FLAG_OVERLAPPED 打开的：带偏移的 WriteFile 同步写入指定位置，不使用共享的文件指针
+    while (size > 0) {
+        const DWORD step = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        OVERLAPPED position = {};
+        position.Offset = static_cast<DWORD>(offset);
+        position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD written = 0;
+        if (!WriteFile(static_cast<HANDLE>(handle_), data, step, &written, &position) || written == 0) return false;
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+bool OutputFile::close(uint64_t finalSize) {
+    if (handle_ == nullptr) return true;
+    FILE_END_OF_FILE_INFO info;
+    info.EndOfFile.QuadPart = static_cast<LONGLONG>(finalSize);
+    bool ok = SetFileInformationByHandle(static_cast<HANDLE>(handle_), FileEndOfFileInfo, &info, sizeof(info)) != 0;
+    ok = CloseHandle(static_cast<HANDLE>(handle_)) != 0 && ok;
+    handle_ = nullptr;
+    unbuffered_ = false;
+    return ok;
+}
+
+void OutputFile::release() {
+    if (handle_ == nullptr) return;
+    CloseHandle(static_cast<HANDLE>(handle_));
+    handle_ = nullptr;
+    unbuffered_ = false;
+}
+
+#else
+
+bool OutputFile::open(const std::string& path, bool unbuffered) {
+    release();
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    int fd = -1;
+#ifdef O_DIRECT
+    // tmpfs 等文件系统不支持 O_DIRECT，打开时返回 EINVAL
+    if (unbuffered) fd = ::open(path.c_str(), flags | O_DIRECT, 0666);
+    if (fd < 0 && unbuffered && errno != EINVAL) return false;
+    if (fd < 0) {
+        unbuffered = false;
+        fd = ::open(path.c_str(), flags, 0666);
+    }
+#else
+    fd = ::open(path.c_str(), flags, 0666);
+#if defined(__APPLE__) && defined(F_NOCACHE)
+    if (fd >= 0 && unbuffered) unbuffered = fcntl(fd, F_NOCACHE, 1) == 0;
+#else
+    unbuffered = false;
+#endif
+#endif
+    if (fd < 0) return false;
+    fd_ = fd;
+    unbuffered_ = unbuffered;
+    return true;
+}
+
+bool OutputFile::isOpen() const {
+    return fd_ >= 0;
+}
+
+void OutputFile::preallocate(uint64_t bytes) {
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    // 只分配空间，不改变文件大小；不用 posix_fallocate，它在不支持的文件系统上会逐块写零
+    fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+#else
+    (void)bytes;
+#endif
+}
+
+bool OutputFile::writeAt(const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        const ssize_t written = pwrite(fd_, data, std::min<size_t>(size, 1u << 30), static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+bool OutputFile::close(uint64_t finalSize) {
+    if (fd_ < 0) return true;
+    bool ok = ftruncate(fd_, static_cast<off_t>(finalSize)) == 0;
+    ok = ::close(fd_) == 0 && ok;
+    fd_ = -1;
+    unbuffered_ = false;
+    return ok;
+}
+
+void OutputFile::release() {
+    if (fd_ < 0) return;
+    ::close(fd_);
+    fd_ = -1;
+    unbuffered_ = false;
+}
+
+#endif
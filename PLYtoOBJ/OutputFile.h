@@ -0,0 +1,45 @@
+﻿// OutputFile.h : 按偏移写入的输出文件 (Linux/POSIX 使用 pwrite, Windows 使用带偏移的 WriteFile)
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 直接 I/O 要求缓冲区地址、写入长度和文件偏移都按此对齐
+const size_t kDirectIOAlignment = 4096;
+
+// 只写的输出文件。writeAt 可以在多个线程上同时调用，各自写入不重叠的区域。
+class OutputFile {
+public:
+    OutputFile() = default;
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    // 创建 (或清空) 文件。unbuffered 为 true 时绕过页缓存 (Linux O_DIRECT、macOS F_NOCACHE、
+    // Windows FILE_FLAG_NO_BUFFERING)，文件系统不支持时改用普通写入，此时 isUnbuffered() 返回 false。
+    bool open(const std::string& path, bool unbuffered);
+    // 把文件截断为 finalSize 字节 (去掉最后一块的对齐填充和多余的预分配) 后关闭。
+    // 未调用 close 就析构时直接关闭，文件内容不确定。
+    bool close(uint64_t finalSize);
+
+    bool isOpen() const;
+    bool isUnbuffered() const { return unbuffered_; }
+
+    // 预先分配 bytes 字节的磁盘空间，不改变文件大小；不支持时忽略
+    void preallocate(uint64_t bytes);
+    // 不绕过页缓存时 data / size / offset 不需要对齐
+    bool writeAt(const char* data, size_t size, uint64_t offset);
+
+private:
+    void release(); // 关闭而不截断 (出错后放弃写入时)
+
+    bool unbuffered_ = false;
+#ifdef _WIN32
+    void* handle_ = nullptr; // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
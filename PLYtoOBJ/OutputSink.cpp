@@ -0,0 +1,470 @@
+﻿// OutputSink.cpp : 普通文件输出、后台线程压缩输出与内存输出
+//
+// 压缩输出与后台写入：write 把数据复制到有界队列中的缓冲区后立即返回，后台线程依次取出、压缩并写入文件。
+// 队列满时 write 等待，内存占用有界。
+// 大块异步写入：数据填满对齐的块后交给写入线程按偏移写入，多个块同时写入。
+
+#include "OutputSink.h"
+#include "OutputFile.h"
+#include "Profile.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef PLYTOOBJ_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PLYTOOBJ_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+bool parseCompression(const string& name, Compression& method) {
+    if (name == "none") method = Compression::None;
+    else if (name == "gzip" || name == "gz") method = Compression::Gzip;
+    else if (name == "zstd" || name == "zst") method = Compression::Zstd;
+    else return false;
+    return true;
+}
+
+Compression compressionForPath(const string& path) {
+    auto endsWith = [&path](const char* suffix) {
+        const size_t n = strlen(suffix);
+        return path.size() >= n && path.compare(path.size() - n, n, suffix) == 0;
+    };
+    if (endsWith(".gz")) return Compression::Gzip;
+    if (endsWith(".zst")) return Compression::Zstd;
+    return Compression::None;
+}
+
+const char* compressionExtension(Compression method) {
+    switch (method) {
+    case Compression::Gzip: return ".gz";
+    case Compression::Zstd: return ".zst";
+    default: return "";
+    }
+}
+
+bool compressionAvailable(Compression method) {
+    switch (method) {
+    case Compression::None: return true;
+#ifdef PLYTOOBJ_WITH_ZLIB
+    case Compression::Gzip: return true;
+#endif
+#ifdef PLYTOOBJ_WITH_ZSTD
+    case Compression::Zstd: return true;
+#endif
+    default: return false;
+    }
+}
+
+// 所有输出最终都经过这里写入文件
+bool writeToFile(ofstream& out, const char* data, size_t size) {
+    ProfileScope scope(ProfileStage::Write);
+    profileAdd(ProfileCounter::BytesWritten, size);
+    out.write(data, static_cast<streamsize>(size));
+    return static_cast<bool>(out);
+}
+
+CallbackSink::CallbackSink(Callback callback) : callback_(std::move(callback)) {}
+
+bool CallbackSink::write(const char* data, size_t size) {
+    if (failed_) return false;
+    if (size > 0 && !callback_(data, size)) failed_ = true;
+    return !failed_;
+}
+
+bool CallbackSink::finish() {
+    return !failed_;
+}
+
+void CallbackSink::reset() {
+    failed_ = false;
+}
+
+bool StringSink::write(const char* data, size_t size) {
+    out_.append(data, size);
+    return true;
+}
+
+bool StringSink::finish() {
+    return true;
+}
+
+// 不压缩时与原来的 writeOBJ 一样使用文本模式的 ofstream，压缩输出使用二进制模式
+class FileSink : public OutputSink {
+public:
+    explicit FileSink(const string& path, ios::openmode mode = ios::out) : file_(path, mode) {}
+    bool isOpen() const { return file_.is_open(); }
+
+    bool write(const char* data, size_t size) override {
+        return writeToFile(file_, data, size);
+    }
+    bool finish() override {
+        file_.close();
+        return !file_.fail();
+    }
+
+private:
+    ofstream file_;
+};
+
+// 压缩器：compress 把输入追加到压缩流，last 为 true 时结束压缩流。压缩结果写入 out。
+class Encoder {
+public:
+    virtual ~Encoder() = default;
+    virtual bool compress(const char* data, size_t size, bool last, OutputSink& out) = 0;
+};
+
+// 不压缩，直接写出 (用于后台写入)
+class PassThroughEncoder : public Encoder {
+public:
+    bool compress(const char* data, size_t size, bool, OutputSink& out) override {
+        return out.write(data, size);
+    }
+};
+
+#ifdef PLYTOOBJ_WITH_ZLIB
+class GzipEncoder : public Encoder {
+public:
+    explicit GzipEncoder(int level) : out_(1 << 18) {
+        memset(&stream_, 0, sizeof(stream_));
+        // windowBits 加 16 输出 gzip 文件头与尾
+        ok_ = deflateInit2(&stream_, level > 0 ? std::min(level, 9) : Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+            Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+    ~GzipEncoder() override {
+        if (ok_) deflateEnd(&stream_);
+    }
+    bool valid() const { return ok_; }
+
+    bool compress(const char* data, size_t size, bool last, OutputSink& out) override {
+        // avail_in 是 32 位的，大块分多次送入
+        ProfileScope scope(ProfileStage::Compress);
+        do {
+            const size_t step = std::min<size_t>(size, 1u << 30);
+            stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            stream_.avail_in = static_cast<uInt>(step);
+            data += step;
+            size -= step;
+            const int flush = (last && size == 0) ? Z_FINISH : Z_NO_FLUSH;
+            int ret;
+            do {
+                stream_.next_out = out_.data();
+                stream_.avail_out = static_cast<uInt>(out_.size());
+                ret = deflate(&stream_, flush);
+                if (ret == Z_STREAM_ERROR) return false;
+                if (!out.write(reinterpret_cast<const char*>(out_.data()), out_.size() - stream_.avail_out)) return false;
+            } while (stream_.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+        } while (size > 0);
+        return true;
+    }
+
+private:
+    z_stream stream_;
+    vector<Bytef> out_;
+    bool ok_ = false;
+};
+#endif
+
+#ifdef PLYTOOBJ_WITH_ZSTD
+class ZstdEncoder : public Encoder {
+public:
+    ZstdEncoder(int level, unsigned threadCount) : context_(ZSTD_createCCtx()), out_(ZSTD_CStreamOutSize()) {
+        if (context_ == nullptr) return;
+        ZSTD_CCtx_setParameter(context_, ZSTD_c_compressionLevel, level > 0 ? level : ZSTD_CLEVEL_DEFAULT);
+        // 库未启用多线程时设置会失败，此时在后台线程上单线程压缩
+        if (threadCount > 1) ZSTD_CCtx_setParameter(context_, ZSTD_c_nbWorkers, static_cast<int>(threadCount));
+    }
+    ~ZstdEncoder() override {
+        ZSTD_freeCCtx(context_);
+    }
+    bool valid() const { return context_ != nullptr; }
+
+    bool compress(const char* data, size_t size, bool last, OutputSink& out) override {
+        ProfileScope scope(ProfileStage::Compress);
+        ZSTD_inBuffer input = { data, size, 0 };
+        const ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+        for (;;) {
+            ZSTD_outBuffer output = { out_.data(), out_.size(), 0 };
+            const size_t remaining = ZSTD_compressStream2(context_, &output, &input, mode);
+            if (ZSTD_isError(remaining)) return false;
+            if (!out.write(out_.data(), output.pos)) return false;
+            // continue 模式下输入全部消耗即可返回；end 模式需要等到帧完全写出
+            if (last ? remaining == 0 : input.pos == input.size) return true;
+        }
+    }
+
+private:
+    ZSTD_CCtx* context_;
+    vector<char> out_;
+};
+#endif
+
+// 大块异步写入。write 把数据复制到当前块，块写满后交给写入线程；depth 个写入线程各自按块的偏移写入文件。
+// 共有 depth + 1 块缓冲区循环使用 (正在填充的一块和正在写入的块)，没有空闲块时 write 等待。
+class AsyncFileSink : public OutputSink {
+public:
+    AsyncFileSink(unique_ptr<OutputFile> file, const AsyncWriteOptions& options)
+        : file_(std::move(file)) {
+        blockBytes_ = std::max<size_t>((options.blockBytes + kDirectIOAlignment - 1) / kDirectIOAlignment, 1) * kDirectIOAlignment;
+        const size_t depth = std::max(options.depth, 1u);
+        storage_.resize((depth + 1) * blockBytes_ + kDirectIOAlignment);
+        const uintptr_t address = reinterpret_cast<uintptr_t>(storage_.data());
+        char* aligned = storage_.data() + (kDirectIOAlignment - address % kDirectIOAlignment) % kDirectIOAlignment;
+        for (size_t k = 0; k <= depth; ++k) free_.push_back(aligned + k * blockBytes_);
+        for (size_t k = 0; k < depth; ++k) workers_.emplace_back([this] { run(); });
+    }
+
+    ~AsyncFileSink() override {
+        finish();
+    }
+
+    bool write(const char* data, size_t size) override {
+        while (size > 0) {
+            if (current_ == nullptr && !acquire()) return false;
+            const size_t n = std::min(size, blockBytes_ - used_);
+            memcpy(current_ + used_, data, n);
+            used_ += n;
+            data += n;
+            size -= n;
+            if (used_ == blockBytes_) submit();
+        }
+        lock_guard<mutex> lock(mutex_);
+        return !failed_;
+    }
+
+    bool finish() override {
+        if (finished_) return !failed_;
+        finished_ = true;
+        if (current_ != nullptr && used_ > 0) submit();
+        {
+            lock_guard<mutex> lock(mutex_);
+            stopping_ = true;
+            blockQueued_.notify_all();
+        }
+        for (thread& worker : workers_) worker.join();
+        workers_.clear();
+        // 截掉最后一块的对齐填充和偏大的预分配
+        if (!file_->close(offset_)) failed_ = true;
+        return !failed_;
+    }
+
+private:
+    struct Block { char* data; size_t bytes; size_t writeBytes; uint64_t offset; };
+
+    bool acquire() {
+        unique_lock<mutex> lock(mutex_);
+        blockFreed_.wait(lock, [this] { return !free_.empty() || failed_; });
+        if (failed_) return false;
+        current_ = free_.back();
+        free_.pop_back();
+        used_ = 0;
+        return true;
+    }
+
+    void submit() {
+        size_t writeBytes = used_;
+        if (file_->isUnbuffered()) {
+            // 直接 I/O 的写入长度必须对齐，最后一块补零，结束时再截断
+            writeBytes = (used_ + kDirectIOAlignment - 1) / kDirectIOAlignment * kDirectIOAlignment;
+            memset(current_ + used_, 0, writeBytes - used_);
+        }
+        lock_guard<mutex> lock(mutex_);
+        queue_.push_back({ current_, used_, writeBytes, offset_ });
+        offset_ += used_;
+        current_ = nullptr;
+        used_ = 0;
+        blockQueued_.notify_one();
+    }
+
+    void run() {
+        for (;;) {
+            Block block;
+            {
+                unique_lock<mutex> lock(mutex_);
+                blockQueued_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+                if (queue_.empty()) return;
+                block = queue_.front();
+                queue_.pop_front();
+            }
+            bool ok;
+            {
+                ProfileScope scope(ProfileStage::Write);
+                profileAdd(ProfileCounter::BytesWritten, block.bytes);
+                ok = file_->writeAt(block.data, block.writeBytes, block.offset);
+            }
+            lock_guard<mutex> lock(mutex_);
+            if (!ok) failed_ = true;
+            free_.push_back(block.data);
+            blockFreed_.notify_all();
+        }
+    }
+
+    unique_ptr<OutputFile> file_;
+    size_t blockBytes_ = 0;
+    vector<char> storage_;
+    char* current_ = nullptr; // 正在填充的块，只由调用 write 的线程访问
+    size_t used_ = 0;
+    uint64_t offset_ = 0;     // 下一块在文件中的偏移
+    bool finished_ = false;
+    mutex mutex_;
+    condition_variable blockQueued_, blockFreed_;
+    deque<Block> queue_;
+    vector<char*> free_;
+    bool stopping_ = false;
+    bool failed_ = false;
+    vector<thread> workers_;
+};
+
+// 在后台线程上压缩并写入 target
+class BackgroundSink : public OutputSink {
+public:
+    BackgroundSink(unique_ptr<OutputSink> target, unique_ptr<Encoder> encoder)
+        : target_(std::move(target)), encoder_(std::move(encoder)), worker_([this] { run(); }) {}
+
+    ~BackgroundSink() override {
+        finish();
+    }
+
+    bool write(const char* data, size_t size) override {
+        if (size == 0) return !failed();
+        unique_lock<mutex> lock(mutex_);
+        spaceAvailable_.wait(lock, [this] { return queue_.size() < kQueueDepth || failed_; });
+        if (failed_ || finished_) return false;
+        vector<char> block;
+        if (!spare_.empty()) {
+            block.swap(spare_.back());
+            spare_.pop_back();
+        }
+        block.assign(data, data + size);
+        queue_.push_back(std::move(block));
+        dataAvailable_.notify_one();
+        return true;
+    }
+
+    bool finish() override {
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (!finished_) {
+                finished_ = true;
+                dataAvailable_.notify_one();
+            }
+        }
+        if (worker_.joinable()) worker_.join();
+        if (target_) {
+            if (!target_->finish()) failed_ = true;
+            target_.reset();
+        }
+        return !failed_;
+    }
+
+private:
+    static const size_t kQueueDepth = 4;
+
+    bool failed() {
+        lock_guard<mutex> lock(mutex_);
+        return failed_;
+    }
+
+    void run() {
+        vector<char> block;
+        for (;;) {
+            bool last;
+            {
+                unique_lock<mutex> lock(mutex_);
+                if (block.capacity() > 0) spare_.push_back(std::move(block));
+                dataAvailable_.wait(lock, [this] { return !queue_.empty() || finished_; });
+                if (queue_.empty()) {
+                    block.clear();
+                    last = true;
+                }
+                else {
+                    block = std::move(queue_.front());
+                    queue_.pop_front();
+                    last = false;
+                }
+                spaceAvailable_.notify_one();
+            }
+            if (!encoder_->compress(block.data(), block.size(), last, *target_)) {
+                lock_guard<mutex> lock(mutex_);
+                failed_ = true;
+                spaceAvailable_.notify_all();
+                return;
+            }
+            if (last) return;
+        }
+    }
+
+    unique_ptr<OutputSink> target_;
+    unique_ptr<Encoder> encoder_;
+    mutex mutex_;
+    condition_variable dataAvailable_, spaceAvailable_;
+    deque<vector<char>> queue_;
+    vector<vector<char>> spare_; // 已压缩完的缓冲区，循环复用
+    bool finished_ = false;
+    bool failed_ = false;
+    thread worker_; // 最后初始化，保证线程启动时其他成员都已构造
+};
+
+// 打开大块异步写入的文件
+unique_ptr<OutputSink> openAsyncFileSink(const string& path, const AsyncWriteOptions& async, uint64_t sizeHint) {
+    unique_ptr<OutputFile> file(new OutputFile());
+    if (!file->open(path, async.direct)) return nullptr;
+    if (async.direct && !file->isUnbuffered()) {
+        cerr << "警告: " << path << " 所在的文件系统不支持直接I/O，改用经过页缓存的写入" << endl;
+    }
+    if (sizeHint > 0) file->preallocate(sizeHint);
+    return unique_ptr<OutputSink>(new AsyncFileSink(std::move(file), async));
+}
+
+unique_ptr<OutputSink> openOutputSink(const string& path, const CompressionOptions& compression, bool backgroundWrite,
+    const AsyncWriteOptions& async, uint64_t sizeHint) {
+    if (compression.method == Compression::None && async.enabled) return openAsyncFileSink(path, async, sizeHint);
+    if (compression.method == Compression::None && backgroundWrite) {
+        unique_ptr<FileSink> sink(new FileSink(path));
+        if (!sink->isOpen()) return nullptr;
+        return unique_ptr<OutputSink>(new BackgroundSink(std::move(sink), unique_ptr<Encoder>(new PassThroughEncoder())));
+    }
+    if (compression.method == Compression::None) {
+        unique_ptr<FileSink> sink(new FileSink(path));
+        if (!sink->isOpen()) return nullptr;
+        return sink;
+    }
+
+    unique_ptr<Encoder> encoder;
+#ifdef PLYTOOBJ_WITH_ZLIB
+    if (compression.method == Compression::Gzip) {
+        unique_ptr<GzipEncoder> gzip(new GzipEncoder(compression.level));
+        if (gzip->valid()) encoder = std::move(gzip);
+    }
+#endif
+#ifdef PLYTOOBJ_WITH_ZSTD
+    if (compression.method == Compression::Zstd) {
+        unique_ptr<ZstdEncoder> zstd(new ZstdEncoder(compression.level, compression.threadCount));
+        if (zstd->valid()) encoder = std::move(zstd);
+    }
+#endif
+    if (!encoder) {
+        cerr << "错误: " << (compression.method == Compression::Gzip ? "gzip" : "zstd") << " 压缩不可用"
+            << (compressionAvailable(compression.method) ? " (初始化失败)" : " (编译时未启用)") << endl;
+        return nullptr;
+    }
+    unique_ptr<OutputSink> target;
+    if (async.enabled) target = openAsyncFileSink(path, async, 0);
+    else {
+        unique_ptr<FileSink> sink(new FileSink(path, ios::out | ios::binary | ios::trunc));
+        if (sink->isOpen()) target = std::move(sink);
+    }
+    if (!target) return nullptr;
+    return unique_ptr<OutputSink>(new BackgroundSink(std::move(target), std::move(encoder)));
+}
@@ -0,0 +1,83 @@
+﻿// OutputSink.h : 输出字节流 (普通文件、流式压缩的 .gz / .zst 文件，或调用方的回调与字符串)
+//
+// gzip 需要在编译时定义 PLYTOOBJ_WITH_ZLIB 并链接 zlib，
+// zstd 需要定义 PLYTOOBJ_WITH_ZSTD 并链接 libzstd。未启用的压缩方式在运行时报错。
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+enum class Compression : uint8_t { None, Gzip, Zstd };
+
+struct CompressionOptions {
+    Compression method = Compression::None;
+    int level = 0;            // 压缩级别，0 表示使用该压缩方式的默认级别
+    unsigned threadCount = 1; // zstd 的压缩工作线程数 (gzip 总是在一个后台线程上压缩)
+};
+
+// 大块异步写入 (--async-io)：输出先复制到对齐的大块缓冲区，写满的块交给写入线程按偏移写入文件，
+// 同时有多个写入进行。输出按原样写入，Windows 上也不把换行转换为 CRLF。
+struct AsyncWriteOptions {
+    bool enabled = false;
+    bool direct = false;           // 绕过页缓存 (O_DIRECT / FILE_FLAG_NO_BUFFERING)，不支持时改用普通写入
+    size_t blockBytes = 8 << 20;   // 每次写入的字节数，向上对齐到 kDirectIOAlignment
+    unsigned depth = 4;            // 同时进行的写入数 (写入线程数)
+};
+
+// 解析 "none"、"gzip" (或 "gz")、"zstd" (或 "zst")
+bool parseCompression(const std::string& name, Compression& method);
+
+// 由文件扩展名推断压缩方式 (.gz / .zst)，其他扩展名返回 Compression::None
+Compression compressionForPath(const std::string& path);
+
+// 压缩方式对应的文件扩展名 (含点号)，None 返回空字符串
+const char* compressionExtension(Compression method);
+
+// 该压缩方式是否在编译时启用
+bool compressionAvailable(Compression method);
+
+// 输出字节流。write 按顺序追加数据，finish 写完剩余数据并关闭文件；任一步失败后返回 false。
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+    virtual bool write(const char* data, size_t size) = 0;
+    virtual bool finish() = 0;
+};
+
+// 把输出字节交给回调函数 (如写入套接字或内存缓冲区)，不经过文件，可以重复使用。
+// 回调返回 false 表示失败，之后的 write 和 finish 都返回 false，直到调用 reset。
+class CallbackSink : public OutputSink {
+public:
+    typedef std::function<bool(const char* data, size_t size)> Callback;
+
+    explicit CallbackSink(Callback callback);
+    bool write(const char* data, size_t size) override;
+    bool finish() override;
+    void reset(); // 清除失败状态，开始下一次输出
+
+private:
+    Callback callback_;
+    bool failed_ = false;
+};
+
+// 追加到字符串的输出，字符串的容量在多次输出之间保留
+class StringSink : public OutputSink {
+public:
+    explicit StringSink(std::string& out) : out_(out) {}
+    bool write(const char* data, size_t size) override;
+    bool finish() override;
+
+private:
+    std::string& out_;
+};
+
+// 打开输出文件。不压缩时与原来一样以文本模式写入；压缩时格式化的数据交给后台线程压缩，
+// 与格式化并行进行。backgroundWrite 为 true 时不压缩的输出也在后台线程上写入文件。
+// async.enabled 时文件改由大块异步写入 (压缩时写入压缩后的数据)，sizeHint > 0 时按该大小预分配
+// (不压缩的输出使用，偏大的部分在结束时截掉)。
+// 文件无法创建时返回空指针，由调用方报错；压缩方式不可用时另外输出原因。
+std::unique_ptr<OutputSink> openOutputSink(const std::string& path, const CompressionOptions& compression,
+    bool backgroundWrite = false, const AsyncWriteOptions& async = AsyncWriteOptions(), uint64_t sizeHint = 0);
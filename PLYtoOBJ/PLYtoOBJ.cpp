@@ -2,551 +2,390 @@
 //
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
-#include <map>
-#include <algorithm> // for std::reverse, std::find
-#include <cstdint>   // for uint32_t, int16_t etc.
-#include <type_traits> // for std::is_arithmetic
+#include <algorithm>
 #include <chrono>      // 用于计时
+#include <cstdlib>     // for atoi
+#include <fstream>
+#include <sstream>
 
-using namespace std;
-
-// --- (Vec2, Vec3, Vertex, Triangle 结构定义保持不变) ---
-// 自定义二维向量结构 (用于纹理坐标)
-struct Vec2 {
-    float u, v;
-    Vec2(float u = 0.0f, float v = 0.0f) : u(u), v(v) {}
-};
-
-// 自定义三维向量结构
-struct Vec3 {
-    float x, y, z;
-    Vec3(float x = 0.0f, float y = 0.0f, float z = 0.0f) : x(x), y(y), z(z) {}
-};
-
-// 扩展顶点数据结构
-struct Vertex {
-    Vec3 position;
-    Vec3 normal;
-    Vec3 color; // 存储为 0.0f - 1.0f 的浮点数
-    Vec2 texCoord;
-
-    bool has_normal = false;
-    bool has_color = false;
-    bool has_texCoord = false;
-};
-
-// 三角形面结构（存储三个顶点索引）
-struct Triangle {
-    int v0, v1, v2;
-};
-
-
-// 辅助结构，用于存储PLY属性信息
-struct PlyProperty {
-    string name;
-    string type_str; // PLY中的数据类型字符串，如 "float", "uchar"
-    // 对于列表属性 (如面索引)
-    bool is_list = false;
-    string count_type_str; // 列表的计数的类型 (e.g., uchar, ushort)
-    string list_item_type_str; // 列表项的类型 (e.g., int)
-
-    // 用于ASCII解析
-    int index_in_line = -1;
-};
-
-// 辅助函数：检查系统字节序
-bool isSystemLittleEndian() {
-    uint32_t i = 1;
-    char* c = (char*)&i;
-    return (*c == 1);
-}
+#include "BatchConvert.h"
+#include "MeshBinary.h"
+#include "MeshCache.h"
+#include "MeshTiling.h"
+#include "NumberFormat.h"
+#include "ObjWriter.h"
+#include "OutputSink.h"
+#include "ParallelChunks.h"
+#include "PlyInfo.h"
+#include "PlyReader.h"
+#include "Profile.h"
+#include "StreamConvert.h"
+#include "VertexCache.h"
+#include "VertexNormals.h"
+#include "VertexWeld.h"
 
-// 辅助函数：字节交换
-template<typename T>
-T swapBytes(T value) {
-    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "swapBytes can only be used with arithmetic or enum types");
-    char* bytes = reinterpret_cast<char*>(&value);
-    std::reverse(bytes, bytes + sizeof(T));
-    return value;
-}
+using namespace std;
 
-// 辅助模板函数：从文件读取二进制值并处理字节序
-template<typename T>
-bool readBinary(std::ifstream& file, T& value, bool fileIsLittleEndian, bool systemIsLittleEndian) {
-    if (!file.read(reinterpret_cast<char*>(&value), sizeof(T))) {
-        return false;
-    }
-    if (fileIsLittleEndian != systemIsLittleEndian) {
-        value = swapBytes(value);
+// 把 --profile 记录的结果写入文件，path 为 "-" 时输出到标准输出
+bool writeProfileFile(const string& path, ProfileMode mode) {
+    if (path == "-") {
+        writeProfileReport(cout, mode);
+        return true;
     }
-    return true;
-}
-
-// 特化版本，用于读取PLY颜色 (uchar) 并转换为 float (0-1)
-bool readBinaryColorComponent(std::ifstream& file, float& color_component, bool fileIsLittleEndian, bool systemIsLittleEndian) {
-    unsigned char uchar_val;
-    if (!readBinary(file, uchar_val, fileIsLittleEndian, systemIsLittleEndian)) { // uchar 不需要字节交换，但保持接口一致
+    ofstream out(path);
+    if (!out.is_open()) {
+        cerr << "错误: 无法创建性能记录文件 " << path << endl;
         return false;
     }
-    color_component = static_cast<float>(uchar_val) / 255.0f;
-    return true;
+    writeProfileReport(out, mode);
+    out.close();
+    return !out.fail();
 }
 
-
-// 读取PLY文件并提取顶点和三角形数据
-bool readPLY(const string& plyPath, vector<Vertex>& vertices_out, vector<Triangle>& triangles_out,
-    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords) {
-    ifstream file(plyPath, ios::in | ios::binary);
-    if (!file.is_open()) {
-        cerr << "错误: 无法打开PLY文件 " << plyPath << endl;
-        return false;
-    }
-
-    string line;
-    long vertexCount = 0, faceCount = 0;
-    bool headerEnd = false;
-    bool isASCII = true; // 默认为ASCII
-    bool plyFileIsLittleEndian = false; // PLY文件的字节序
-
-    vector<PlyProperty> vertexProperties;
-    PlyProperty faceProperty; // 假设只有一个面属性 "vertex_indices" 或 "vertex_index"
-    bool facePropertyDefined = false;
-
-    int currentPropertyIndexASCII = 0;
-
-    file_has_normals = false;
-    file_has_colors = false;
-    file_has_texCoords = false;
-
-    string currentElement = "";
-
-    while (getline(file, line)) {
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
-        if (line.empty() || line.rfind("comment", 0) == 0) continue;
-
-        istringstream iss(line);
-        string token;
-        iss >> token;
-
-        if (token == "ply") continue;
-        if (token == "format") {
-            string format_str, version_str;
-            iss >> format_str >> version_str;
-            if (format_str == "ascii") {
-                isASCII = true;
-            }
-            else if (format_str == "binary_little_endian") {
-                isASCII = false;
-                plyFileIsLittleEndian = true;
-            }
-            else if (format_str == "binary_big_endian") {
-                isASCII = false;
-                plyFileIsLittleEndian = false;
-            }
-            else {
-                cerr << "错误: 不支持的PLY格式: " << format_str << endl;
-                return false;
-            }
+int main(int argc, char** argv) {
+    PlyReadOptions readOptions;
+    ObjWriteOptions writeOptions;
+    StreamOptions streamOptions;
+    bool streaming = false;
+    bool batch = false;
+    bool info = false; // 只检查文件头，输出 JSON
+    bool weld = false;
+    WeldOptions weldOptions;
+    bool computeNormals = false;
+    NormalOptions normalOptions;
+    bool optimizeCache = false;
+    VertexCacheOptions cacheOptions;
+    MeshCacheOptions meshCacheOptions;
+    string binaryPath; // 非空时同时写入二进制网格
+    bool tiling = false; // 按空间网格分块输出
+    TileOptions tileOptions;
+    bool batchBinary = false;
+    bool compressionSet = false; // 未指定 --compress 时按输出文件扩展名决定
+    string profilePath; // 非空时记录各阶段耗时与计数器
+    ProfileMode profileMode = ProfileMode::Summary;
+    readOptions.threadCount = writeOptions.threadCount = defaultThreadCount();
+    vector<string> positional;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--no-mmap") readOptions.useMemoryMap = false;
+        else if (arg == "--threads" && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            readOptions.threadCount = writeOptions.threadCount = n > 0 ? static_cast<unsigned>(n) : 1;
         }
-        else if (token == "element") {
-            iss >> currentElement;
-            if (currentElement == "vertex") iss >> vertexCount;
-            else if (currentElement == "face") iss >> faceCount;
-            currentPropertyIndexASCII = 0;
+        else if (arg == "--stream") streaming = true;
+        else if (arg == "--pipeline") {
+            streamOptions.pipeline = true;
+            streaming = true;
         }
-        else if (token == "property") {
-            PlyProperty prop;
-            string type_or_list;
-            iss >> type_or_list;
-
-            if (type_or_list == "list") {
-                prop.is_list = true;
-                iss >> prop.count_type_str >> prop.list_item_type_str >> prop.name;
-            }
-            else {
-                prop.is_list = false;
-                prop.type_str = type_or_list;
-                iss >> prop.name;
+        else if (arg == "--batch") batch = true;
+        else if (arg == "--info") info = true;
+        else if (arg == "--weld") weld = true;
+        else if (arg == "--weld-eps" && i + 1 < argc) {
+            weldOptions.epsilon = static_cast<float>(atof(argv[++i]));
+            if (!(weldOptions.epsilon >= 0.0f)) {
+                cerr << "错误: 无效的焊接距离 " << argv[i] << endl;
+                return 1;
             }
-
-            if (currentElement == "vertex") {
-                prop.index_in_line = currentPropertyIndexASCII++;
-                vertexProperties.push_back(prop);
-                if (prop.name == "nx" || prop.name == "ny" || prop.name == "nz") file_has_normals = true;
-                if (prop.name == "red" || prop.name == "green" || prop.name == "blue" || prop.name == "alpha") file_has_colors = true;
-                if (prop.name == "u" || prop.name == "v" || prop.name == "s" || prop.name == "t" || prop.name == "texture_u" || prop.name == "texture_v") file_has_texCoords = true;
-            }
-            else if (currentElement == "face") {
-                if (prop.name == "vertex_indices" || prop.name == "vertex_index") {
-                    faceProperty = prop;
-                    facePropertyDefined = true;
-                }
-                else {
-                    // cerr << "警告: 面元素中存在未处理的属性: " << prop.name << endl;
-                }
+            weld = true;
+        }
+        else if (arg == "--optimize-cache") optimizeCache = true;
+        else if (arg == "--keep-polygons") readOptions.keepPolygons = true;
+        else if ((arg == "--attrs" && i + 1 < argc) || arg.rfind("--attrs=", 0) == 0) {
+            const string list = arg == "--attrs" ? argv[++i] : arg.substr(8);
+            if (!parseVertexAttributes(list, readOptions.attributes)) {
+                cerr << "错误: 无效的属性列表 " << list << " (可用: pos、normal、color、uv)" << endl;
+                return 1;
             }
         }
-        else if (token == "end_header") {
-            headerEnd = true;
-            // 对于二进制文件，头之后的第一件事就是数据，所以我们需要确保文件指针在正确的位置。
-            // getline 会消耗换行符。如果这是二进制文件，我们需要确保我们从下一行开始。
-            // 通常，二进制数据紧跟在 "end_header\n" 之后。
-            // 如果文件是以 ios::binary 打开的，getline 仍然有效，但读取二进制数据时要用 file.read()
-            break;
+        else if (arg == "--cache-dir" && i + 1 < argc) meshCacheOptions.directory = argv[++i];
+        else if (arg == "--cache-limit" && i + 1 < argc) {
+            long long mb = atoll(argv[++i]);
+            meshCacheOptions.sizeLimitBytes = static_cast<uint64_t>(mb > 0 ? mb : 0) << 20;
         }
-    }
-
-    if (!headerEnd) {
-        cerr << "错误: 无效的PLY文件头或未找到end_header" << endl;
-        return false;
-    }
-    if (faceCount > 0 && !facePropertyDefined) {
-        cerr << "错误: 定义了面元素但未找到 'vertex_indices' 或 'vertex_index' 属性。" << endl;
-        return false;
-    }
-
-
-    bool systemIsLE = isSystemLittleEndian();
-    vertices_out.resize(vertexCount);
-
-    // 读取顶点数据
-    for (long i = 0; i < vertexCount; ++i) {
-        Vertex currentVertex;
-        if (isASCII) {
-            if (!getline(file, line)) {
-                cerr << "错误: 读取ASCII顶点数据时意外结束 (顶点 " << i << "/" << vertexCount << ")" << endl;
-                return false;
-            }
-            if (line.empty() && i < vertexCount - 1) {
-                cerr << "错误: 读取ASCII顶点数据时遇到空行 (顶点 " << i << "/" << vertexCount << ")" << endl;
-                return false;
-            }
-            else if (line.empty()) continue;
-
-            istringstream iss(line);
-            vector<string> values_str;
-            string val_s;
-            while (iss >> val_s) {
-                values_str.push_back(val_s);
-            }
-
-            for (const auto& prop : vertexProperties) {
-                if (prop.index_in_line >= values_str.size()) {
-                    // cerr << "警告: ASCII顶点 " << i << " 的属性 " << prop.name << " 数据不足。" << endl;
-                    continue;
-                }
-                const string& str_val = values_str[prop.index_in_line];
-                float f_val = 0;
-                unsigned char uc_val = 0;
-                try {
-                    if (prop.type_str == "float" || prop.type_str == "float32" || prop.type_str == "double" || prop.type_str == "float64") {
-                        f_val = std::stof(str_val);
-                    }
-                    else if (prop.type_str == "uchar" || prop.type_str == "uint8" || prop.type_str == "char" || prop.type_str == "int8") {
-                        uc_val = static_cast<unsigned char>(std::stoi(str_val));
-                    }
-                    // 可以添加对其他整数类型的支持
-                }
-                catch (const std::invalid_argument& ia) {
-                    cerr << "错误: ASCII顶点 " << i << " 属性 " << prop.name << " 值无效: " << str_val << endl; continue;
-                }
-                catch (const std::out_of_range& oor) {
-                    cerr << "错误: ASCII顶点 " << i << " 属性 " << prop.name << " 值超出范围: " << str_val << endl; continue;
-                }
-
-
-                if (prop.name == "x") currentVertex.position.x = f_val;
-                else if (prop.name == "y") currentVertex.position.y = f_val;
-                else if (prop.name == "z") currentVertex.position.z = f_val;
-                else if (prop.name == "nx") { currentVertex.normal.x = f_val; currentVertex.has_normal = true; }
-                else if (prop.name == "ny") { currentVertex.normal.y = f_val; currentVertex.has_normal = true; }
-                else if (prop.name == "nz") { currentVertex.normal.z = f_val; currentVertex.has_normal = true; }
-                else if (prop.name == "red") { currentVertex.color.x = (prop.type_str == "uchar" || prop.type_str == "uint8") ? uc_val / 255.0f : f_val; currentVertex.has_color = true; }
-                else if (prop.name == "green") { currentVertex.color.y = (prop.type_str == "uchar" || prop.type_str == "uint8") ? uc_val / 255.0f : f_val; currentVertex.has_color = true; }
-                else if (prop.name == "blue") { currentVertex.color.z = (prop.type_str == "uchar" || prop.type_str == "uint8") ? uc_val / 255.0f : f_val; currentVertex.has_color = true; }
-                else if (prop.name == "u" || prop.name == "texture_u" || prop.name == "s") { currentVertex.texCoord.u = f_val; currentVertex.has_texCoord = true; }
-                else if (prop.name == "v" || prop.name == "texture_v" || prop.name == "t") { currentVertex.texCoord.v = f_val; currentVertex.has_texCoord = true; }
+        else if (arg == "--cache-hash") meshCacheOptions.hashContents = true;
+        else if (arg == "--binary" && i + 1 < argc) binaryPath = argv[++i];
+        else if (arg == "--batch-binary") batchBinary = true;
+        else if (arg == "--tiles" && i + 1 < argc) {
+            if (!parseTileGrid(argv[++i], tileOptions)) {
+                cerr << "错误: 无效的分块设置 " << argv[i] << endl;
+                return 1;
             }
+            tiling = true;
         }
-        else { // 二进制读取
-            for (const auto& prop : vertexProperties) {
-                if (prop.name == "x") { if (!readBinary(file, currentVertex.position.x, plyFileIsLittleEndian, systemIsLE)) return false; }
-                else if (prop.name == "y") { if (!readBinary(file, currentVertex.position.y, plyFileIsLittleEndian, systemIsLE)) return false; }
-                else if (prop.name == "z") { if (!readBinary(file, currentVertex.position.z, plyFileIsLittleEndian, systemIsLE)) return false; }
-                else if (prop.name == "nx") { if (!readBinary(file, currentVertex.normal.x, plyFileIsLittleEndian, systemIsLE)) return false; currentVertex.has_normal = true; }
-                else if (prop.name == "ny") { if (!readBinary(file, currentVertex.normal.y, plyFileIsLittleEndian, systemIsLE)) return false; currentVertex.has_normal = true; }
-                else if (prop.name == "nz") { if (!readBinary(file, currentVertex.normal.z, plyFileIsLittleEndian, systemIsLE)) return false; currentVertex.has_normal = true; }
-                else if (prop.name == "red") { if (!readBinaryColorComponent(file, currentVertex.color.x, plyFileIsLittleEndian, systemIsLE)) return false; currentVertex.has_color = true; }
-                else if (prop.name == "green") { if (!readBinaryColorComponent(file, currentVertex.color.y, plyFileIsLittleEndian, systemIsLE)) return false; currentVertex.has_color = true; }
-                else if (prop.name == "blue") { if (!readBinaryColorComponent(file, currentVertex.color.z, plyFileIsLittleEndian, systemIsLE)) return false; currentVertex.has_color = true; }
-                else if (prop.name == "alpha") { // 通常alpha是uchar，如果需要读取
-                    unsigned char alpha_val;
-                    if (!readBinary(file, alpha_val, plyFileIsLittleEndian, systemIsLE)) return false;
-                    // currentVertex.alpha = alpha_val / 255.0f; // 如果Vertex结构有alpha
-                }
-                else if (prop.name == "u" || prop.name == "texture_u" || prop.name == "s") { if (!readBinary(file, currentVertex.texCoord.u, plyFileIsLittleEndian, systemIsLE)) return false; currentVertex.has_texCoord = true; }
-                else if (prop.name == "v" || prop.name == "texture_v" || prop.name == "t") { if (!readBinary(file, currentVertex.texCoord.v, plyFileIsLittleEndian, systemIsLE)) return false; currentVertex.has_texCoord = true; }
-                else { // 跳过未知或不需要的二进制属性
-                    size_t typeSize = 0;
-                    if (prop.type_str == "char" || prop.type_str == "int8" || prop.type_str == "uchar" || prop.type_str == "uint8") typeSize = 1;
-                    else if (prop.type_str == "short" || prop.type_str == "int16" || prop.type_str == "ushort" || prop.type_str == "uint16") typeSize = 2;
-                    else if (prop.type_str == "int" || prop.type_str == "int32" || prop.type_str == "uint" || prop.type_str == "uint32" || prop.type_str == "float" || prop.type_str == "float32") typeSize = 4;
-                    else if (prop.type_str == "double" || prop.type_str == "float64") typeSize = 8;
-
-                    if (typeSize > 0) {
-                        file.seekg(typeSize, ios_base::cur);
-                        if (file.fail()) { cerr << "错误: 跳过二进制顶点属性 " << prop.name << " 时读取失败。" << endl; return false; }
-                    }
-                    else {
-                        cerr << "警告: 无法确定二进制顶点属性 " << prop.name << " (类型: " << prop.type_str << ") 的大小以跳过。" << endl;
-                    }
-                }
+        else if (arg == "--compress" && i + 1 < argc) {
+            if (!parseCompression(argv[++i], writeOptions.compression.method)) {
+                cerr << "错误: 未知的压缩方式 " << argv[i] << endl;
+                return 1;
             }
+            compressionSet = true;
         }
-        vertices_out[i] = currentVertex;
-    }
-
-    for (const auto& v : vertices_out) {
-        if (v.has_normal) file_has_normals = true;
-        if (v.has_color) file_has_colors = true;
-        if (v.has_texCoord) file_has_texCoords = true;
-    }
-
-    // 读取面数据
-    triangles_out.reserve(faceCount);
-    for (long i = 0; i < faceCount; ++i) {
-        unsigned char numFaceVertices_uchar = 0;
-        unsigned short numFaceVertices_ushort = 0;
-        uint32_t numFaceVertices_uint = 0;
-        int numFaceVertices = 0;
-
-        if (isASCII) {
-            if (!getline(file, line)) {
-                cerr << "错误: 读取ASCII面数据时意外结束 (面 " << i << "/" << faceCount << ")" << endl;
-                return false;
-            }
-            if (line.empty() && i < faceCount - 1) {
-                cerr << "错误: 读取ASCII面数据时遇到空行 (面 " << i << "/" << faceCount << ")" << endl;
-                return false;
-            }
-            else if (line.empty()) continue;
-            istringstream iss(line);
-            iss >> numFaceVertices;
+        else if (arg == "--compress-level" && i + 1 < argc) {
+            int level = atoi(argv[++i]);
+            writeOptions.compression.level = level > 0 ? level : 0;
         }
-        else { // 二进制
-            if (faceProperty.count_type_str == "uchar" || faceProperty.count_type_str == "uint8") {
-                if (!readBinary(file, numFaceVertices_uchar, plyFileIsLittleEndian, systemIsLE)) return false;
-                numFaceVertices = numFaceVertices_uchar;
-            }
-            else if (faceProperty.count_type_str == "ushort" || faceProperty.count_type_str == "uint16") {
-                if (!readBinary(file, numFaceVertices_ushort, plyFileIsLittleEndian, systemIsLE)) return false;
-                numFaceVertices = numFaceVertices_ushort;
-            }
-            else if (faceProperty.count_type_str == "uint" || faceProperty.count_type_str == "uint32") {
-                if (!readBinary(file, numFaceVertices_uint, plyFileIsLittleEndian, systemIsLE)) return false;
-                numFaceVertices = numFaceVertices_uint;
-            }
-            // 添加对其他计数类型的支持，如 short, int
+        else if (arg == "--async-io") writeOptions.asyncWrite.enabled = true;
+        else if (arg == "--direct-io") writeOptions.asyncWrite.enabled = writeOptions.asyncWrite.direct = true;
+        else if (arg == "--io-depth" && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            writeOptions.asyncWrite.depth = n > 0 ? static_cast<unsigned>(n) : 1;
+            writeOptions.asyncWrite.enabled = true;
+        }
+        else if (arg == "--io-block" && i + 1 < argc) {
+            long long mb = atoll(argv[++i]);
+            writeOptions.asyncWrite.blockBytes = static_cast<size_t>(mb > 0 ? mb : 1) << 20;
+            writeOptions.asyncWrite.enabled = true;
+        }
+        else if (arg == "--profile" && i + 1 < argc) profilePath = argv[++i];
+        else if (arg == "--profile-format" && i + 1 < argc) {
+            const string format = argv[++i];
+            if (format == "json") profileMode = ProfileMode::Summary;
+            else if (format == "chrome") profileMode = ProfileMode::Trace;
             else {
-                cerr << "错误: 不支持的面顶点计数的二进制类型: " << faceProperty.count_type_str << endl;
-                return false;
+                cerr << "错误: 未知的性能记录格式 " << format << endl;
+                return 1;
             }
         }
-
-        if (numFaceVertices < 3) {
-            // cerr << "警告: 面 " << i << " 的顶点数少于3 (" << numFaceVertices << ")。" << endl;
-            // 在二进制中，需要读取并丢弃这些索引以保持文件流同步
-            for (int j = 0; j < numFaceVertices; ++j) {
-                if (isASCII) {
-                    // 对于ASCII，如果整行已读入iss，则不需要额外操作来跳过
-                    // 但如果面数据不符合预期，iss的后续读取会失败
-                }
-                else {
-                    // 根据 faceProperty.list_item_type_str 跳过相应字节
-                    size_t itemSize = 0;
-                    if (faceProperty.list_item_type_str == "int8" || faceProperty.list_item_type_str == "uint8" || faceProperty.list_item_type_str == "char" || faceProperty.list_item_type_str == "uchar") itemSize = 1;
-                    else if (faceProperty.list_item_type_str == "int16" || faceProperty.list_item_type_str == "uint16" || faceProperty.list_item_type_str == "short" || faceProperty.list_item_type_str == "ushort") itemSize = 2;
-                    else if (faceProperty.list_item_type_str == "int32" || faceProperty.list_item_type_str == "uint32" || faceProperty.list_item_type_str == "int" || faceProperty.list_item_type_str == "uint") itemSize = 4;
-                    if (itemSize > 0) file.seekg(itemSize, ios_base::cur); else { cerr << "无法跳过无效面索引" << endl; return false; }
-                }
-            }
-            continue;
+        else if (arg == "--cache-size" && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            cacheOptions.cacheSize = n > 3 ? static_cast<unsigned>(n) : 3;
+            optimizeCache = true;
         }
-
-        vector<int> indices(numFaceVertices);
-        if (isASCII) {
-            // 从同一个istringstream对象中读取所有索引
-            istringstream iss_line_for_indices(line);
-            int temp_count;
-            iss_line_for_indices >> temp_count; // 读取并丢弃计数值
-            for (int j = 0; j < numFaceVertices; ++j) {
-                if (!(iss_line_for_indices >> indices[j])) {
-                    cerr << "错误: 读取ASCII面 " << i << " 的顶点索引 " << j << " 时出错。" << endl;
-                    return false;
-                }
-            }
+        else if (arg == "--weld-position-only") {
+            weldOptions.positionOnly = true;
+            weld = true;
         }
-        else { // 二进制
-            for (int j = 0; j < numFaceVertices; ++j) {
-                // 根据 faceProperty.list_item_type_str 读取索引
-                if (faceProperty.list_item_type_str == "int" || faceProperty.list_item_type_str == "int32") {
-                    if (!readBinary(file, indices[j], plyFileIsLittleEndian, systemIsLE)) return false;
-                }
-                else if (faceProperty.list_item_type_str == "uint" || faceProperty.list_item_type_str == "uint32") {
-                    uint32_t temp_idx;
-                    if (!readBinary(file, temp_idx, plyFileIsLittleEndian, systemIsLE)) return false;
-                    indices[j] = static_cast<int>(temp_idx);
-                }
-                else if (faceProperty.list_item_type_str == "short" || faceProperty.list_item_type_str == "int16") {
-                    int16_t temp_idx;
-                    if (!readBinary(file, temp_idx, plyFileIsLittleEndian, systemIsLE)) return false;
-                    indices[j] = static_cast<int>(temp_idx);
-                }
-                else if (faceProperty.list_item_type_str == "ushort" || faceProperty.list_item_type_str == "uint16") {
-                    uint16_t temp_idx;
-                    if (!readBinary(file, temp_idx, plyFileIsLittleEndian, systemIsLE)) return false;
-                    indices[j] = static_cast<int>(temp_idx);
-                }
-                else if (faceProperty.list_item_type_str == "uchar" || faceProperty.list_item_type_str == "uint8") {
-                    unsigned char temp_idx;
-                    if (!readBinary(file, temp_idx, plyFileIsLittleEndian, systemIsLE)) return false;
-                    indices[j] = static_cast<int>(temp_idx);
-                }
-                // 添加对其他索引类型的支持
-                else {
-                    cerr << "错误: 不支持的面索引的二进制类型: " << faceProperty.list_item_type_str << endl;
-                    return false;
-                }
+        else if (arg == "--normals" && i + 1 < argc) {
+            if (!parseNormalWeighting(argv[++i], normalOptions.weighting)) {
+                cerr << "错误: 无效的法线权重 " << argv[i] << " (可选: area、angle)" << endl;
+                return 1;
             }
+            computeNormals = true;
         }
-
-        if (numFaceVertices == 3) {
-            triangles_out.push_back({ indices[0], indices[1], indices[2] });
+        else if (arg == "--recompute-normals") {
+            normalOptions.overwrite = true;
+            computeNormals = true;
         }
-        else if (numFaceVertices > 3) {
-            for (int j = 1; j < numFaceVertices - 1; ++j) {
-                triangles_out.push_back({ indices[0], indices[j], indices[j + 1] });
+        else if (arg == "--stream-buffer" && i + 1 < argc) {
+            long long mb = atoll(argv[++i]);
+            streamOptions.bufferBytes = static_cast<size_t>(mb > 0 ? mb : 1) << 20;
+            streaming = true;
+        }
+        else if (arg == "--precision" && i + 1 < argc) {
+            if (!parseFloatFormat(argv[++i], writeOptions.floatFormat)) {
+                cerr << "错误: 无效的精度设置 " << argv[i] << endl;
+                return 1;
             }
         }
-    }
-    return true;
-}
-
-// 将顶点和三角形数据写入OBJ文件
-bool writeOBJ(const string& objPath, const vector<Vertex>& vertices, const vector<Triangle>& triangles,
-    bool has_normals, bool has_colors, bool has_texCoords) {
-    ofstream file(objPath);
-    if (!file.is_open()) {
-        cerr << "错误: 无法创建OBJ文件 " << objPath << endl;
-        return false;
-    }
-
-    file.imbue(std::locale::classic()); // 使用经典C区域设置，确保浮点数用点号表示
-
-    // 写入文件头
-    file << "# Converted from PLY to OBJ by PLYtoOBJ_Converter\n";
-    file << "# Vertices: " << vertices.size() << "\n";
-    file << "# Faces: " << triangles.size() << "\n";
-    if (has_normals) file << "# Has Normals\n";
-    if (has_colors) file << "# Has Vertex Colors (appended to 'v' lines as r g b)\n";
-    if (has_texCoords) file << "# Has Texture Coordinates\n";
-    file << "\n";
-
-    // 写入顶点数据 (格式: v x y z [r g b])
-    for (const auto& v_data : vertices) {
-        file << "v " << v_data.position.x << " " << v_data.position.y << " " << v_data.position.z;
-        if (v_data.has_color) { // 使用每个顶点自己的标志
-            file << " " << v_data.color.x << " " << v_data.color.y << " " << v_data.color.z;
+        else if (arg.rfind("--", 0) == 0) {
+            cerr << "错误: 未知选项 " << arg << endl;
+            return 1;
         }
-        file << "\n";
+        else positional.push_back(arg);
     }
-    file << "\n";
 
-    // 写入纹理坐标 (格式: vt u v)
-    if (has_texCoords) {
-        for (const auto& v_data : vertices) {
-            if (v_data.has_texCoord) { // 确保只为有纹理坐标的顶点写入vt
-                file << "vt " << v_data.texCoord.u << " " << v_data.texCoord.v << "\n";
-            }
-            else { // OBJ需要为每个顶点提供vt，如果某些顶点没有，可以输出0 0
-                file << "vt 0 0\n";
+    if (info && !positional.empty()) {
+        // 各文件在工作线程上并行检查，结果按输入顺序每行输出一个 JSON 对象
+        vector<string> paths;
+        if (batch) {
+            for (const string& source : positional) {
+                vector<BatchJob> jobs;
+                if (!collectBatchJobs(source, ".", jobs)) return 1;
+                for (const BatchJob& job : jobs) paths.push_back(job.input);
             }
         }
-        file << "\n";
+        else paths = positional;
+        PlyInfoOptions infoOptions;
+        infoOptions.keepPolygons = readOptions.keepPolygons;
+        infoOptions.floatFormat = writeOptions.floatFormat;
+        infoOptions.attributes = readOptions.attributes;
+        vector<uint8_t> inspected(paths.size(), 0);
+        processChunksInOrder(paths.size(), readOptions.threadCount,
+            [&](size_t job, string& buffer) {
+                ostringstream out;
+                PlyInfo plyInfo;
+                inspected[job] = inspectPLY(paths[job], plyInfo, infoOptions);
+                if (inspected[job]) writePlyInfoJSON(out, paths[job], plyInfo);
+                else writePlyInfoFailureJSON(out, paths[job]);
+                buffer = out.str();
+            },
+            [&](const string& buffer) {
+                cout.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+                return static_cast<bool>(cout);
+            });
+        cout.flush();
+        return std::count(inspected.begin(), inspected.end(), 0) == 0 ? 0 : 1;
     }
 
-    // 写入法线数据 (格式: vn x y z)
-    if (has_normals) {
-        for (const auto& v_data : vertices) {
-            if (v_data.has_normal) { // 确保只为有法线的顶点写入vn
-                file << "vn " << v_data.normal.x << " " << v_data.normal.y << " " << v_data.normal.z << "\n";
-            }
-            else { // OBJ需要为每个顶点提供vn，如果某些顶点没有，可以输出0 0 1 (默认向上)
-                file << "vn 0 0 1\n";
-            }
-        }
-        file << "\n";
+    if (positional.size() != 2) {
+        cout << "用法: " << argv[0] << " [选项] <输入.ply> <输出.obj>\n";
+        cout << "      " << argv[0] << " [选项] --batch <目录|通配符|清单文件> <输出目录>\n";
+        cout << "      " << argv[0] << " [选项] --info [--batch] <输入.ply|目录|通配符|清单文件> ...\n";
+        cout << "示例: " << argv[0] << " model.ply model.obj\n";
+        cout << "输入可以是 gzip / zstd 压缩的PLY文件 (如 model.ply.gz)，或用 - 从标准输入读取\n";
+        cout << "选项:\n";
+        cout << "  --no-mmap    读取PLY时不使用内存映射，改用流式读取\n";
+        cout << "  --threads N  解析ASCII数据和格式化输出使用的线程数 (默认: " << defaultThreadCount() << ")\n";
+        cout << "  --precision P  浮点数输出精度: N (N位有效数字，默认6)、shortest (最短可往返表示)\n";
+        cout << "                 或 fixedN (小数点后N位)\n";
+        cout << "  --stream     流式转换：边解码边输出，不把整个网格载入内存 (需要能内存映射输入)\n";
+        cout << "  --pipeline   流水线转换：在流式转换的基础上由预读线程提前读入输入，由写入线程写出文件，\n";
+        cout << "               读取、解码与格式化、写入重叠进行，并输出各阶段耗时；隐含 --stream\n";
+        cout << "  --stream-buffer MB  流式转换的缓冲区上限，单位MB (默认: " << (StreamOptions().bufferBytes >> 20) << ")，隐含 --stream\n";
+        cout << "  --batch      批量转换：输入为目录 (其中的 .ply 文件)、通配符模式 (如 \"tiles/*.ply\")\n";
+        cout << "               或清单文件 (每行一个输入路径，可用制表符分隔后跟输出路径)\n";
+        cout << "  --info       只解析文件头，每个文件输出一行 JSON：顶点数、面数、属性列表与类型、记录长度，\n";
+        cout << "               以及按 --precision / --keep-polygons / --attrs 估计的OBJ大小和内存需求。\n";
+        cout << "               与 --batch 同用时输入按批量转换的规则展开\n";
+        cout << "  --keep-polygons  保留多边形面，按原顶点数输出 f 行 (默认扇形三角化)\n";
+        cout << "  --attrs LIST     只读取并输出列出的顶点属性 (逗号分隔: pos、normal、color、uv；位置总是输出)，\n";
+        cout << "                   其余属性解码时直接跳过，如 --attrs=pos 只输出位置和面\n";
+        cout << "  --weld       合并完全相同的重复顶点 (位置及法线、颜色、纹理坐标均相同)\n";
+        cout << "  --weld-eps E 合并位置距离不超过 E 的顶点，隐含 --weld\n";
+        cout << "  --weld-position-only  焊接时只比较位置，隐含 --weld\n";
+        cout << "  --normals W  网格没有法线时由面计算顶点法线，W 为 area (按面积加权) 或 angle (按角度加权)\n";
+        cout << "  --recompute-normals  忽略文件中的法线，总是重新计算 (默认按面积加权)，隐含 --normals\n";
+        cout << "  --optimize-cache  按顶点后变换缓存重排三角形 (Tipsify)，并按首次使用顺序重排顶点\n";
+        cout << "  --cache-size N    优化和ACMR统计使用的FIFO缓存大小 (默认: " << VertexCacheOptions().cacheSize << ")，隐含 --optimize-cache\n";
+        cout << "  --cache-dir DIR   把解码后的网格缓存在 DIR 中，再次转换同一文件时跳过解析\n";
+        cout << "  --cache-limit MB  缓存目录的大小上限 (默认: " << (MeshCacheOptions().sizeLimitBytes >> 20) << ")，超出时删除最久未使用的条目\n";
+        cout << "  --cache-hash      按文件内容的哈希查找缓存 (默认按路径、大小和修改时间)\n";
+        cout << "  --binary PATH     同时写入可直接内存映射的二进制网格 (对齐的属性流 + 16/32/64位索引)\n";
+        cout << "  --batch-binary    批量转换时在每个OBJ旁写入同名的 .pmesh 二进制网格\n";
+        cout << "  --tiles XxYxZ     按包围盒的均匀网格分块输出 (N 表示 NxNxN)：每个面按重心归入一块，\n";
+        cout << "                    每块写为只含自己顶点的OBJ (model.obj -> model_x_y_z.obj)，各块并行写出\n";
+        cout << "  --compress M      压缩输出的OBJ文件: gzip、zstd 或 none (默认按输出扩展名 .gz / .zst 决定)，\n";
+        cout << "                    批量转换时为输出文件名追加对应扩展名\n";
+        cout << "  --compress-level N  压缩级别 (默认使用压缩库的默认级别)\n";
+        cout << "  --async-io        OBJ输出改为大块异步写入：多个对齐的大块同时写入，并按估计的大小预分配文件\n";
+        cout << "                    (换行总是 LF)\n";
+        cout << "  --direct-io       在 --async-io 的基础上绕过页缓存 (O_DIRECT / FILE_FLAG_NO_BUFFERING)，\n";
+        cout << "                    写出很大的文件时不挤占其他程序的页缓存；文件系统不支持时改用普通写入\n";
+        cout << "  --io-depth N      同时进行的写入数 (默认: " << AsyncWriteOptions().depth << ")，隐含 --async-io\n";
+        cout << "  --io-block MB     每次写入的大小，单位MB (默认: " << (AsyncWriteOptions().blockBytes >> 20) << ")，隐含 --async-io\n";
+        cout << "  --profile FILE    把各阶段耗时 (各线程累计)、CPU时间、读写字节数、内存分配次数和峰值内存\n";
+        cout << "                    写入 FILE (- 表示标准输出)\n";
+        cout << "  --profile-format F  性能记录格式: json (汇总，默认) 或 chrome (Chrome 跟踪格式，含每段计时)\n";
+        return 1;
+    }
+    if (readOptions.keepPolygons && (optimizeCache || !binaryPath.empty() || batchBinary)) {
+        cerr << "错误: 保留多边形时不支持顶点缓存优化和二进制网格输出 (二者需要三角形网格)" << endl;
+        return 1;
+    }
+    if (tiling && (streaming || batch)) {
+        cerr << "错误: 流式转换和批量转换不支持分块输出" << endl;
+        return 1;
+    }
+    if ((weld || computeNormals || optimizeCache || !binaryPath.empty() || batchBinary) && streaming) {
+        cerr << "错误: 流式转换不支持顶点焊接、法线计算、顶点缓存优化和二进制网格输出" << endl;
+        return 1;
+    }
+    weldOptions.threadCount = readOptions.threadCount;
+    normalOptions.threadCount = readOptions.threadCount;
+    tileOptions.threadCount = readOptions.threadCount;
+    writeOptions.compression.threadCount = readOptions.threadCount;
+    if (!compressionSet && !batch) writeOptions.compression.method = compressionForPath(positional[1]);
+    if (!compressionAvailable(writeOptions.compression.method)) {
+        cerr << "错误: " << (writeOptions.compression.method == Compression::Gzip ? "gzip" : "zstd")
+            << " 压缩在编译时未启用" << endl;
+        return 1;
     }
 
-    // 写入面数据
-    // 格式: f v1[/vt1][/vn1] v2[/vt2][/vn2] v3[/vt3][/vn3]
-    // OBJ索引从1开始
-    for (const auto& tri : triangles) {
-        file << "f";
-        for (int k = 0; k < 3; ++k) {
-            int v_idx = -1;
-            if (k == 0) v_idx = tri.v0;
-            else if (k == 1) v_idx = tri.v1;
-            else v_idx = tri.v2;
-
-            file << " " << v_idx + 1; // 顶点索引
-
-            if (has_texCoords) {
-                file << "/" << v_idx + 1; // 纹理坐标索引 (与顶点索引相同)
-            }
-            else if (has_normals) { // 如果没有纹理坐标但有法线
-                file << "/";
-            }
-
+    if (!profilePath.empty()) startProfiling(profileMode);
 
-            if (has_normals) {
-                file << "/" << v_idx + 1; // 法线索引 (与顶点索引相同)
+    if (batch) {
+        auto batch_start_time = std::chrono::high_resolution_clock::now();
+        vector<BatchJob> jobs;
+        if (!collectBatchJobs(positional[0], positional[1], jobs)) {
+            return 1;
+        }
+        if (jobs.empty()) {
+            cerr << "错误: 没有找到要转换的PLY文件: " << positional[0] << endl;
+            return 1;
+        }
+        if (compressionSet) {
+            const char* extension = compressionExtension(writeOptions.compression.method);
+            for (BatchJob& job : jobs) {
+                if (compressionForPath(job.output) != writeOptions.compression.method) job.output += extension;
             }
         }
-        file << "\n";
-    }
-
-    return true;
-}
-
-int main(int argc, char** argv) {
-    if (argc != 3) {
-        cout << "用法: " << argv[0] << " <输入.ply> <输出.obj>\n";
-        cout << "示例: " << argv[0] << " model.ply model.obj\n";
-        return 1;
+        BatchOptions batchOptions;
+        batchOptions.threadCount = readOptions.threadCount;
+        batchOptions.readOptions = readOptions;
+        batchOptions.writeOptions = writeOptions;
+        batchOptions.streaming = streaming;
+        batchOptions.streamOptions = streamOptions;
+        batchOptions.weld = weld;
+        batchOptions.weldOptions = weldOptions;
+        batchOptions.computeNormals = computeNormals;
+        batchOptions.normalOptions = normalOptions;
+        batchOptions.optimizeCache = optimizeCache;
+        batchOptions.cacheOptions = cacheOptions;
+        batchOptions.meshCache = meshCacheOptions;
+        batchOptions.writeBinary = batchBinary;
+
+        cout << "批量转换: " << jobs.size() << " 个文件 -> " << positional[1] << endl;
+        vector<BatchResult> results = runBatch(jobs, batchOptions);
+        size_t failed = printBatchSummary(cout, jobs, results);
+        auto batch_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - batch_start_time);
+        cout << "总耗时: " << batch_duration.count() << "毫秒" << endl;
+        if (!profilePath.empty() && !writeProfileFile(profilePath, profileMode)) return 1;
+        return failed == 0 ? 0 : 1;
     }
 
     // 记录总开始时间
     auto total_start_time = std::chrono::high_resolution_clock::now();
 
-    string plyPath = argv[1];
-    string objPath = argv[2];
+    string plyPath = positional[0];
+    string objPath = positional[1];
 
-    vector<Vertex> vertices;
-    vector<Triangle> triangles;
+    Mesh mesh;
     bool has_normals, has_colors, has_texCoords;
 
     cout << "正在转换: " << plyPath << " -> " << objPath << endl;
 
+    if (streaming) {
+        size_t vertexCount = 0, triangleCount = 0;
+        StreamStats streamStats;
+        if (!convertPLYToOBJStreaming(plyPath, objPath, readOptions, writeOptions, streamOptions,
+            vertexCount, triangleCount, has_normals, has_colors, has_texCoords, &streamStats)) {
+            cerr << "转换失败: 流式转换出错" << endl;
+            return 1;
+        }
+        auto total_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - total_start_time);
+        cout << "流式转换: " << vertexCount << " 个顶点, " << triangleCount
+            << (readOptions.keepPolygons ? " 个多边形面" : " 个三角形面") << endl;
+        if (has_normals) cout << "  文件包含法线数据." << endl;
+        if (has_colors) cout << "  文件包含颜色数据." << endl;
+        if (has_texCoords) cout << "  文件包含纹理坐标数据." << endl;
+        // 解码与格式化是各工作线程的累计时间，按线程数折算后与其他阶段比较
+        const unsigned threads = std::max(1u, writeOptions.threadCount);
+        const long long computeMs = (streamStats.decodeMs + streamStats.formatMs) / threads;
+        cout << "数据体索引耗时: " << streamStats.indexMs << "毫秒" << endl;
+        if (streamOptions.pipeline) cout << "预读耗时: " << streamStats.prefetchMs << "毫秒" << endl;
+        cout << "解码耗时: " << streamStats.decodeMs << "毫秒, 格式化耗时: " << streamStats.formatMs
+            << "毫秒 (" << threads << " 个线程累计)" << endl;
+        cout << "写入耗时: " << streamStats.writeMs << "毫秒" << endl;
+        if (streamOptions.pipeline) {
+            const char* limiting = "解码与格式化";
+            if (streamStats.writeMs >= computeMs && streamStats.writeMs >= streamStats.prefetchMs) limiting = "写入";
+            else if (streamStats.prefetchMs >= computeMs) limiting = "读取";
+            cout << "限制阶段: " << limiting << endl;
+        }
+        cout << "转换成功! 已生成OBJ文件: " << objPath << endl;
+        cout << "总耗时: " << total_duration.count() << "毫秒" << endl;
+        if (!profilePath.empty() && !writeProfileFile(profilePath, profileMode)) return 1;
+        return 0;
+    }
+
     // 计时PLY读取
     auto read_start_time = std::chrono::high_resolution_clock::now();
-    bool read_success = readPLY(plyPath, vertices, triangles, has_normals, has_colors, has_texCoords);
+    bool cacheHit = false;
+    bool read_success = readPLYCached(plyPath, mesh, has_normals, has_colors, has_texCoords, readOptions,
+        meshCacheOptions, cacheHit);
     auto read_end_time = std::chrono::high_resolution_clock::now();
     auto read_duration = std::chrono::duration_cast<std::chrono::milliseconds>(read_end_time - read_start_time);
 
@@ -555,17 +394,55 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    cout << "读取成功: " << vertices.size() << " 个顶点, "
-        << triangles.size() << " 个三角形面" << endl;
+    cout << "读取成功: " << mesh.vertexCount() << " 个顶点, "
+        << mesh.faceCount() << (mesh.hasPolygons() ? " 个多边形面" : " 个三角形面") << endl;
     if (has_normals) cout << "  文件包含法线数据." << endl;
     if (has_colors) cout << "  文件包含颜色数据." << endl;
     if (has_texCoords) cout << "  文件包含纹理坐标数据." << endl;
+    if (cacheHit) cout << "  网格来自缓存." << endl;
     cout << "PLY读取耗时: " << read_duration.count() << "毫秒" << endl;
 
+    if (weld) {
+        auto weld_start_time = std::chrono::high_resolution_clock::now();
+        WeldStats weldStats = weldVertices(mesh, weldOptions);
+        auto weld_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - weld_start_time);
+        cout << "顶点焊接: " << weldStats.verticesBefore << " -> " << weldStats.verticesAfter << " 个顶点" << endl;
+        cout << "顶点焊接耗时: " << weld_duration.count() << "毫秒" << endl;
+    }
+
+    if (computeNormals) {
+        auto normals_start_time = std::chrono::high_resolution_clock::now();
+        NormalStats normalStats = computeVertexNormals(mesh, normalOptions);
+        auto normals_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - normals_start_time);
+        if (normalStats.computed) {
+            has_normals = true;
+            cout << "法线计算: " << (normalOptions.weighting == NormalWeighting::Angle ? "按角度加权" : "按面积加权");
+            if (normalStats.isolatedVertices > 0) cout << ", " << normalStats.isolatedVertices << " 个顶点没有有效的面";
+            cout << endl;
+            cout << "法线计算耗时: " << normals_duration.count() << "毫秒" << endl;
+        }
+        else cout << "法线计算: 文件已包含法线，跳过 (使用 --recompute-normals 重新计算)" << endl;
+    }
+
+    if (optimizeCache) {
+        auto cache_start_time = std::chrono::high_resolution_clock::now();
+        VertexCacheStats cacheStats = optimizeVertexCache(mesh, cacheOptions);
+        auto cache_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - cache_start_time);
+        cout << "顶点缓存优化: ACMR " << cacheStats.acmrBefore << " -> " << cacheStats.acmrAfter
+            << " (FIFO " << cacheOptions.cacheSize << ")" << endl;
+        cout << "顶点缓存优化耗时: " << cache_duration.count() << "毫秒" << endl;
+    }
+
 
     // 计时OBJ写入
     auto write_start_time = std::chrono::high_resolution_clock::now();
-    bool write_success = writeOBJ(objPath, vertices, triangles, has_normals, has_colors, has_texCoords);
+    TileStats tileStats;
+    bool write_success = tiling
+        ? writeOBJTiles(objPath, mesh, has_normals, has_colors, has_texCoords, tileOptions, writeOptions, tileStats)
+        : writeOBJ(objPath, mesh, has_normals, has_colors, has_texCoords, writeOptions);
     auto write_end_time = std::chrono::high_resolution_clock::now();
     auto write_duration = std::chrono::duration_cast<std::chrono::milliseconds>(write_end_time - write_start_time);
 
@@ -577,9 +454,27 @@ int main(int argc, char** argv) {
     auto total_end_time = std::chrono::high_resolution_clock::now();
     auto total_duration = std::chrono::duration_cast<std::chrono::milliseconds>(total_end_time - total_start_time);
 
+    if (tiling) {
+        cout << "分块输出: " << tileOptions.gridX << "x" << tileOptions.gridY << "x" << tileOptions.gridZ << " 网格, "
+            << tileStats.tileCount << " 个非空块, 最大块 " << tileStats.maxTileVertices << " 个顶点, 边界处重复 "
+            << tileStats.duplicatedVertices << " 个顶点" << endl;
+    }
     cout << "OBJ写入耗时: " << write_duration.count() << "毫秒" << endl;
-    cout << "转换成功! 已生成OBJ文件: " << objPath << endl;
+
+    if (!binaryPath.empty()) {
+        auto binary_start_time = std::chrono::high_resolution_clock::now();
+        if (!writeMeshBinaryOutput(binaryPath, mesh, has_normals, has_colors, has_texCoords)) {
+            cerr << "转换失败: 二进制网格写入错误" << endl;
+            return 1;
+        }
+        auto binary_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - binary_start_time);
+        cout << "二进制网格写入耗时: " << binary_duration.count() << "毫秒 (" << binaryPath << ")" << endl;
+    }
+    if (tiling) cout << "转换成功! 已生成 " << tileStats.tileCount << " 个OBJ文件: " << tilePath(objPath, 0, 0, 0) << " ..." << endl;
+    else cout << "转换成功! 已生成OBJ文件: " << objPath << endl;
     cout << "总耗时: " << total_duration.count() << "毫秒" << endl;
+    if (!profilePath.empty() && !writeProfileFile(profilePath, profileMode)) return 1;
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+﻿// ParallelChunks.cpp : processChunksInOrder 的实现
+//
+
+#include "ParallelChunks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+unsigned defaultThreadCount() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+void runParallel(size_t taskCount, unsigned threadCount, const std::function<void(size_t task)>& task) {
+    if (threadCount <= 1 || taskCount <= 1) {
+        for (size_t i = 0; i < taskCount; ++i) task(i);
+        return;
+    }
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < taskCount; i = next++) task(i);
+    };
+    std::vector<std::thread> workers;
+    const size_t workerCount = std::min<size_t>(threadCount, taskCount);
+    for (size_t t = 1; t < workerCount; ++t) {
+        workers.emplace_back(worker);
+    }
+    worker(); // 调用线程也参与执行
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+bool processChunksInOrder(size_t jobCount, unsigned threadCount,
+    const std::function<void(size_t job, std::string& buffer)>& format,
+    const std::function<bool(const std::string& buffer)>& consume) {
+    // 块缓冲区按调用线程复用：同一线程上的多次调用 (如批量转换中依次写出的各文件) 不重新分配
+    thread_local std::vector<std::string> slotPool;
+    std::vector<std::string>& slots = slotPool; // 工作线程通过引用访问调用线程的缓冲区
+    if (threadCount <= 1 || jobCount <= 1) {
+        if (slots.empty()) slots.resize(1);
+        std::string& buffer = slots[0];
+        for (size_t job = 0; job < jobCount; ++job) {
+            buffer.clear();
+            format(job, buffer);
+            if (!consume(buffer)) return false;
+        }
+        return true;
+    }
+
+    // 第 job 块使用 slots[job % window]。工作线程只领取 job < nextToConsume + window 的块，
+    // 因此某个槽位在其上一块被输出之前不会被覆盖。
+    const size_t window = static_cast<size_t>(threadCount) * 2;
+    if (slots.size() < window) slots.resize(window);
+    std::vector<char> ready(window, 0);
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t nextJob = 0;
+    size_t nextToConsume = 0;
+    bool stop = false;
+
+    auto worker = [&]() {
+        for (;;) {
+            size_t job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return stop || nextJob >= jobCount || nextJob < nextToConsume + window; });
+                if (stop || nextJob >= jobCount) return;
+                job = nextJob++;
+            }
+            std::string& buffer = slots[job % window];
+            buffer.clear();
+            format(job, buffer);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready[job % window] = 1;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const size_t workerCount = std::min<size_t>(threadCount, jobCount);
+    for (size_t t = 0; t < workerCount; ++t) {
+        workers.emplace_back(worker);
+    }
+
+    bool ok = true;
+    for (size_t job = 0; job < jobCount; ++job) {
+        const size_t slot = job % window;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return ready[slot] != 0; });
+        }
+        // 槽位在 ready 期间只属于调用线程，输出时无需持锁
+        ok = consume(slots[slot]);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready[slot] = 0;
+            ++nextToConsume;
+            if (!ok) stop = true;
+        }
+        cv.notify_all();
+        if (!ok) break;
+    }
+
+    for (auto& t : workers) {
+        t.join();
+    }
+    return ok;
+}
@@ -0,0 +1,24 @@
+﻿// ParallelChunks.h : 多线程格式化、按顺序输出的分块处理
+//
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// 由工作线程并行调用 format(job, buffer) 生成第 job 块的内容，
+// 再在调用线程中严格按 0, 1, 2, ... 的顺序把每块交给 consume。
+// 同一时刻最多只有 2 * threadCount 个已格式化、尚未输出的块，内存占用有界；
+// 块缓冲区会被循环复用，并在同一调用线程的多次调用之间保留。threadCount <= 1 时在调用线程中顺序执行。
+// format 和 consume 中不能再调用 processChunksInOrder。
+// consume 返回 false 时停止处理并返回 false。
+bool processChunksInOrder(size_t jobCount, unsigned threadCount,
+    const std::function<void(size_t job, std::string& buffer)>& format,
+    const std::function<bool(const std::string& buffer)>& consume);
+
+// 在最多 threadCount 个线程上执行 task(0) ... task(taskCount - 1)，任务按序号动态领取。
+// threadCount <= 1 时在调用线程中顺序执行。所有任务完成后返回。
+void runParallel(size_t taskCount, unsigned threadCount, const std::function<void(size_t task)>& task);
+
+// 默认的工作线程数 (硬件并发数，无法获取时为1)
+unsigned defaultThreadCount();
@@ -0,0 +1,266 @@
+﻿// PlyDecode.h : PLY 文件头解析与数据体解码的公共构件
+//
+// readPLY 与流式转换共用这里的解码计划和逐块解码函数。
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Mesh.h"
+
+// PLY标量类型，在解析文件头时由类型字符串解析一次
+enum class PlyType : uint8_t {
+    Invalid, Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64
+};
+
+// 辅助结构，用于存储PLY属性信息
+struct PlyProperty {
+    std::string name;
+    std::string type_str; // PLY中的数据类型字符串，如 "float", "uchar"
+    PlyType type = PlyType::Invalid;
+    // 对于列表属性 (如面索引)
+    bool is_list = false;
+    std::string count_type_str; // 列表的计数的类型 (e.g., uchar, ushort)
+    std::string list_item_type_str; // 列表项的类型 (e.g., int)
+    PlyType count_type = PlyType::Invalid;
+    PlyType list_item_type = PlyType::Invalid;
+
+    // 用于ASCII解析
+    int index_in_line = -1;
+};
+
+// 辅助函数：字节交换
+template<typename T>
+T swapBytes(T value) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "swapBytes can only be used with arithmetic or enum types");
+    char* bytes = reinterpret_cast<char*>(&value);
+    std::reverse(bytes, bytes + sizeof(T));
+    return value;
+}
+
+// PLY文件头中解析出的信息
+struct PlyHeader {
+    int64_t vertexCount = 0, faceCount = 0;
+    bool isASCII = true; // 默认为ASCII
+    bool fileIsLittleEndian = false; // PLY文件的字节序
+
+    std::vector<PlyProperty> vertexProperties;
+    std::vector<PlyProperty> faceProperties; // 面元素的全部属性 (按文件中的顺序)
+    PlyProperty faceProperty; // 假设只有一个面属性 "vertex_indices" 或 "vertex_index"
+    bool facePropertyDefined = false;
+};
+
+// 顶点属性数组的序号
+enum class VertexAttribute : uint8_t { Position, Normal, Color, TexCoord };
+const size_t kVertexAttributeCount = 4;
+
+static_assert(sizeof(Vec3) == 3 * sizeof(float) && sizeof(Vec2) == 2 * sizeof(float),
+    "Vec2/Vec3 必须是紧密排列的 float，解码时按 float 数组访问");
+
+// 各属性数组按 float 访问的起始位置，下标为 VertexAttribute
+struct VertexFloatStreams {
+    float* data[kVertexAttributeCount];
+
+    explicit VertexFloatStreams(const VertexStreams& s)
+        : data{ reinterpret_cast<float*>(s.positions), reinterpret_cast<float*>(s.normals),
+            reinterpret_cast<float*>(s.colors), reinterpret_cast<float*>(s.texCoords) } {}
+};
+
+// 单个顶点属性的解码步骤：从记录的 srcOffset 处读取 type 类型的值，
+// 转换为 float 后写入 attribute 数组中每个顶点的第 component 个分量
+struct PlyFieldOp {
+    uint32_t srcOffset;
+    uint32_t fieldIndex; // 属性在元素中的序号，即ASCII行中的字段序号
+    PlyType type;
+    VertexAttribute attribute;
+    uint8_t component;
+    uint8_t width;       // 该属性每个顶点的分量数 (Vec3 为 3，Vec2 为 2)
+    float divisor; // 颜色归一化的除数 (uchar 为 255)，0 表示直接转换
+
+    float* target(const VertexFloatStreams& out, size_t k) const {
+        return out.data[static_cast<size_t>(attribute)] + k * width + component;
+    }
+};
+
+// 常见的定长顶点布局，有编译期特化的解码路径
+enum class VertexLayout : uint8_t {
+    Generic,   // 其他任意布局，按 ops 逐属性解码
+    XYZ,       // float x, y, z
+    XYZNormal, // float x, y, z, nx, ny, nz
+    XYZColor,  // float x, y, z + uchar red, green, blue
+    XYZPrefix  // 记录以 float x, y, z 开头，之后的属性都不解码 (步长任意，记录的其余字节不被访问)
+};
+
+// 二进制顶点记录的解码计划，在读取文件头后构建一次。
+// 顶点记录是定长的，热循环只按计划执行，不再做任何字符串比较。
+struct VertexDecodePlan {
+    std::vector<PlyFieldOp> ops; // 只包含需要解码的属性，跳过的属性只体现在 stride 中
+    size_t stride = 0;      // 每条顶点记录的字节数
+    bool swap = false;      // 文件与系统字节序不同，需要字节交换
+    bool bulkSwap32 = false; // 需要交换且所有属性都是32位，可整块交换后按本机字节序解码
+    VertexLayout layout = VertexLayout::Generic;
+    uint8_t presence = 0;   // 需要分配的可选属性 (kPresence* 标志)
+};
+
+// 二进制面记录的解码计划。面记录为 [前置标量属性][计数][索引 * 计数][后置标量属性]
+struct FaceDecodePlan {
+    PlyType countType = PlyType::Invalid;
+    PlyType indexType = PlyType::Invalid;
+    size_t countSize = 0;
+    size_t indexSize = 0;
+    size_t skipBefore = 0; // 索引列表之前的其他标量属性的字节数
+    size_t skipAfter = 0;  // 索引列表之后的其他标量属性的字节数
+    std::vector<bool> fieldsBefore; // 索引列表之前的其他属性，true 表示列表 (ASCII行中依次跳过)
+    bool swap = false;
+};
+
+// 面的解码结果：polygons 非空时按原样保留多边形，否则扇形三角化后追加到 triangles
+struct FaceOutput {
+    std::vector<Triangle>* triangles;
+    PolygonFaces* polygons;
+};
+
+// 从未对齐的内存中读取 T 并按需交换字节序
+template<typename T>
+inline T loadUnaligned(const char* p, bool swap) {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return swap ? swapBytes(value) : value;
+}
+
+// 按源类型读取一个标量并转换为 float
+inline float loadScalarAsFloat(const char* p, PlyType type, bool swap) {
+    switch (type) {
+    case PlyType::Int8: return static_cast<float>(static_cast<int8_t>(*p));
+    case PlyType::UInt8: return static_cast<float>(static_cast<uint8_t>(*p));
+    case PlyType::Int16: return static_cast<float>(loadUnaligned<int16_t>(p, swap));
+    case PlyType::UInt16: return static_cast<float>(loadUnaligned<uint16_t>(p, swap));
+    case PlyType::Int32: return static_cast<float>(loadUnaligned<int32_t>(p, swap));
+    case PlyType::UInt32: return static_cast<float>(loadUnaligned<uint32_t>(p, swap));
+    case PlyType::Float32: return loadUnaligned<float>(p, swap);
+    case PlyType::Float64: return static_cast<float>(loadUnaligned<double>(p, swap));
+    default: return 0.0f;
+    }
+}
+
+// 按源类型读取一个整数 (面计数或索引)
+inline int64_t loadScalarAsInt(const char* p, PlyType type, bool swap) {
+    switch (type) {
+    case PlyType::Int8: return static_cast<int8_t>(*p);
+    case PlyType::UInt8: return static_cast<uint8_t>(*p);
+    case PlyType::Int16: return loadUnaligned<int16_t>(p, swap);
+    case PlyType::UInt16: return loadUnaligned<uint16_t>(p, swap);
+    case PlyType::Int32: return loadUnaligned<int32_t>(p, swap);
+    case PlyType::UInt32: return loadUnaligned<uint32_t>(p, swap);
+    default: return 0;
+    }
+}
+
+// 二进制数据源：直接从内存映射的文件内容中解码，不经过任何流调用和复制
+struct MemorySource {
+    const char* cur;
+    const char* end;
+
+    const char* take(size_t n) {
+        if (static_cast<size_t>(end - cur) < n) return nullptr;
+        const char* p = cur;
+        cur += n;
+        return p;
+    }
+    bool skip(size_t n) {
+        return take(n) != nullptr;
+    }
+};
+
+// PLY类型在二进制文件中占用的字节数，无效类型返回0
+size_t plyTypeSize(PlyType type);
+
+// 检查系统字节序
+bool isSystemLittleEndian();
+
+// 解析PLY文件头，读取到 end_header 为止。返回后 file 指向数据体的第一个字节。
+// file_has_* 为文件头中声明的属性。
+bool readPLYHeader(std::istream& file, PlyHeader& header,
+    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords);
+
+// 由文件头构建顶点记录与面记录的解码计划，不支持的布局输出错误并返回 false。
+// attributes 之外的可选属性 (kPresence* 标志) 不解码，与未知属性一样只计入步长。
+// 二进制记录中的列表属性 (除面的索引列表外) 不受支持；ASCII数据体中的列表属性在解析时跳过。
+bool buildVertexDecodePlan(const PlyHeader& header, bool systemIsLE, VertexDecodePlan& plan,
+    uint8_t attributes = kPresenceAll);
+bool buildFaceDecodePlan(const PlyHeader& header, bool systemIsLE, FaceDecodePlan& plan);
+// 去掉文件头属性标志中不在 attributes 里的属性
+void selectAttributes(uint8_t attributes, bool& has_normals, bool& has_colors, bool& has_texCoords);
+
+// ---- ASCII 记号解析 ----
+
+inline bool isAsciiSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// 取出行内的下一个记号 [first, last)。没有更多记号时返回 false。
+inline bool nextToken(const char*& p, const char* lineEnd, const char*& first, const char*& last) {
+    while (p < lineEnd && isAsciiSpace(*p)) ++p;
+    if (p >= lineEnd) return false;
+    first = p;
+    while (p < lineEnd && !isAsciiSpace(*p)) ++p;
+    last = p;
+    return true;
+}
+
+// 与 stof/stoi 一样允许前导的 '+'，并只要求记号的前缀是合法数字
+template<typename T>
+inline bool parseNumber(const char* first, const char* last, T& value) {
+    if (first < last && *first == '+') ++first;
+    std::from_chars_result r = std::from_chars(first, last, value);
+    return r.ec == std::errc() && r.ptr != first;
+}
+
+// 跳过ASCII行中的一个属性：标量占一个记号，列表先读计数再跳过相应个数的记号。
+// 行提前结束或计数无效时返回 false。
+inline bool skipAsciiField(const char*& p, const char* lineEnd, bool isList) {
+    const char* first;
+    const char* last;
+    if (!nextToken(p, lineEnd, first, last)) return false;
+    if (!isList) return true;
+    int64_t count = 0;
+    if (!parseNumber(first, last, count) || count < 0) return false;
+    for (int64_t k = 0; k < count; ++k) {
+        if (!nextToken(p, lineEnd, first, last)) return false;
+    }
+    return true;
+}
+
+// buildAsciiFieldOps 中表示列表属性的值 (解析时按 skipAsciiField 跳过)
+const int kAsciiListField = -2;
+
+// ASCII行中每个字段对应的计划步骤序号，-1 表示忽略该字段，kAsciiListField 表示跳过该列表
+std::vector<int> buildAsciiFieldOps(const PlyHeader& header, const VertexDecodePlan& vplan);
+
+// 解析一行顶点数据写入第 k 个顶点。遇到无效值时忽略该值并返回 false。
+bool parseAsciiVertexLine(const char* p, const char* lineEnd, const VertexDecodePlan& plan,
+    const std::vector<int>& fieldOps, const VertexFloatStreams& out, size_t k);
+
+// 解析一行面数据追加到 out。顶点数少于3的面被忽略，索引无效时返回 false。
+bool parseAsciiFaceLine(const char* p, const char* lineEnd, const std::vector<bool>& fieldsBefore, const FaceOutput& out);
+
+// ---- 二进制记录解码 ----
+
+// 批量解码时复用的临时缓冲区
+struct DecodeScratch {
+    std::vector<char> records;       // 整块字节交换后的记录
+    std::vector<uint8_t> colorBytes; // 从记录中收集的连续 uchar 颜色分量
+};
+
+// 解码一批定长顶点记录，按文件头确定的布局和字节序选择特化路径
+void decodeVertexBatch(const VertexDecodePlan& plan, const char* records, size_t count, const VertexStreams& out, DecodeScratch& scratch);
+
+// 从内存中解码 faceCount 条二进制面记录，追加到 out。firstFace 仅用于错误信息。
+bool decodeBinaryFaces(MemorySource& src, const FaceDecodePlan& fplan, int64_t firstFace, int64_t faceCount, const FaceOutput& out);
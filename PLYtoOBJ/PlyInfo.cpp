@@ -0,0 +1,159 @@
+﻿// PlyInfo.cpp : --info 的文件头检查与估计
+//
+// 估计只依据文件头和文件大小，不读取数据体。OBJ大小由 estimateOBJBytes 按各类行的平均长度计算。
+
+#include "PlyInfo.h"
+
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+#include "InputStream.h"
+#include "Mesh.h"
+#include "ObjWriter.h"
+
+using namespace std;
+
+bool inspectPLY(const string& path, PlyInfo& info, const PlyInfoOptions& options) {
+    info = PlyInfo();
+    InputStream input;
+    if (!input.open(path)) return false;
+    istream& file = input.stream();
+    if (!readPLYHeader(file, info.header, info.has_normals, info.has_colors, info.has_texCoords)) return false;
+
+    const PlyHeader& header = info.header;
+    const bool systemIsLE = isSystemLittleEndian();
+    VertexDecodePlan vplan;
+    FaceDecodePlan fplan;
+    if (!buildVertexDecodePlan(header, systemIsLE, vplan, options.attributes)) return false;
+    if (header.faceCount > 0 && !buildFaceDecodePlan(header, systemIsLE, fplan)) return false;
+    info.presence = vplan.presence;
+
+    info.plainFile = input.isPlainFile();
+    const streamoff bodyOffset = info.plainFile ? static_cast<streamoff>(file.tellg()) : streamoff(-1);
+    if (bodyOffset > 0) info.headerBytes = static_cast<uint64_t>(bodyOffset);
+    if (path != "-") {
+        std::error_code ec;
+        const uintmax_t size = filesystem::file_size(path, ec);
+        if (!ec) info.fileBytes = static_cast<uint64_t>(size);
+    }
+    if (!header.isASCII) {
+        info.vertexStride = vplan.stride;
+        if (header.faceCount > 0) {
+            info.faceFixedBytes = fplan.skipBefore + fplan.countSize + fplan.skipAfter;
+            info.faceIndexBytes = fplan.indexSize;
+        }
+    }
+
+    // 平均每面顶点数：二进制文件的面记录总字节数可由文件大小推算
+    const uint64_t vertexCount = static_cast<uint64_t>(header.vertexCount);
+    const uint64_t faceCount = static_cast<uint64_t>(header.faceCount);
+    info.meanFaceValence = 3.0;
+    if (!header.isASCII && info.plainFile && info.headerBytes > 0 && faceCount > 0 && info.faceIndexBytes > 0) {
+        const uint64_t vertexBytes = vertexCount * info.vertexStride;
+        info.truncated = info.fileBytes < info.headerBytes + vertexBytes + faceCount * info.faceFixedBytes;
+        if (!info.truncated) {
+            const double faceBytes = static_cast<double>(info.fileBytes - info.headerBytes - vertexBytes);
+            const double valence = (faceBytes / static_cast<double>(faceCount) - static_cast<double>(info.faceFixedBytes)) /
+                static_cast<double>(info.faceIndexBytes);
+            if (valence >= 3.0) {
+                info.meanFaceValence = valence;
+                info.valenceFromSize = true;
+            }
+        }
+    }
+    const double faces = static_cast<double>(faceCount);
+    const double indices = faces * info.meanFaceValence;
+    info.estimatedTriangles = static_cast<uint64_t>(faces * (info.meanFaceValence - 2.0) + 0.5);
+
+    bool has_normals = info.has_normals, has_colors = info.has_colors, has_texCoords = info.has_texCoords;
+    selectAttributes(options.attributes, has_normals, has_colors, has_texCoords); // 写入OBJ的属性
+    const double triangles = static_cast<double>(info.estimatedTriangles);
+    info.estimatedObjBytes = estimateOBJBytes(vertexCount, options.keepPolygons ? faces : triangles,
+        options.keepPolygons ? indices : 3.0 * triangles, info.presence, has_normals, has_texCoords, options.floatFormat);
+
+    // 网格内存：顶点属性数组加面数组；ASCII 各段先解析到自己的面数组再合并，面数组在合并时有两份
+    double faceMemory = options.keepPolygons
+        ? (faces + 1.0) * sizeof(size_t) + indices * sizeof(MeshIndex)
+        : static_cast<double>(info.estimatedTriangles) * sizeof(Triangle);
+    if (header.isASCII) faceMemory *= 2.0;
+    info.estimatedMemoryBytes = static_cast<uint64_t>(static_cast<double>(vertexCount) * Mesh::vertexBytes(info.presence) + faceMemory);
+    return true;
+}
+
+// 写出 JSON 字符串，转义引号、反斜杠和控制字符
+void writeJSONString(ostream& out, const string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            out << escaped;
+        }
+        else out << c;
+    }
+    out << '"';
+}
+
+void writePropertiesJSON(ostream& out, const vector<PlyProperty>& properties) {
+    out << '[';
+    for (size_t k = 0; k < properties.size(); ++k) {
+        const PlyProperty& prop = properties[k];
+        if (k > 0) out << ',';
+        out << "{\"name\":";
+        writeJSONString(out, prop.name);
+        if (prop.is_list) {
+            out << ",\"list\":true,\"count_type\":";
+            writeJSONString(out, prop.count_type_str);
+            out << ",\"item_type\":";
+            writeJSONString(out, prop.list_item_type_str);
+        }
+        else {
+            out << ",\"type\":";
+            writeJSONString(out, prop.type_str);
+        }
+        out << '}';
+    }
+    out << ']';
+}
+
+void writePlyInfoFailureJSON(ostream& out, const string& path) {
+    out << "{\"path\":";
+    writeJSONString(out, path);
+    out << ",\"ok\":false}\n";
+}
+
+void writePlyInfoJSON(ostream& out, const string& path, const PlyInfo& info) {
+    const PlyHeader& header = info.header;
+    auto sizeOrNull = [&out](uint64_t value) {
+        if (value > 0) out << value;
+        else out << "null";
+    };
+    out << "{\"path\":";
+    writeJSONString(out, path);
+    out << ",\"ok\":true,\"format\":\""
+        << (header.isASCII ? "ascii" : header.fileIsLittleEndian ? "binary_little_endian" : "binary_big_endian") << '"';
+    out << ",\"plain_file\":" << (info.plainFile ? "true" : "false");
+    out << ",\"file_bytes\":"; sizeOrNull(info.fileBytes);
+    out << ",\"header_bytes\":"; sizeOrNull(info.headerBytes);
+    out << ",\"vertex_count\":" << header.vertexCount << ",\"face_count\":" << header.faceCount;
+    out << ",\"vertex_properties\":"; writePropertiesJSON(out, header.vertexProperties);
+    out << ",\"face_properties\":"; writePropertiesJSON(out, header.faceProperties);
+    out << ",\"vertex_stride\":"; sizeOrNull(info.vertexStride);
+    out << ",\"face_fixed_bytes\":";
+    if (!header.isASCII && header.faceCount > 0) out << info.faceFixedBytes;
+    else out << "null";
+    out << ",\"face_index_bytes\":"; sizeOrNull(info.faceIndexBytes);
+    out << ",\"has_normals\":" << (info.has_normals ? "true" : "false")
+        << ",\"has_colors\":" << (info.has_colors ? "true" : "false")
+        << ",\"has_texcoords\":" << (info.has_texCoords ? "true" : "false");
+    out << ",\"mean_face_valence\":" << info.meanFaceValence
+        << ",\"valence_source\":\"" << (info.valenceFromSize ? "file_size" : "assumed_triangles") << '"'
+        << ",\"truncated\":" << (info.truncated ? "true" : "false");
+    out << ",\"estimated_triangles\":" << info.estimatedTriangles
+        << ",\"estimated_obj_bytes\":" << info.estimatedObjBytes
+        << ",\"estimated_memory_bytes\":" << info.estimatedMemoryBytes << "}\n";
+}
@@ -0,0 +1,46 @@
+﻿// PlyInfo.h : 只解析文件头的快速检查 (--info)，输出元数据与输出大小、内存需求的估计
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "NumberFormat.h"
+#include "PlyDecode.h"
+
+struct PlyInfoOptions {
+    bool keepPolygons = false; // 按保留多边形估计内存与输出
+    FloatFormat floatFormat;   // 按该精度估计OBJ中浮点数的长度
+    uint8_t attributes = kPresenceAll; // 按只读取这些可选属性 (--attrs) 估计
+};
+
+// 文件头中的信息和估计值。大小未知的字段为 0。
+struct PlyInfo {
+    PlyHeader header;
+    bool has_normals = false, has_colors = false, has_texCoords = false; // 文件头中声明的属性
+    bool plainFile = false;      // 未压缩的普通文件 (可内存映射)
+    uint64_t headerBytes = 0;    // 到 end_header 所在行为止的字节数
+    uint64_t fileBytes = 0;      // 文件大小 (压缩输入为压缩后的大小)
+    size_t vertexStride = 0;     // 二进制顶点记录的字节数，ASCII 为 0
+    size_t faceFixedBytes = 0;   // 二进制面记录中索引列表以外的字节数
+    size_t faceIndexBytes = 0;   // 每个面索引的字节数
+    uint8_t presence = 0;        // 读取后网格中分配的可选属性 (kPresence* 标志)
+    double meanFaceValence = 0;  // 平均每面的顶点数：二进制普通文件由文件大小推算，否则假定为三角形 (3)
+    bool valenceFromSize = false;
+    bool truncated = false;      // 二进制普通文件比文件头声明的最短数据体还短
+    uint64_t estimatedTriangles = 0;
+    uint64_t estimatedObjBytes = 0;    // 不压缩时OBJ文件的估计大小
+    uint64_t estimatedMemoryBytes = 0; // readPLY 读入后网格占用的内存，加上 ASCII 解析时各段的临时面数组；
+                                       // 不包括内存映射的输入
+};
+
+// 只读取到 end_header 为止，不读取数据体。文件头无效时输出错误并返回 false。
+bool inspectPLY(const std::string& path, PlyInfo& info, const PlyInfoOptions& options = PlyInfoOptions());
+
+// 以一行 JSON 写出 info
+void writePlyInfoJSON(std::ostream& out, const std::string& path, const PlyInfo& info);
+
+// 检查失败的文件写出 {"path": ..., "ok": false}
+void writePlyInfoFailureJSON(std::ostream& out, const std::string& path);
@@ -0,0 +1,1204 @@
+﻿// PlyReader.cpp : PLY 文件头解析、解码计划与 readPLY 的实现
+//
+
+#include "PlyReader.h"
+#include "PlyDecode.h"
+
+#include <iostream>
+#include <istream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <cstring>     // for memcpy
+#include <filesystem>
+
+#include "InputStream.h"
+#include "MappedFile.h"
+#include "ParallelChunks.h"
+#include "Profile.h"
+#include "SimdKernels.h"
+
+using namespace std;
+
+// 将PLY类型字符串 (包括 "uchar" 与 "uint8" 等别名) 解析为 PlyType
+PlyType parsePlyType(const string& type_str) {
+    if (type_str == "char" || type_str == "int8") return PlyType::Int8;
+    if (type_str == "uchar" || type_str == "uint8") return PlyType::UInt8;
+    if (type_str == "short" || type_str == "int16") return PlyType::Int16;
+    if (type_str == "ushort" || type_str == "uint16") return PlyType::UInt16;
+    if (type_str == "int" || type_str == "int32") return PlyType::Int32;
+    if (type_str == "uint" || type_str == "uint32") return PlyType::UInt32;
+    if (type_str == "float" || type_str == "float32") return PlyType::Float32;
+    if (type_str == "double" || type_str == "float64") return PlyType::Float64;
+    return PlyType::Invalid;
+}
+
+// PLY类型在二进制文件中占用的字节数，无效类型返回0
+size_t plyTypeSize(PlyType type) {
+    switch (type) {
+    case PlyType::Int8: case PlyType::UInt8: return 1;
+    case PlyType::Int16: case PlyType::UInt16: return 2;
+    case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+    case PlyType::Float64: return 8;
+    default: return 0;
+    }
+}
+
+// 辅助函数：检查系统字节序
+bool isSystemLittleEndian() {
+    uint32_t i = 1;
+    char* c = (char*)&i;
+    return (*c == 1);
+}
+
+// 顶点属性解码后写入的目标字段
+enum class VertexSlot : uint8_t {
+    PositionX, PositionY, PositionZ,
+    NormalX, NormalY, NormalZ,
+    ColorR, ColorG, ColorB,
+    TexU, TexV,
+    None // 不需要的属性 (如 alpha、quality)，直接跳过
+};
+
+VertexSlot vertexSlotForName(const string& name) {
+    if (name == "x") return VertexSlot::PositionX;
+    if (name == "y") return VertexSlot::PositionY;
+    if (name == "z") return VertexSlot::PositionZ;
+    if (name == "nx") return VertexSlot::NormalX;
+    if (name == "ny") return VertexSlot::NormalY;
+    if (name == "nz") return VertexSlot::NormalZ;
+    if (name == "red") return VertexSlot::ColorR;
+    if (name == "green") return VertexSlot::ColorG;
+    if (name == "blue") return VertexSlot::ColorB;
+    if (name == "u" || name == "texture_u" || name == "s") return VertexSlot::TexU;
+    if (name == "v" || name == "texture_v" || name == "t") return VertexSlot::TexV;
+    return VertexSlot::None;
+}
+
+// 判断顶点属性序列是否与某个特化布局完全一致 (名称、类型和顺序)
+VertexLayout matchVertexLayout(const vector<PlyProperty>& props) {
+    auto matches = [&props](std::initializer_list<std::pair<const char*, PlyType>> expected) {
+        if (props.size() != expected.size()) return false;
+        size_t k = 0;
+        for (const auto& e : expected) {
+            if (props[k].is_list || props[k].type != e.second || props[k].name != e.first) return false;
+            ++k;
+        }
+        return true;
+    };
+    const PlyType f = PlyType::Float32, uc = PlyType::UInt8;
+    if (matches({ {"x", f}, {"y", f}, {"z", f} })) return VertexLayout::XYZ;
+    if (matches({ {"x", f}, {"y", f}, {"z", f}, {"nx", f}, {"ny", f}, {"nz", f} })) return VertexLayout::XYZNormal;
+    if (matches({ {"x", f}, {"y", f}, {"z", f}, {"red", uc}, {"green", uc}, {"blue", uc} })) return VertexLayout::XYZColor;
+    return VertexLayout::Generic;
+}
+
+// 解码计划是否只读取记录开头的 float x, y, z
+bool decodesOnlyLeadingXYZ(const VertexDecodePlan& plan) {
+    if (plan.ops.size() != 3) return false;
+    for (size_t k = 0; k < 3; ++k) {
+        const PlyFieldOp& op = plan.ops[k];
+        if (op.attribute != VertexAttribute::Position || op.component != k || op.type != PlyType::Float32 ||
+            op.srcOffset != 4 * k) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseVertexAttributes(const string& list, uint8_t& attributes) {
+    attributes = 0;
+    size_t begin = 0;
+    for (;;) {
+        const size_t end = std::min(list.find(',', begin), list.size());
+        const string name = list.substr(begin, end - begin);
+        if (name == "pos" || name == "position" || name == "xyz") {}
+        else if (name == "normal" || name == "normals") attributes |= kPresenceNormal;
+        else if (name == "color" || name == "colors" || name == "rgb") attributes |= kPresenceColor;
+        else if (name == "uv" || name == "texcoord" || name == "texcoords") attributes |= kPresenceTexCoord;
+        else return false;
+        if (end == list.size()) return true;
+        begin = end + 1;
+    }
+}
+
+void selectAttributes(uint8_t attributes, bool& has_normals, bool& has_colors, bool& has_texCoords) {
+    has_normals = has_normals && (attributes & kPresenceNormal) != 0;
+    has_colors = has_colors && (attributes & kPresenceColor) != 0;
+    has_texCoords = has_texCoords && (attributes & kPresenceTexCoord) != 0;
+}
+
+bool buildVertexDecodePlan(const PlyHeader& header, bool systemIsLE, VertexDecodePlan& plan, uint8_t attributes) {
+    plan = VertexDecodePlan();
+    plan.swap = (header.fileIsLittleEndian != systemIsLE);
+
+    size_t offset = 0;
+    bool all32 = true;
+    bool projected = false; // 有属性因未选择而跳过
+    for (const auto& prop : header.vertexProperties) {
+        if (prop.is_list) {
+            if (header.isASCII) continue; // ASCII行中按计数跳过，不参与二进制布局
+            cerr << "错误: 不支持顶点元素中的列表属性: " << prop.name << endl;
+            return false;
+        }
+        size_t typeSize = plyTypeSize(prop.type);
+        if (typeSize == 0) {
+            cerr << "错误: 无法确定二进制顶点属性 " << prop.name << " (类型: " << prop.type_str << ") 的大小。" << endl;
+            return false;
+        }
+
+        VertexSlot slot = vertexSlotForName(prop.name);
+        if (slot != VertexSlot::None) {
+            PlyFieldOp op;
+            op.srcOffset = static_cast<uint32_t>(offset);
+            op.fieldIndex = static_cast<uint32_t>(&prop - header.vertexProperties.data());
+            op.type = prop.type;
+            op.divisor = 0.0f;
+            const uint8_t slotIndex = static_cast<uint8_t>(slot);
+            if (slot == VertexSlot::TexU || slot == VertexSlot::TexV) {
+                op.attribute = VertexAttribute::TexCoord;
+                op.component = static_cast<uint8_t>(slotIndex - static_cast<uint8_t>(VertexSlot::TexU));
+                op.width = 2;
+            }
+            else {
+                // 位置、法线和颜色各占三个连续的槽
+                op.attribute = static_cast<VertexAttribute>(slotIndex / 3);
+                op.component = static_cast<uint8_t>(slotIndex % 3);
+                op.width = 3;
+            }
+            const uint8_t presence = op.attribute == VertexAttribute::Normal ? kPresenceNormal
+                : op.attribute == VertexAttribute::Color ? kPresenceColor
+                : op.attribute == VertexAttribute::TexCoord ? kPresenceTexCoord : 0;
+            // 未选择的属性与未知属性一样只计入步长
+            if (presence == 0 || (attributes & presence) != 0) {
+                if (op.attribute == VertexAttribute::Color) {
+                    // 整数颜色归一化到 0-1，浮点颜色保持原值
+                    if (prop.type == PlyType::UInt8) op.divisor = 255.0f;
+                    else if (prop.type == PlyType::UInt16) op.divisor = 65535.0f;
+                }
+                plan.presence |= presence;
+                plan.ops.push_back(op);
+            }
+            else projected = true;
+        }
+        offset += typeSize;
+        if (typeSize != 4) all32 = false;
+    }
+    plan.stride = offset;
+    // 有属性被跳过时整块交换会处理大量不读取的字节，改为逐属性交换
+    plan.bulkSwap32 = plan.swap && all32 && offset > 0 && !projected;
+    plan.layout = matchVertexLayout(header.vertexProperties);
+    // 特化布局中的属性被投影掉时不能再使用该布局
+    const uint8_t layoutPresence = plan.layout == VertexLayout::XYZNormal ? kPresenceNormal
+        : plan.layout == VertexLayout::XYZColor ? kPresenceColor : 0;
+    if (plan.layout != VertexLayout::Generic && plan.presence != layoutPresence) plan.layout = VertexLayout::Generic;
+    if (plan.layout == VertexLayout::Generic && decodesOnlyLeadingXYZ(plan)) {
+        // 只需要开头的位置：逐条读取 12 字节，不交换或复制整条记录
+        plan.layout = VertexLayout::XYZPrefix;
+        plan.bulkSwap32 = false;
+    }
+    return true;
+}
+
+bool buildFaceDecodePlan(const PlyHeader& header, bool systemIsLE, FaceDecodePlan& plan) {
+    plan = FaceDecodePlan();
+    plan.swap = (header.fileIsLittleEndian != systemIsLE);
+
+    bool seenIndexList = false;
+    for (const auto& prop : header.faceProperties) {
+        if (prop.is_list && (prop.name == "vertex_indices" || prop.name == "vertex_index")) {
+            plan.countType = prop.count_type;
+            plan.indexType = prop.list_item_type;
+            seenIndexList = true;
+            continue;
+        }
+        if (!seenIndexList) plan.fieldsBefore.push_back(prop.is_list);
+        if (header.isASCII) continue; // ASCII行中索引列表之后的属性直接忽略
+        size_t typeSize = prop.is_list ? 0 : plyTypeSize(prop.type);
+        if (typeSize == 0) {
+            cerr << "错误: 不支持的面属性: " << prop.name << endl;
+            return false;
+        }
+        (seenIndexList ? plan.skipAfter : plan.skipBefore) += typeSize;
+    }
+
+    plan.countSize = plyTypeSize(plan.countType);
+    plan.indexSize = plyTypeSize(plan.indexType);
+    if (header.isASCII) return true; // ASCII的计数和索引按文本解析，不需要二进制类型
+    if (plan.countSize == 0 || plan.countType == PlyType::Float32 || plan.countType == PlyType::Float64) {
+        cerr << "错误: 不支持的面顶点计数的二进制类型: " << header.faceProperty.count_type_str << endl;
+        return false;
+    }
+    if (plan.indexSize == 0 || plan.indexType == PlyType::Float32 || plan.indexType == PlyType::Float64) {
+        cerr << "错误: 不支持的面索引的二进制类型: " << header.faceProperty.list_item_type_str << endl;
+        return false;
+    }
+    return true;
+}
+
+// 二进制数据源：通过输入流读取。take() 一次读取整块记录到内部缓冲区。
+// 输入可能是管道或解压流，skip() 读出后丢弃而不定位。
+struct StreamSource {
+    istream& file;
+    vector<char> buffer;
+
+    const char* take(size_t n) {
+        if (buffer.size() < n || buffer.empty()) buffer.resize(std::max<size_t>(n, 1)); // n 为0时也返回有效指针
+        if (!file.read(buffer.data(), n)) return nullptr;
+        return buffer.data();
+    }
+    bool skip(size_t n) {
+        file.ignore(static_cast<streamsize>(n));
+        return static_cast<size_t>(file.gcount()) == n;
+    }
+};
+
+// 解析PLY文件头，读取到 end_header 为止。返回后 file 指向数据体的第一个字节。
+bool readPLYHeader(istream& file, PlyHeader& header,
+    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords) {
+    string line;
+    bool headerEnd = false;
+    int currentPropertyIndexASCII = 0;
+
+    file_has_normals = false;
+    file_has_colors = false;
+    file_has_texCoords = false;
+
+    string currentElement = "";
+
+    while (getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line.rfind("comment", 0) == 0) continue;
+
+        istringstream iss(line);
+        string token;
+        iss >> token;
+
+        if (token == "ply") continue;
+        if (token == "format") {
+            string format_str, version_str;
+            iss >> format_str >> version_str;
+            if (format_str == "ascii") {
+                header.isASCII = true;
+            }
+            else if (format_str == "binary_little_endian") {
+                header.isASCII = false;
+                header.fileIsLittleEndian = true;
+            }
+            else if (format_str == "binary_big_endian") {
+                header.isASCII = false;
+                header.fileIsLittleEndian = false;
+            }
+            else {
+                cerr << "错误: 不支持的PLY格式: " << format_str << endl;
+                return false;
+            }
+        }
+        else if (token == "element") {
+            iss >> currentElement;
+            if (currentElement == "vertex") iss >> header.vertexCount;
+            else if (currentElement == "face") iss >> header.faceCount;
+            currentPropertyIndexASCII = 0;
+        }
+        else if (token == "property") {
+            PlyProperty prop;
+            string type_or_list;
+            iss >> type_or_list;
+
+            if (type_or_list == "list") {
+                prop.is_list = true;
+                iss >> prop.count_type_str >> prop.list_item_type_str >> prop.name;
+                prop.count_type = parsePlyType(prop.count_type_str);
+                prop.list_item_type = parsePlyType(prop.list_item_type_str);
+            }
+            else {
+                prop.is_list = false;
+                prop.type_str = type_or_list;
+                prop.type = parsePlyType(prop.type_str);
+                iss >> prop.name;
+            }
+
+            if (currentElement == "vertex") {
+                prop.index_in_line = currentPropertyIndexASCII++;
+                header.vertexProperties.push_back(prop);
+                if (prop.name == "nx" || prop.name == "ny" || prop.name == "nz") file_has_normals = true;
+                if (prop.name == "red" || prop.name == "green" || prop.name == "blue" || prop.name == "alpha") file_has_colors = true;
+                if (prop.name == "u" || prop.name == "v" || prop.name == "s" || prop.name == "t" || prop.name == "texture_u" || prop.name == "texture_v") file_has_texCoords = true;
+            }
+            else if (currentElement == "face") {
+                header.faceProperties.push_back(prop);
+                if (prop.name == "vertex_indices" || prop.name == "vertex_index") {
+                    header.faceProperty = prop;
+                    header.facePropertyDefined = true;
+                }
+                else {
+                    // cerr << "警告: 面元素中存在未处理的属性: " << prop.name << endl;
+                }
+            }
+        }
+        else if (token == "end_header") {
+            headerEnd = true;
+            // 对于二进制文件，头之后的第一件事就是数据，所以我们需要确保文件指针在正确的位置。
+            // getline 会消耗换行符。如果这是二进制文件，我们需要确保我们从下一行开始。
+            // 通常，二进制数据紧跟在 "end_header\n" 之后。
+            // 如果文件是以 ios::binary 打开的，getline 仍然有效，但读取二进制数据时要用 file.read()
+            break;
+        }
+    }
+
+    if (!headerEnd) {
+        cerr << "错误: 无效的PLY文件头或未找到end_header" << endl;
+        return false;
+    }
+    if (header.vertexCount < 0 || header.faceCount < 0) {
+        cerr << "错误: 文件头中的元素个数无效" << endl;
+        return false;
+    }
+    if (header.vertexCount > kMaxMeshVertices) {
+        cerr << "错误: 顶点数 " << header.vertexCount << " 超出 " << (8 * sizeof(MeshIndex)) << " 位索引的范围，"
+            << "请定义 PLYTOOBJ_INDEX_64 重新编译" << endl;
+        return false;
+    }
+    if (header.faceCount > 0 && !header.facePropertyDefined) {
+        cerr << "错误: 定义了面元素但未找到 'vertex_indices' 或 'vertex_index' 属性。" << endl;
+        return false;
+    }
+    return true;
+}
+
+// ---- ASCII 数据体解析 ----
+// 整个数据体一次性载入 (或内存映射) 后按行边界切分成若干段，各段在工作线程上并行解析。
+// 第 i 行 (从0开始) 在 i < vertexCount 时是顶点，之后 faceCount 行是面。
+// 每行用 std::from_chars 直接在原始字节上解析，不产生任何逐行的内存分配。
+
+// 一段连续行的解析结果
+struct AsciiChunkResult {
+    vector<Triangle> triangles;
+    PolygonFaces polygons; // 保留多边形时使用
+    int64_t badValues = 0;    // 无效或超出范围的顶点属性值个数
+    int64_t firstBadLine = -1;
+    string error;          // 非空表示致命错误
+};
+
+// 解析一行顶点数据写入第 k 个顶点。fieldOps[k] 是第 k 个字段对应的计划步骤序号，-1 表示忽略该字段。
+bool parseAsciiVertexLine(const char* p, const char* lineEnd, const VertexDecodePlan& plan,
+    const vector<int>& fieldOps, const VertexFloatStreams& out, size_t k) {
+    const char* first;
+    const char* last;
+    bool allValid = true;
+    for (size_t field = 0; field < fieldOps.size() && nextToken(p, lineEnd, first, last); ++field) {
+        if (fieldOps[field] == kAsciiListField) {
+            // 跳过列表的各项；计数无效时无法确定后续字段的位置
+            int64_t count = 0;
+            if (!parseNumber(first, last, count) || count < 0) return false;
+            for (int64_t item = 0; item < count && nextToken(p, lineEnd, first, last); ++item) {}
+            continue;
+        }
+        if (fieldOps[field] < 0) continue;
+        const PlyFieldOp& op = plan.ops[fieldOps[field]];
+        float value = 0.0f;
+        bool ok;
+        if (op.type == PlyType::Float32 || op.type == PlyType::Float64) {
+            ok = parseNumber(first, last, value);
+        }
+        else {
+            int64_t ivalue = 0;
+            ok = parseNumber(first, last, ivalue);
+            value = static_cast<float>(ivalue);
+            if (op.divisor != 0.0f) value /= op.divisor;
+        }
+        if (!ok) {
+            allValid = false;
+            continue;
+        }
+        *op.target(out, k) = value;
+    }
+    return allValid;
+}
+
+// 解析一行面数据，保留为多边形或三角化后追加到 out
+bool parseAsciiFaceLine(const char* p, const char* lineEnd, const vector<bool>& fieldsBefore, const FaceOutput& out) {
+    const char* first;
+    const char* last;
+    for (bool isList : fieldsBefore) {
+        if (!skipAsciiField(p, lineEnd, isList)) return true; // 与计数缺失一样视为空面
+    }
+    int numFaceVertices = 0;
+    if (!nextToken(p, lineEnd, first, last) || !parseNumber(first, last, numFaceVertices)) {
+        return true;
+    }
+    if (numFaceVertices < 3) {
+        // cerr << "警告: 面的顶点数少于3 (" << numFaceVertices << ")。" << endl;
+        return true;
+    }
+
+    if (out.polygons != nullptr) {
+        vector<MeshIndex>& indices = out.polygons->indices;
+        for (int j = 0; j < numFaceVertices; ++j) {
+            MeshIndex idx;
+            if (!nextToken(p, lineEnd, first, last) || !parseNumber(first, last, idx)) {
+                return false;
+            }
+            indices.push_back(idx);
+        }
+        out.polygons->closeFace();
+        return true;
+    }
+
+    vector<Triangle>& triangles = *out.triangles;
+    MeshIndex idx0 = 0, prev = 0;
+    for (int j = 0; j < numFaceVertices; ++j) {
+        MeshIndex idx;
+        if (!nextToken(p, lineEnd, first, last) || !parseNumber(first, last, idx)) {
+            return false;
+        }
+        if (j == 0) idx0 = idx;
+        else if (j >= 2) triangles.push_back({ idx0, prev, idx });
+        prev = idx;
+    }
+    return true;
+}
+
+// ASCII行中每个字段对应的计划步骤序号，-1 表示忽略该字段
+vector<int> buildAsciiFieldOps(const PlyHeader& header, const VertexDecodePlan& vplan) {
+    vector<int> fieldOps(header.vertexProperties.size(), -1);
+    for (size_t k = 0; k < fieldOps.size(); ++k) {
+        if (header.vertexProperties[k].is_list) fieldOps[k] = kAsciiListField;
+    }
+    for (size_t k = 0; k < vplan.ops.size(); ++k) {
+        fieldOps[vplan.ops[k].fieldIndex] = static_cast<int>(k);
+    }
+    return fieldOps;
+}
+
+// 读取ASCII格式的顶点和面数据。[body, bodyEnd) 是 end_header 之后的全部内容。
+bool parseASCIIBody(const char* body, const char* bodyEnd, const PlyHeader& header, const VertexDecodePlan& vplan,
+    const vector<bool>& faceFieldsBefore, unsigned threadCount, bool keepPolygons, Mesh& mesh) {
+    const int64_t vertexCount = header.vertexCount;
+    const int64_t faceCount = header.faceCount;
+    const int64_t neededLines = vertexCount + faceCount;
+    const size_t bodySize = static_cast<size_t>(bodyEnd - body);
+
+    const vector<int> fieldOps = buildAsciiFieldOps(header, vplan);
+    const VertexFloatStreams vertexOut(mesh.streams());
+
+    // 1. 按字节数把数据体切成若干段，每个切分点向后移到下一行的开头
+    const size_t kMinChunkBytes = 1 << 18;
+    size_t chunkCount = 1;
+    if (threadCount > 1) {
+        chunkCount = std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(threadCount) * 4, bodySize / kMinChunkBytes));
+    }
+    vector<const char*> bounds(chunkCount + 1, bodyEnd);
+    bounds[0] = body;
+    for (size_t c = 1; c < chunkCount; ++c) {
+        const char* p = std::max(bounds[c - 1], body + bodySize / chunkCount * c);
+        const char* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(bodyEnd - p)));
+        bounds[c] = nl ? nl + 1 : bodyEnd;
+    }
+
+    // 2. 并行统计每段的行数，前缀和即为每段第一行的全局行号。最后一行可以没有换行符。
+    vector<int64_t> firstLine(chunkCount + 1, 0);
+    runParallel(chunkCount, threadCount, [&](size_t c) {
+        ProfileScope scope(ProfileStage::BodyIndex);
+        int64_t lines = 0;
+        for (const char* p = bounds[c]; p < bounds[c + 1]; ++lines) {
+            const char* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(bounds[c + 1] - p)));
+            p = nl ? nl + 1 : bounds[c + 1];
+        }
+        firstLine[c + 1] = lines;
+    });
+    for (size_t c = 0; c < chunkCount; ++c) {
+        firstLine[c + 1] += firstLine[c];
+    }
+    const int64_t totalLines = firstLine[chunkCount];
+    if (totalLines < neededLines) {
+        if (totalLines < vertexCount) {
+            cerr << "错误: 读取ASCII顶点数据时意外结束 (顶点 " << totalLines << "/" << vertexCount << ")" << endl;
+        }
+        else {
+            cerr << "错误: 读取ASCII面数据时意外结束 (面 " << (totalLines - vertexCount) << "/" << faceCount << ")" << endl;
+        }
+        return false;
+    }
+
+    // 3. 各段并行解析：顶点直接写入最终位置，面先放到各段自己的三角形 (或多边形) 数组
+    vector<AsciiChunkResult> results(chunkCount);
+    runParallel(chunkCount, threadCount, [&](size_t c) {
+        AsciiChunkResult& result = results[c];
+        const FaceOutput faceOut = { &result.triangles, keepPolygons ? &result.polygons : nullptr };
+        int64_t line = firstLine[c];
+        ProfileScope scope(line < vertexCount ? ProfileStage::VertexDecode : ProfileStage::FaceDecode);
+        for (const char* p = bounds[c]; p < bounds[c + 1] && line < neededLines; ++line) {
+            if (line == vertexCount) scope.restart(ProfileStage::FaceDecode);
+            const char* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(bounds[c + 1] - p)));
+            const char* lineEnd = nl ? nl : bounds[c + 1];
+            const char* next = nl ? nl + 1 : bounds[c + 1];
+            const bool emptyLine = (lineEnd == p);
+
+            if (line < vertexCount) {
+                if (emptyLine) {
+                    if (line < vertexCount - 1) {
+                        result.error = "错误: 读取ASCII顶点数据时遇到空行 (顶点 " + to_string(line) + "/" + to_string(vertexCount) + ")";
+                        return;
+                    }
+                }
+                else if (!parseAsciiVertexLine(p, lineEnd, vplan, fieldOps, vertexOut, static_cast<size_t>(line))) {
+                    if (result.badValues++ == 0) result.firstBadLine = line;
+                }
+            }
+            else {
+                const int64_t face = line - vertexCount;
+                if (emptyLine) {
+                    if (face < faceCount - 1) {
+                        result.error = "错误: 读取ASCII面数据时遇到空行 (面 " + to_string(face) + "/" + to_string(faceCount) + ")";
+                        return;
+                    }
+                }
+                else if (!parseAsciiFaceLine(p, lineEnd, faceFieldsBefore, faceOut)) {
+                    result.error = "错误: 读取ASCII面 " + to_string(face) + " 的顶点索引时出错。";
+                    return;
+                }
+            }
+            p = next;
+        }
+    });
+
+    // 4. 按段的顺序汇总错误和面
+    size_t triangleCount = 0, polygonCount = 0, polygonIndexCount = 0;
+    int64_t badValues = 0;
+    for (const auto& result : results) {
+        if (!result.error.empty()) {
+            cerr << result.error << endl;
+            return false;
+        }
+        if (result.badValues > 0 && badValues == 0) {
+            cerr << "警告: ASCII顶点 " << result.firstBadLine << " 中有无效或超出范围的属性值，已忽略。" << endl;
+        }
+        badValues += result.badValues;
+        triangleCount += result.triangles.size();
+        polygonCount += result.polygons.faceCount();
+        polygonIndexCount += result.polygons.indices.size();
+    }
+    if (badValues > 1) {
+        cerr << "警告: 共有 " << badValues << " 个ASCII顶点包含无效的属性值。" << endl;
+    }
+    ProfileScope mergeScope(ProfileStage::FaceMerge);
+
+    if (keepPolygons) {
+        // 各段的索引依次拼接，面的起始偏移加上之前各段的索引总数
+        PolygonFaces& polygons_out = mesh.polygons;
+        polygons_out.clear();
+        if (polygonCount == 0) return true;
+        polygons_out.offsets.resize(polygonCount + 1);
+        polygons_out.indices.resize(polygonIndexCount);
+        polygons_out.offsets[0] = 0;
+        vector<size_t> faceBase(chunkCount, 0), indexBase(chunkCount, 0);
+        for (size_t c = 1; c < chunkCount; ++c) {
+            faceBase[c] = faceBase[c - 1] + results[c - 1].polygons.faceCount();
+            indexBase[c] = indexBase[c - 1] + results[c - 1].polygons.indices.size();
+        }
+        runParallel(chunkCount, threadCount, [&](size_t c) {
+            const PolygonFaces& part = results[c].polygons;
+            std::copy(part.indices.begin(), part.indices.end(), polygons_out.indices.begin() + indexBase[c]);
+            for (size_t f = 0; f < part.faceCount(); ++f) {
+                polygons_out.offsets[faceBase[c] + f + 1] = indexBase[c] + part.offsets[f + 1];
+            }
+        });
+        return true;
+    }
+
+    vector<Triangle>& triangles_out = mesh.triangles;
+    triangles_out.resize(triangleCount);
+    vector<size_t> triangleOffset(chunkCount, 0);
+    for (size_t c = 1; c < chunkCount; ++c) {
+        triangleOffset[c] = triangleOffset[c - 1] + results[c - 1].triangles.size();
+    }
+    runParallel(chunkCount, threadCount, [&](size_t c) {
+        std::copy(results[c].triangles.begin(), results[c].triangles.end(), triangles_out.begin() + triangleOffset[c]);
+    });
+    return true;
+}
+
+// 读取一个 float，是否交换字节序在编译期确定
+template<bool Swap>
+inline float loadFloat(const char* p) {
+    float value;
+    memcpy(&value, p, sizeof(float));
+    return Swap ? swapBytes(value) : value;
+}
+
+// 特化布局的定长记录解码。每种布局的步长与字段偏移都是编译期常量，
+// 不交换字节序时整条循环退化为连续的 float 复制。
+template<VertexLayout Layout> struct FixedVertexLayout;
+
+template<> struct FixedVertexLayout<VertexLayout::XYZ> {
+    static const size_t stride = 12;
+    template<bool Swap>
+    static void decode(const char* r, const VertexStreams& out, size_t k) {
+        out.positions[k] = Vec3(loadFloat<Swap>(r), loadFloat<Swap>(r + 4), loadFloat<Swap>(r + 8));
+    }
+};
+
+template<> struct FixedVertexLayout<VertexLayout::XYZNormal> {
+    static const size_t stride = 24;
+    template<bool Swap>
+    static void decode(const char* r, const VertexStreams& out, size_t k) {
+        out.positions[k] = Vec3(loadFloat<Swap>(r), loadFloat<Swap>(r + 4), loadFloat<Swap>(r + 8));
+        out.normals[k] = Vec3(loadFloat<Swap>(r + 12), loadFloat<Swap>(r + 16), loadFloat<Swap>(r + 20));
+    }
+};
+
+// 颜色分量由 decodeVertexBatch 收集后用 unitFloatsFromBytes 批量转换，这里只解码位置
+template<> struct FixedVertexLayout<VertexLayout::XYZColor> {
+    static const size_t stride = 15;
+    static const size_t colorOffset = 12;
+    template<bool Swap>
+    static void decode(const char* r, const VertexStreams& out, size_t k) {
+        out.positions[k] = Vec3(loadFloat<Swap>(r), loadFloat<Swap>(r + 4), loadFloat<Swap>(r + 8));
+    }
+};
+
+template<VertexLayout Layout, bool Swap>
+void decodeVerticesFixed(const char* records, size_t count, const VertexStreams& out) {
+    typedef FixedVertexLayout<Layout> L;
+    for (size_t k = 0; k < count; ++k) {
+        L::template decode<Swap>(records + k * L::stride, out, k);
+    }
+}
+
+// 只读取记录开头的 float x, y, z
+template<bool Swap>
+void decodeLeadingPositions(const char* records, size_t count, size_t stride, const VertexStreams& out) {
+    for (size_t k = 0; k < count; ++k) {
+        const char* r = records + k * stride;
+        out.positions[k] = Vec3(loadFloat<Swap>(r), loadFloat<Swap>(r + 4), loadFloat<Swap>(r + 8));
+    }
+}
+
+// 通用路径：逐属性执行解码计划
+void decodeVerticesGeneric(const VertexDecodePlan& plan, const char* records, size_t count, const VertexStreams& out, bool swap) {
+    const VertexFloatStreams dst(out);
+    for (size_t k = 0; k < count; ++k) {
+        const char* record = records + k * plan.stride;
+        for (const auto& op : plan.ops) {
+            float value = loadScalarAsFloat(record + op.srcOffset, op.type, swap);
+            if (op.divisor != 0.0f) value /= op.divisor;
+            *op.target(dst, k) = value;
+        }
+    }
+}
+
+// XYZColor 布局的颜色分量：先收集成连续的字节块，再用SIMD内核一次性转换，直接写入颜色数组
+void decodeXYZColorComponents(const char* records, size_t count, const VertexStreams& out, DecodeScratch& scratch) {
+    typedef FixedVertexLayout<VertexLayout::XYZColor> L;
+    scratch.colorBytes.resize(count * 3);
+    for (size_t k = 0; k < count; ++k) {
+        memcpy(&scratch.colorBytes[k * 3], records + k * L::stride + L::colorOffset, 3);
+    }
+    unitFloatsFromBytes(scratch.colorBytes.data(), reinterpret_cast<float*>(out.colors), count * 3);
+}
+
+// 解码一批定长顶点记录，按文件头确定的布局和字节序选择特化路径
+void decodeVertexBatch(const VertexDecodePlan& plan, const char* records, size_t count, const VertexStreams& out, DecodeScratch& scratch) {
+    bool swap = plan.swap;
+    if (plan.bulkSwap32) {
+        // 记录全部由32位字组成：整块交换字节序后按本机字节序解码
+        scratch.records.resize(count * plan.stride);
+        byteSwap32Block(records, scratch.records.data(), count * plan.stride / 4);
+        records = scratch.records.data();
+        swap = false;
+    }
+
+    switch (plan.layout) {
+    case VertexLayout::XYZ:
+        if (swap) decodeVerticesFixed<VertexLayout::XYZ, true>(records, count, out);
+        else decodeVerticesFixed<VertexLayout::XYZ, false>(records, count, out);
+        break;
+    case VertexLayout::XYZNormal:
+        if (swap) decodeVerticesFixed<VertexLayout::XYZNormal, true>(records, count, out);
+        else decodeVerticesFixed<VertexLayout::XYZNormal, false>(records, count, out);
+        break;
+    case VertexLayout::XYZColor:
+        if (swap) decodeVerticesFixed<VertexLayout::XYZColor, true>(records, count, out);
+        else decodeVerticesFixed<VertexLayout::XYZColor, false>(records, count, out);
+        decodeXYZColorComponents(records, count, out, scratch);
+        break;
+    case VertexLayout::XYZPrefix:
+        if (swap) decodeLeadingPositions<true>(records, count, plan.stride, out);
+        else decodeLeadingPositions<false>(records, count, plan.stride, out);
+        break;
+    default:
+        decodeVerticesGeneric(plan, records, count, out, swap);
+        break;
+    }
+}
+
+// 每次从数据源取出的顶点记录数。流式读取时即每次 read 调用的记录数。
+const size_t kVertexBatchSize = 4096;
+
+// 按面索引的类型和字节序调用 decode(Index(), Swap)，类型在逐面的循环之外只判断一次
+template<typename Decode>
+bool withFaceIndexType(const FaceDecodePlan& fplan, Decode&& decode) {
+    auto bySwap = [&](auto index) {
+        return fplan.swap ? decode(index, std::true_type()) : decode(index, std::false_type());
+    };
+    switch (fplan.indexType) {
+    case PlyType::Int8: return bySwap(int8_t());
+    case PlyType::UInt8: return bySwap(uint8_t());
+    case PlyType::Int16: return bySwap(int16_t());
+    case PlyType::UInt16: return bySwap(uint16_t());
+    case PlyType::Int32: return bySwap(int32_t());
+    case PlyType::UInt32: return bySwap(uint32_t());
+    default: return false;
+    }
+}
+
+template<typename Index, bool Swap>
+inline MeshIndex loadFaceIndex(const char* p) {
+    return static_cast<MeshIndex>(loadUnaligned<Index>(p, Swap));
+}
+
+// 从数据源解码 faceCount 条二进制面记录，保留为多边形或三角化后追加到 out。firstFace 仅用于错误信息。
+template<typename Index, bool Swap, typename Source>
+bool decodeFaceRecordsAs(Source& src, const FaceDecodePlan& fplan, int64_t firstFace, int64_t faceCount, const FaceOutput& out) {
+    for (int64_t f = 0; f < faceCount; ++f) {
+        const int64_t i = firstFace + f;
+        if (fplan.skipBefore > 0 && !src.skip(fplan.skipBefore)) return false;
+
+        const char* countBytes = src.take(fplan.countSize);
+        if (countBytes == nullptr) return false;
+        int64_t numFaceVertices = loadScalarAsInt(countBytes, fplan.countType, fplan.swap);
+        if (numFaceVertices < 0) {
+            cerr << "错误: 面 " << i << " 的顶点数无效: " << numFaceVertices << endl;
+            return false;
+        }
+
+        const char* indexBytes = src.take(static_cast<size_t>(numFaceVertices) * sizeof(Index));
+        if (indexBytes == nullptr) return false;
+        if (fplan.skipAfter > 0 && !src.skip(fplan.skipAfter)) return false;
+
+        if (numFaceVertices < 3) {
+            // cerr << "警告: 面 " << i << " 的顶点数少于3 (" << numFaceVertices << ")。" << endl;
+            continue;
+        }
+
+        // 索引直接从记录中解码 (skip() 不会覆盖 take() 的缓冲区)：多边形追加到 CSR 数组，
+        // 三角化时按扇形展开，不需要逐面的临时数组
+        const size_t n = static_cast<size_t>(numFaceVertices);
+        if (out.polygons != nullptr) {
+            vector<MeshIndex>& indices = out.polygons->indices;
+            const size_t base = indices.size();
+            indices.resize(base + n);
+            for (size_t j = 0; j < n; ++j) indices[base + j] = loadFaceIndex<Index, Swap>(indexBytes + j * sizeof(Index));
+            out.polygons->closeFace();
+            continue;
+        }
+        const MeshIndex idx0 = loadFaceIndex<Index, Swap>(indexBytes);
+        MeshIndex prev = loadFaceIndex<Index, Swap>(indexBytes + sizeof(Index));
+        for (size_t j = 2; j < n; ++j) {
+            const MeshIndex idx = loadFaceIndex<Index, Swap>(indexBytes + j * sizeof(Index));
+            out.triangles->push_back({ idx0, prev, idx });
+            prev = idx;
+        }
+    }
+    return true;
+}
+
+template<typename Source>
+bool decodeFaceRecords(Source& src, const FaceDecodePlan& fplan, int64_t firstFace, int64_t faceCount, const FaceOutput& out) {
+    return withFaceIndexType(fplan, [&](auto index, auto swap) {
+        return decodeFaceRecordsAs<decltype(index), decltype(swap)::value>(src, fplan, firstFace, faceCount, out);
+    });
+}
+
+bool decodeBinaryFaces(MemorySource& src, const FaceDecodePlan& fplan, int64_t firstFace, int64_t faceCount, const FaceOutput& out) {
+    return decodeFaceRecords(src, fplan, firstFace, faceCount, out);
+}
+
+// 为 faceCount 条面记录预先分配输出数组，解码时不再扩容。内存数据源开头的面都是三角形时
+// 按面数分配 (三角网格不需要额外扫描)，否则先扫描各面的顶点数得到精确大小；
+// 记录不完整时按面数估计，错误由解码时报告。
+void reserveFaces(const MemorySource& src, const FaceDecodePlan& fplan, int64_t faceCount, bool keepPolygons, Mesh& mesh) {
+    const int64_t kSampleFaces = 16;
+    size_t triangles = 0, polygons = 0, indices = 0;
+    const char* p = src.cur;
+    const size_t head = fplan.skipBefore + fplan.countSize;
+    bool allTriangles = true;
+    int64_t f = 0;
+    for (; f < faceCount && static_cast<size_t>(src.end - p) >= head; ++f) {
+        if (f == kSampleFaces && allTriangles) break;
+        const int64_t n = loadScalarAsInt(p + fplan.skipBefore, fplan.countType, fplan.swap);
+        if (n < 0) break;
+        // 先比较剩余字节数再移动指针，截断的记录不会让指针越过数据末尾
+        const size_t record = head + static_cast<size_t>(n) * fplan.indexSize + fplan.skipAfter;
+        if (static_cast<size_t>(src.end - p) < record) break;
+        p += record;
+        if (n >= 3) {
+            triangles += static_cast<size_t>(n - 2);
+            ++polygons;
+            indices += static_cast<size_t>(n);
+        }
+        allTriangles = allTriangles && n == 3;
+    }
+    if (f < faceCount) {
+        triangles = polygons = static_cast<size_t>(faceCount);
+        indices = polygons * 3;
+    }
+    if (keepPolygons) {
+        mesh.polygons.offsets.reserve(polygons + 1);
+        mesh.polygons.indices.reserve(indices);
+    }
+    else {
+        mesh.triangles.reserve(triangles);
+    }
+}
+
+// 流式数据源不能预先扫描，按每个面一个三角形估计
+void reserveFaces(const StreamSource&, const FaceDecodePlan&, int64_t faceCount, bool keepPolygons, Mesh& mesh) {
+    if (keepPolygons) {
+        mesh.polygons.offsets.reserve(static_cast<size_t>(faceCount) + 1);
+        mesh.polygons.indices.reserve(static_cast<size_t>(faceCount) * 3);
+    }
+    else {
+        mesh.triangles.reserve(static_cast<size_t>(faceCount));
+    }
+}
+
+// ---- 并行解码内存中的二进制面记录 ----
+// 面记录是变长的 (计数 + 索引)，第一遍只读取各面的顶点数，把记录分成若干块并算出每块输出的起始位置；
+// 第二遍在工作线程上把各块直接解码到预先分配好的最终数组中。所有面的顶点数相同时 (纯三角形或四边形网格)
+// 记录是定长的，不需要第一遍，在解码的同时检查每个面的顶点数。
+
+// 一块面记录及其输出位置
+struct FaceBlock {
+    size_t offset, count;            // 相对数据源当前位置的字节偏移、面数
+    size_t firstTriangle;            // 三角化时第一个三角形的序号
+    size_t firstPolygon, firstIndex; // 保留多边形时第一个面和第一个索引的序号
+};
+
+// 至少有这么多个面时才并行解码
+const int64_t kParallelFaceMin = 1 << 16;
+
+// 解码一块面记录到预先分配的数组。valence 不为 0 时要求每个面恰好有 valence 个顶点，否则返回 false。
+template<typename Index, bool Swap>
+bool decodeFaceBlock(const char* p, const FaceBlock& block, const FaceDecodePlan& fplan, int64_t valence,
+    bool keepPolygons, Mesh& mesh) {
+    const size_t head = fplan.skipBefore + fplan.countSize;
+    Triangle* triangles = keepPolygons ? nullptr : mesh.triangles.data() + block.firstTriangle;
+    MeshIndex* indices = keepPolygons ? mesh.polygons.indices.data() + block.firstIndex : nullptr;
+    size_t* offsets = keepPolygons ? mesh.polygons.offsets.data() + block.firstPolygon + 1 : nullptr;
+    size_t indexEnd = block.firstIndex;
+    for (size_t f = 0; f < block.count; ++f) {
+        const int64_t n = loadScalarAsInt(p + fplan.skipBefore, fplan.countType, fplan.swap);
+        if (valence != 0 && n != valence) return false;
+        const char* indexBytes = p + head;
+        p = indexBytes + static_cast<size_t>(n) * sizeof(Index) + fplan.skipAfter;
+        if (n < 3) continue;
+        if (keepPolygons) {
+            for (int64_t j = 0; j < n; ++j) *indices++ = loadFaceIndex<Index, Swap>(indexBytes + j * sizeof(Index));
+            indexEnd += static_cast<size_t>(n);
+            *offsets++ = indexEnd;
+            continue;
+        }
+        const MeshIndex idx0 = loadFaceIndex<Index, Swap>(indexBytes);
+        MeshIndex prev = loadFaceIndex<Index, Swap>(indexBytes + sizeof(Index));
+        for (int64_t j = 2; j < n; ++j) {
+            const MeshIndex idx = loadFaceIndex<Index, Swap>(indexBytes + j * sizeof(Index));
+            *triangles++ = { idx0, prev, idx };
+            prev = idx;
+        }
+    }
+    return true;
+}
+
+// 第一遍：所有面的顶点数都等于第一个面时按定长记录划分 (valence 为该顶点数)，否则逐条读取顶点数划分。
+// 记录不完整或顶点数无效时返回 false，由顺序解码报告错误。
+bool planFaceBlocks(const MemorySource& src, const FaceDecodePlan& fplan, int64_t faceCount, size_t blockFaces,
+    vector<FaceBlock>& blocks, int64_t& valence, size_t& triangles, size_t& polygons, size_t& indices) {
+    ProfileScope scope(ProfileStage::BodyIndex);
+    const size_t available = static_cast<size_t>(src.end - src.cur);
+    const size_t head = fplan.skipBefore + fplan.countSize;
+    const size_t faces = static_cast<size_t>(faceCount);
+    blocks.clear();
+    triangles = polygons = indices = 0;
+    if (available < head) return false;
+
+    valence = loadScalarAsInt(src.cur + fplan.skipBefore, fplan.countType, fplan.swap);
+    const size_t stride = valence < 3 ? 0 : head + static_cast<size_t>(valence) * fplan.indexSize + fplan.skipAfter;
+    if (stride > 0 && available / stride >= faces) {
+        const size_t n = static_cast<size_t>(valence);
+        for (size_t first = 0; first < faces; first += blockFaces) {
+            const size_t count = std::min(blockFaces, faces - first);
+            blocks.push_back({ first * stride, count, first * (n - 2), first, first * n });
+        }
+        triangles = faces * (n - 2);
+        polygons = faces;
+        indices = faces * n;
+        return true;
+    }
+
+    valence = 0;
+    size_t offset = 0;
+    for (size_t f = 0; f < faces; ++f) {
+        if (f % blockFaces == 0) blocks.push_back({ offset, std::min(blockFaces, faces - f), triangles, polygons, indices });
+        if (available - offset < head) return false;
+        const int64_t n = loadScalarAsInt(src.cur + offset + fplan.skipBefore, fplan.countType, fplan.swap);
+        if (n < 0) return false;
+        const size_t record = head + static_cast<size_t>(n) * fplan.indexSize + fplan.skipAfter;
+        if (available - offset < record) return false;
+        offset += record;
+        if (n >= 3) {
+            triangles += static_cast<size_t>(n - 2);
+            ++polygons;
+            indices += static_cast<size_t>(n);
+        }
+    }
+    return true;
+}
+
+// 两遍并行解码内存中的面记录。返回 false 时 mesh 的面数组已清空，调用方改用顺序解码。
+bool decodeBinaryFacesParallel(const MemorySource& src, const FaceDecodePlan& fplan, int64_t faceCount, unsigned threadCount,
+    bool keepPolygons, Mesh& mesh) {
+    const size_t blockFaces = std::max<size_t>(static_cast<size_t>(faceCount) / (static_cast<size_t>(threadCount) * 8), 1 << 14);
+    vector<FaceBlock> blocks;
+    int64_t valence = 0;
+    size_t triangles = 0, polygons = 0, indices = 0;
+    if (!planFaceBlocks(src, fplan, faceCount, blockFaces, blocks, valence, triangles, polygons, indices)) return false;
+
+    if (keepPolygons) {
+        mesh.polygons.offsets.resize(polygons + 1);
+        mesh.polygons.offsets[0] = 0;
+        mesh.polygons.indices.resize(indices);
+    }
+    else {
+        mesh.triangles.resize(triangles);
+    }
+    std::atomic<bool> mismatch(false);
+    runParallel(blocks.size(), threadCount, [&](size_t b) {
+        if (mismatch.load(std::memory_order_relaxed)) return;
+        ProfileScope scope(ProfileStage::FaceDecode);
+        const bool ok = withFaceIndexType(fplan, [&](auto index, auto swap) {
+            return decodeFaceBlock<decltype(index), decltype(swap)::value>(src.cur + blocks[b].offset, blocks[b], fplan,
+                valence, keepPolygons, mesh);
+        });
+        if (!ok) mismatch = true;
+    });
+    if (mismatch) {
+        mesh.clearFaces();
+        return false;
+    }
+    return true;
+}
+
+// 读取二进制格式的顶点和面数据。Source 可以是 StreamSource (输入流) 或 MemorySource (内存映射)。
+// 面记录足够多时并行解码 (只支持内存数据源)，返回 false 表示需要顺序解码
+bool decodeFacesInParallel(const MemorySource& src, const FaceDecodePlan& fplan, int64_t faceCount, unsigned threadCount,
+    bool keepPolygons, Mesh& mesh) {
+    return threadCount > 1 && faceCount >= kParallelFaceMin &&
+        decodeBinaryFacesParallel(src, fplan, faceCount, threadCount, keepPolygons, mesh);
+}
+
+bool decodeFacesInParallel(const StreamSource&, const FaceDecodePlan&, int64_t, unsigned, bool, Mesh&) {
+    return false;
+}
+
+// threadCount > 1 时内存映射的面记录在多个线程上解码。
+template<typename Source>
+bool readBinaryBody(Source& src, const PlyHeader& header, const VertexDecodePlan& vplan, const FaceDecodePlan& fplan,
+    unsigned threadCount, bool keepPolygons, Mesh& mesh) {
+    const int64_t vertexCount = header.vertexCount;
+    const int64_t faceCount = header.faceCount;
+
+    // 读取顶点数据：按计划解码定长记录
+    ProfileScope scope(ProfileStage::VertexDecode);
+    DecodeScratch scratch;
+    for (int64_t i = 0; i < vertexCount; ) {
+        size_t batch = std::min(kVertexBatchSize, static_cast<size_t>(vertexCount - i));
+        const char* records = src.take(batch * vplan.stride);
+        if (records == nullptr) {
+            cerr << "错误: 读取二进制顶点数据时意外结束 (顶点 " << i << "/" << vertexCount << ")" << endl;
+            return false;
+        }
+        decodeVertexBatch(vplan, records, batch, mesh.streams(static_cast<size_t>(i)), scratch);
+        i += static_cast<int64_t>(batch);
+    }
+
+    // 读取面数据
+    scope.restart(ProfileStage::FaceDecode);
+    if (decodeFacesInParallel(src, fplan, faceCount, threadCount, keepPolygons, mesh)) return true;
+    reserveFaces(src, fplan, faceCount, keepPolygons, mesh);
+    return decodeFaceRecords(src, fplan, 0, faceCount, { &mesh.triangles, keepPolygons ? &mesh.polygons : nullptr });
+}
+
+// 把流中剩余的全部内容 (即数据体) 读入 body。不能定位的流 (管道、解压流) 分块读到结束为止。
+bool readRemainingStream(istream& file, vector<char>& body) {
+    ProfileScope scope(ProfileStage::BodyRead);
+    const streamoff start = file.tellg();
+    if (start < 0) {
+        file.clear();
+        const size_t kReadBlock = 1 << 20;
+        body.clear();
+        while (file) {
+            const size_t used = body.size();
+            body.resize(used + kReadBlock);
+            file.read(body.data() + used, kReadBlock);
+            body.resize(used + static_cast<size_t>(file.gcount()));
+        }
+        return !file.bad();
+    }
+    file.seekg(0, ios_base::end);
+    const streamoff end = file.tellg();
+    if (end < start) return false;
+    file.seekg(start);
+    body.resize(static_cast<size_t>(end - start));
+    return body.empty() || static_cast<bool>(file.read(body.data(), body.size()));
+}
+
+// 只读的内存 streambuf，供 readPLYHeader 解析内存中的文件头。支持定位，tellg 给出数据体的偏移。
+class MemoryStreamBuf : public streambuf {
+public:
+    MemoryStreamBuf(const char* data, size_t size) {
+        char* begin = const_cast<char*>(data); // 只通过 get 区域读取，不会写入
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which) override {
+        if (!(which & ios_base::in)) return pos_type(off_type(-1));
+        const off_type base = dir == ios_base::beg ? 0 : dir == ios_base::cur ? gptr() - eback() : egptr() - eback();
+        const off_type pos = base + off;
+        if (pos < 0 || pos > egptr() - eback()) return pos_type(off_type(-1));
+        setg(eback(), eback() + pos, egptr());
+        return pos_type(pos);
+    }
+    pos_type seekpos(pos_type pos, ios_base::openmode which) override {
+        return seekoff(off_type(pos), ios_base::beg, which);
+    }
+};
+
+// 解析文件头、构建解码计划，并按顶点数准备 mesh_out
+bool beginPLYRead(istream& file, const PlyReadOptions& options, PlyHeader& header,
+    VertexDecodePlan& vplan, FaceDecodePlan& fplan, Mesh& mesh_out,
+    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords) {
+    {
+        ProfileScope scope(ProfileStage::HeaderParse);
+        if (!readPLYHeader(file, header, file_has_normals, file_has_colors, file_has_texCoords)) {
+            return false;
+        }
+    }
+
+    const bool systemIsLE = isSystemLittleEndian();
+    if (!buildVertexDecodePlan(header, systemIsLE, vplan, options.attributes)) return false;
+    if (header.faceCount > 0 && !buildFaceDecodePlan(header, systemIsLE, fplan)) return false;
+    selectAttributes(options.attributes, file_has_normals, file_has_colors, file_has_texCoords);
+
+    // 复用 mesh_out 已有的容量 (批量转换时同一线程上的各文件共用一个网格)
+    mesh_out.clearFaces();
+    mesh_out.resetVertices(static_cast<size_t>(header.vertexCount), vplan.presence);
+    return true;
+}
+
+void profileMeshRead(const PlyHeader& header, const Mesh& mesh) {
+    profileAdd(ProfileCounter::FacesIn, static_cast<uint64_t>(header.faceCount));
+    profileAdd(ProfileCounter::TrianglesOut, mesh.triangles.size());
+    profileAdd(ProfileCounter::PolygonsOut, mesh.polygons.faceCount());
+}
+
+bool readPLYMemory(const void* data, size_t size, Mesh& mesh_out,
+    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords, const PlyReadOptions& options) {
+    const char* begin = static_cast<const char*>(data);
+    MemoryStreamBuf buffer(begin, size);
+    istream file(&buffer);
+
+    PlyHeader header;
+    VertexDecodePlan vplan;
+    FaceDecodePlan fplan;
+    if (!beginPLYRead(file, options, header, vplan, fplan, mesh_out, file_has_normals, file_has_colors, file_has_texCoords)) {
+        return false;
+    }
+    const streamoff bodyOffset = file.tellg();
+    if (bodyOffset < 0 || static_cast<size_t>(bodyOffset) > size) {
+        cerr << "错误: 无法定位PLY数据体。" << endl;
+        return false;
+    }
+    const char* body = begin + bodyOffset;
+    bool body_ok;
+    if (header.isASCII) {
+        body_ok = parseASCIIBody(body, begin + size, header, vplan, fplan.fieldsBefore, options.threadCount,
+            options.keepPolygons, mesh_out);
+    }
+    else {
+        MemorySource src{ body, begin + size };
+        body_ok = readBinaryBody(src, header, vplan, fplan, options.threadCount, options.keepPolygons, mesh_out);
+    }
+    if (body_ok && profilingEnabled()) profileMeshRead(header, mesh_out);
+    return body_ok;
+}
+
+bool readPLY(const string& plyPath, Mesh& mesh_out,
+    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords, const PlyReadOptions& options) {
+    InputStream input;
+    if (!input.open(plyPath)) return false;
+    istream& file = input.stream();
+
+    PlyHeader header;
+    VertexDecodePlan vplan;
+    FaceDecodePlan fplan;
+    if (!beginPLYRead(file, options, header, vplan, fplan, mesh_out, file_has_normals, file_has_colors, file_has_texCoords)) {
+        return false;
+    }
+
+    MappedFile mapped;
+    if (options.useMemoryMap && input.isPlainFile() && !mapped.open(plyPath)) {
+        cerr << "警告: 无法内存映射文件 " << plyPath << "，改用流式读取。" << endl;
+    }
+    const char* body = nullptr;
+    const char* bodyEnd = nullptr;
+    if (mapped.isOpen()) {
+        const streamoff bodyOffset = file.tellg();
+        if (bodyOffset < 0 || static_cast<size_t>(bodyOffset) > mapped.size()) {
+            cerr << "错误: 无法定位PLY数据体。" << endl;
+            return false;
+        }
+        body = mapped.data() + bodyOffset;
+        bodyEnd = mapped.data() + mapped.size();
+    }
+
+    bool body_ok = false;
+    if (header.isASCII) {
+        vector<char> bodyCopy;
+        if (body == nullptr) {
+            if (!readRemainingStream(file, bodyCopy)) {
+                cerr << "错误: 读取ASCII数据体失败。" << endl;
+                return false;
+            }
+            body = bodyCopy.data();
+            bodyEnd = body + bodyCopy.size();
+        }
+        body_ok = parseASCIIBody(body, bodyEnd, header, vplan, fplan.fieldsBefore, options.threadCount, options.keepPolygons, mesh_out);
+    }
+    else if (body != nullptr) {
+        MemorySource src{ body, bodyEnd };
+        body_ok = readBinaryBody(src, header, vplan, fplan, options.threadCount, options.keepPolygons, mesh_out);
+    }
+    else {
+        StreamSource src{ file, {} };
+        body_ok = readBinaryBody(src, header, vplan, fplan, options.threadCount, options.keepPolygons, mesh_out);
+    }
+    if (body_ok && profilingEnabled()) {
+        // 压缩输入和管道由 InputStream 统计实际读取的字节数
+        if (input.isPlainFile()) {
+            std::error_code ec;
+            const uintmax_t size = filesystem::file_size(plyPath, ec);
+            if (!ec) profileAdd(ProfileCounter::BytesRead, static_cast<uint64_t>(size));
+        }
+        profileMeshRead(header, mesh_out);
+    }
+    return body_ok;
+}
@@ -0,0 +1,30 @@
+﻿// PlyReader.h : 读取PLY文件 (ascii / binary_little_endian / binary_big_endian)
+//
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "Mesh.h"
+
+// PLY 读取选项
+struct PlyReadOptions {
+    bool useMemoryMap = true; // 使用内存映射直接解码数据体 (映射失败时自动回退到流式读取)
+    unsigned threadCount = 1; // ASCII 数据体并行解析使用的线程数
+    bool keepPolygons = false; // 保留多边形面 (存入 Mesh::polygons)，不做三角化
+    uint8_t attributes = kPresenceAll; // 要解码的可选属性 (kPresence* 标志)，其余属性读取时跳过，也不写入OBJ
+};
+
+// 解析逗号分隔的属性列表 (pos、normal、color、uv 及其别名) 为 kPresence* 标志，位置总是读取。
+// 遇到未知名称时返回 false。
+bool parseVertexAttributes(const std::string& list, uint8_t& attributes);
+
+// 读取PLY文件到 mesh_out。file_has_* 为文件头中声明且在 options.attributes 中的属性。
+// 不使用任何全局状态，可以在多个线程上同时读取不同的文件。
+bool readPLY(const std::string& plyPath, Mesh& mesh_out,
+    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords, const PlyReadOptions& options = PlyReadOptions());
+
+// 从内存中的完整PLY文件 (含文件头) 读取，数据体直接在 data 上解码，不复制。
+// 适合网络请求的内容或调用方自己映射的区域；options.useMemoryMap 不起作用。
+bool readPLYMemory(const void* data, size_t size, Mesh& mesh_out,
+    bool& file_has_normals, bool& file_has_colors, bool& file_has_texCoords, const PlyReadOptions& options = PlyReadOptions());
@@ -0,0 +1,272 @@
+﻿// Profile.cpp : 分阶段计时与计数器的实现
+//
+
+#include "Profile.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+typedef std::chrono::steady_clock ProfileClock;
+
+// 跟踪模式下的一段计时 (包括嵌套的部分)
+struct ProfileEvent {
+    ProfileStage stage;
+    unsigned thread;
+    int64_t start, duration;
+};
+
+// 常量初始化，替换的 operator new 在任何静态对象构造之前就可以检查
+atomic<bool> profileEnabledFlag{ false };
+
+struct ProfileState {
+    ProfileMode mode = ProfileMode::Off;
+    ProfileClock::time_point origin;
+    double cpuUserStartMs = 0.0, cpuSystemStartMs = 0.0;
+    atomic<int64_t> stageNanoseconds[static_cast<size_t>(ProfileStage::Count)];
+    atomic<uint64_t> stageCalls[static_cast<size_t>(ProfileStage::Count)];
+    atomic<uint64_t> counters[static_cast<size_t>(ProfileCounter::Count)];
+    atomic<unsigned> nextThread{ 0 };
+    mutex eventMutex;
+    vector<ProfileEvent> events;
+};
+
+// 不在退出时析构，退出过程中仍可能有计时结束
+ProfileState& profileState() {
+    static ProfileState* state = new ProfileState();
+    return *state;
+}
+
+const char* profileStageName(ProfileStage stage) {
+    switch (stage) {
+    case ProfileStage::HeaderParse: return "header_parse";
+    case ProfileStage::BodyRead: return "body_read";
+    case ProfileStage::BodyIndex: return "body_index";
+    case ProfileStage::Prefetch: return "prefetch";
+    case ProfileStage::VertexDecode: return "vertex_decode";
+    case ProfileStage::FaceDecode: return "face_decode";
+    case ProfileStage::FaceMerge: return "face_merge";
+    case ProfileStage::Weld: return "weld";
+    case ProfileStage::CacheOptimize: return "cache_optimize";
+    case ProfileStage::Format: return "format";
+    case ProfileStage::OutputWait: return "output_wait";
+    case ProfileStage::Compress: return "compress";
+    case ProfileStage::Write: return "write";
+    case ProfileStage::InputRead: return "input_read";
+    case ProfileStage::Decompress: return "decompress";
+    case ProfileStage::Tile: return "tile";
+    case ProfileStage::Normals: return "normals";
+    default: return "unknown";
+    }
+}
+
+const char* profileCounterName(ProfileCounter counter) {
+    switch (counter) {
+    case ProfileCounter::BytesRead: return "bytes_read";
+    case ProfileCounter::BytesWritten: return "bytes_written";
+    case ProfileCounter::Allocations: return "allocations";
+    case ProfileCounter::AllocatedBytes: return "allocated_bytes";
+    case ProfileCounter::FacesIn: return "faces_in";
+    case ProfileCounter::TrianglesOut: return "triangles_out";
+    case ProfileCounter::PolygonsOut: return "polygons_out";
+    default: return "unknown";
+    }
+}
+
+int64_t profileNow() {
+    return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        ProfileClock::now() - profileState().origin).count());
+}
+
+// 跟踪事件中的线程编号，按首次记录的顺序分配
+unsigned profileThreadId() {
+    thread_local unsigned id = profileState().nextThread.fetch_add(1);
+    return id;
+}
+
+// 当前线程最内层的计时
+thread_local ProfileScope* currentProfileScope = nullptr;
+
+// 进程已使用的用户态 / 内核态 CPU 时间 (毫秒)
+void processCpuMilliseconds(double& user, double& system) {
+    user = system = 0.0;
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, userTime;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &userTime)) {
+        auto ms = [](const FILETIME& t) {
+            return static_cast<double>((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10000.0;
+        };
+        user = ms(userTime);
+        system = ms(kernel);
+    }
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        user = usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0;
+        system = usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+    }
+#endif
+}
+
+void startProfiling(ProfileMode mode) {
+    ProfileState& state = profileState();
+    profileEnabledFlag = false;
+    for (auto& v : state.stageNanoseconds) v = 0;
+    for (auto& v : state.stageCalls) v = 0;
+    for (auto& v : state.counters) v = 0;
+    {
+        lock_guard<mutex> lock(state.eventMutex);
+        state.events.clear();
+    }
+    state.mode = mode;
+    state.origin = ProfileClock::now();
+    processCpuMilliseconds(state.cpuUserStartMs, state.cpuSystemStartMs);
+    profileEnabledFlag = mode != ProfileMode::Off;
+}
+
+bool profilingEnabled() {
+    return profileEnabledFlag.load(memory_order_relaxed);
+}
+
+ProfileScope::ProfileScope(ProfileStage stage) : stage_(stage), active_(profilingEnabled()) {
+    if (!active_) return;
+    start_ = profileNow();
+    parent_ = currentProfileScope;
+    currentProfileScope = this;
+}
+
+ProfileScope::~ProfileScope() {
+    if (!active_) return;
+    record(profileNow());
+    currentProfileScope = parent_;
+}
+
+void ProfileScope::restart(ProfileStage stage) {
+    if (!active_) return;
+    const int64_t now = profileNow();
+    record(now);
+    stage_ = stage;
+    start_ = now;
+    nested_ = 0;
+}
+
+void ProfileScope::record(int64_t now) {
+    ProfileState& state = profileState();
+    const int64_t duration = now - start_;
+    const size_t s = static_cast<size_t>(stage_);
+    state.stageNanoseconds[s].fetch_add(duration - nested_, memory_order_relaxed);
+    state.stageCalls[s].fetch_add(1, memory_order_relaxed);
+    if (parent_ != nullptr) parent_->nested_ += duration;
+    if (state.mode == ProfileMode::Trace) {
+        const ProfileEvent event = { stage_, profileThreadId(), start_, duration };
+        lock_guard<mutex> lock(state.eventMutex);
+        state.events.push_back(event);
+    }
+}
+
+void profileAdd(ProfileCounter counter, uint64_t value) {
+    if (!profilingEnabled()) return;
+    profileState().counters[static_cast<size_t>(counter)].fetch_add(value, memory_order_relaxed);
+}
+
+void profileRecordAllocation(size_t bytes) {
+    if (!profilingEnabled()) return;
+    ProfileState& state = profileState();
+    state.counters[static_cast<size_t>(ProfileCounter::Allocations)].fetch_add(1, memory_order_relaxed);
+    state.counters[static_cast<size_t>(ProfileCounter::AllocatedBytes)].fetch_add(bytes, memory_order_relaxed);
+}
+
+uint64_t peakResidentBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+#if defined(__linux__)
+    // VmHWM 可以通过 /proc/self/clear_refs 重置，ru_maxrss 不能
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return static_cast<uint64_t>(stoull(line.substr(6))) * 1024;
+    }
+#endif
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss); // macOS 以字节为单位
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// 汇总信息：墙钟与CPU时间、峰值内存、各阶段 (各线程累计) 时间与计数器
+void writeProfileSummary(ostream& out) {
+    ProfileState& state = profileState();
+    const double wallMs = static_cast<double>(profileNow()) / 1e6;
+    double userMs, systemMs;
+    processCpuMilliseconds(userMs, systemMs);
+    out << "{\"wall_ms\":" << wallMs
+        << ",\"cpu_user_ms\":" << (userMs - state.cpuUserStartMs)
+        << ",\"cpu_system_ms\":" << (systemMs - state.cpuSystemStartMs)
+        << ",\"peak_rss_bytes\":" << peakResidentBytes()
+        << ",\"stages\":{";
+    bool first = true;
+    for (size_t s = 0; s < static_cast<size_t>(ProfileStage::Count); ++s) {
+        const uint64_t calls = state.stageCalls[s];
+        if (calls == 0) continue;
+        out << (first ? "" : ",") << "\"" << profileStageName(static_cast<ProfileStage>(s)) << "\":{\"ms\":"
+            << static_cast<double>(state.stageNanoseconds[s]) / 1e6 << ",\"calls\":" << calls << "}";
+        first = false;
+    }
+    out << "},\"counters\":{";
+    for (size_t c = 0; c < static_cast<size_t>(ProfileCounter::Count); ++c) {
+        out << (c == 0 ? "" : ",") << "\"" << profileCounterName(static_cast<ProfileCounter>(c)) << "\":"
+            << state.counters[c];
+    }
+    out << "}}";
+}
+
+void writeProfileReport(ostream& out, ProfileMode mode) {
+    ProfileState& state = profileState();
+    // 输出时不再统计 (写报告本身的分配不计入)
+    profileEnabledFlag = false;
+    if (mode != ProfileMode::Trace) {
+        writeProfileSummary(out);
+        out << "\n";
+        return;
+    }
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    lock_guard<mutex> lock(state.eventMutex);
+    bool first = true;
+    for (const ProfileEvent& event : state.events) {
+        out << (first ? "\n" : ",\n") << "{\"name\":\"" << profileStageName(event.stage)
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << static_cast<double>(event.start) / 1e3
+            << ",\"dur\":" << static_cast<double>(event.duration) / 1e3 << "}";
+        first = false;
+    }
+    out << "\n],\"otherData\":";
+    writeProfileSummary(out);
+    out << "}\n";
+}
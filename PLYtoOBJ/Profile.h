@@ -0,0 +1,82 @@
+﻿// Profile.h : 分阶段计时与计数器 (--profile)
+//
+// 未启用时每个计时点只检查一次标志；启用后各线程的计时累加到全局计数器，
+// 嵌套的计时只计入最内层的阶段，各阶段的时间互不重叠。
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+enum class ProfileStage : uint8_t {
+    HeaderParse,   // 解析文件头
+    BodyRead,      // 把不能映射的数据体读入内存
+    BodyIndex,     // 扫描数据体、划分块 (ASCII 行计数、流式转换的索引)
+    Prefetch,      // 流水线模式的预读
+    VertexDecode,
+    FaceDecode,    // 包括三角化 (扇形展开与解码在同一遍中完成)
+    FaceMerge,     // 合并各块的面
+    Weld,
+    CacheOptimize,
+    Format,        // 格式化OBJ文本
+    OutputWait,    // 把文本交给输出流，包括等待后台压缩 / 写入线程
+    Compress,
+    Write,         // 写入文件的调用
+    InputRead,     // 读取压缩输入或管道
+    Decompress,
+    Tile,          // 空间分块：分配面、收集各块的顶点
+    Normals,       // 由面计算顶点法线
+    Count
+};
+
+enum class ProfileCounter : uint8_t {
+    BytesRead,
+    BytesWritten,
+    Allocations,    // operator new 的调用次数 (只有链接了分配计数的程序才会统计)
+    AllocatedBytes,
+    FacesIn,        // 输入文件中的面数
+    TrianglesOut,
+    PolygonsOut,
+    Count
+};
+
+enum class ProfileMode : uint8_t {
+    Off,
+    Summary, // 各阶段累计时间与计数器 (JSON)
+    Trace    // 另外记录每一段计时，输出 Chrome 跟踪格式 (chrome://tracing、Perfetto)
+};
+
+// 清空计数器并开始记录，mode 为 Off 时停止记录
+void startProfiling(ProfileMode mode);
+bool profilingEnabled();
+
+// 在作用域内把时间计入 stage。restart 结束当前阶段并开始下一个阶段。
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileStage stage);
+    ~ProfileScope();
+    void restart(ProfileStage stage);
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    void record(int64_t now);
+
+    ProfileStage stage_;
+    bool active_;
+    int64_t start_ = 0;    // 相对开始记录时的纳秒数
+    int64_t nested_ = 0;   // 本段中嵌套计时占用的纳秒数
+    ProfileScope* parent_ = nullptr;
+};
+
+void profileAdd(ProfileCounter counter, uint64_t value);
+
+// 由替换的 operator new 调用
+void profileRecordAllocation(size_t bytes);
+
+// 进程的峰值常驻内存 (字节)，无法获取时为 0
+uint64_t peakResidentBytes();
+
+// 输出记录的结果：Summary 为 JSON 对象，Trace 为 Chrome 跟踪格式 (汇总信息放在 otherData 中)
+void writeProfileReport(std::ostream& out, ProfileMode mode);
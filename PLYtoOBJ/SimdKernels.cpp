@@ -0,0 +1,222 @@
+﻿// SimdKernels.cpp : 批量内核的各指令集实现与运行时分发
+//
+// x86 上在首次调用时通过 CPUID 选择 AVX2 / SSSE3 / 标量实现；
+// AArch64 上 NEON 总是可用，直接在编译期选用。
+
+#include "SimdKernels.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PLYTOOBJ_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PLYTOOBJ_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang 需要为单个函数开启指令集，MSVC 直接允许使用内建函数
+#if defined(PLYTOOBJ_SIMD_X86) && !defined(_MSC_VER)
+#define PLYTOOBJ_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PLYTOOBJ_TARGET(isa)
+#endif
+
+namespace {
+
+// ---- 标量实现 ----
+
+void byteSwap32Scalar(const void* src, void* dst, size_t count) {
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+    unsigned char* d = static_cast<unsigned char*>(dst);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t v;
+        memcpy(&v, s + i * 4, 4);
+        v = (v >> 24) | ((v >> 8) & 0x0000FF00u) | ((v << 8) & 0x00FF0000u) | (v << 24);
+        memcpy(d + i * 4, &v, 4);
+    }
+}
+
+void unitFloatsFromBytesScalar(const uint8_t* src, float* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = static_cast<float>(src[i]) / 255.0f;
+    }
+}
+
+#if defined(PLYTOOBJ_SIMD_X86)
+
+// ---- SSSE3 (字节交换) / SSE2 (颜色转换) ----
+
+PLYTOOBJ_TARGET("ssse3")
+void byteSwap32SSSE3(const void* src, void* dst, size_t count) {
+    const char* s = static_cast<const char*>(src);
+    char* d = static_cast<char*>(dst);
+    const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i * 4), _mm_shuffle_epi8(v, mask));
+    }
+    byteSwap32Scalar(s + i * 4, d + i * 4, count - i);
+}
+
+PLYTOOBJ_TARGET("sse2")
+void unitFloatsFromBytesSSE2(const uint8_t* src, float* dst, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 divisor = _mm_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i lo16 = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi16 = _mm_unpackhi_epi8(bytes, zero);
+        // 使用真正的除法而不是乘以倒数，保证与标量结果逐位一致
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo16, zero)), divisor));
+        _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo16, zero)), divisor));
+        _mm_storeu_ps(dst + i + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi16, zero)), divisor));
+        _mm_storeu_ps(dst + i + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi16, zero)), divisor));
+    }
+    unitFloatsFromBytesScalar(src + i, dst + i, count - i);
+}
+
+// ---- AVX2 ----
+
+PLYTOOBJ_TARGET("avx2")
+void byteSwap32AVX2(const void* src, void* dst, size_t count) {
+    const char* s = static_cast<const char*>(src);
+    char* d = static_cast<char*>(dst);
+    const __m256i mask = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i * 4));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i * 4 + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i * 4), _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i * 4 + 32), _mm256_shuffle_epi8(b, mask));
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i * 4), _mm256_shuffle_epi8(a, mask));
+    }
+    byteSwap32Scalar(s + i * 4, d + i * 4, count - i);
+}
+
+PLYTOOBJ_TARGET("avx2")
+void unitFloatsFromBytesAVX2(const uint8_t* src, float* dst, size_t count) {
+    const __m256 divisor = _mm256_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m256i lo = _mm256_cvtepu8_epi32(bytes);
+        __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8));
+        _mm256_storeu_ps(dst + i, _mm256_div_ps(_mm256_cvtepi32_ps(lo), divisor));
+        _mm256_storeu_ps(dst + i + 8, _mm256_div_ps(_mm256_cvtepi32_ps(hi), divisor));
+    }
+    unitFloatsFromBytesScalar(src + i, dst + i, count - i);
+}
+
+// CPUID 检测。AVX2 还需要操作系统保存 YMM 寄存器状态 (OSXSAVE + XGETBV)。
+struct CpuFeatures {
+    bool ssse3 = false;
+    bool avx2 = false;
+};
+
+#ifdef _MSC_VER
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures f;
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    if (maxLeaf < 1) return f;
+    __cpuid(info, 1);
+    f.ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        f.avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return f;
+}
+#else
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures f;
+    __builtin_cpu_init();
+    f.ssse3 = __builtin_cpu_supports("ssse3") != 0;
+    f.avx2 = __builtin_cpu_supports("avx2") != 0;
+    return f;
+}
+#endif
+
+#elif defined(PLYTOOBJ_SIMD_NEON)
+
+// ---- NEON ----
+
+void byteSwap32NEON(const void* src, void* dst, size_t count) {
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+    uint8_t* d = static_cast<uint8_t*>(dst);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u8(d + i * 4, vrev32q_u8(vld1q_u8(s + i * 4)));
+    }
+    byteSwap32Scalar(s + i * 4, d + i * 4, count - i);
+}
+
+void unitFloatsFromBytesNEON(const uint8_t* src, float* dst, size_t count) {
+    const float32x4_t divisor = vdupq_n_f32(255.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t bytes = vld1q_u8(src + i);
+        uint16x8_t lo16 = vmovl_u8(vget_low_u8(bytes));
+        uint16x8_t hi16 = vmovl_u8(vget_high_u8(bytes));
+        vst1q_f32(dst + i, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo16))), divisor));
+        vst1q_f32(dst + i + 4, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo16))), divisor));
+        vst1q_f32(dst + i + 8, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi16))), divisor));
+        vst1q_f32(dst + i + 12, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi16))), divisor));
+    }
+    unitFloatsFromBytesScalar(src + i, dst + i, count - i);
+}
+
+#endif
+
+struct KernelTable {
+    void (*byteSwap32)(const void*, void*, size_t);
+    void (*unitFloats)(const uint8_t*, float*, size_t);
+    const char* name;
+};
+
+KernelTable selectKernels() {
+#if defined(PLYTOOBJ_SIMD_X86)
+    CpuFeatures f = detectCpuFeatures();
+    if (f.avx2) return { byteSwap32AVX2, unitFloatsFromBytesAVX2, "avx2" };
+    if (f.ssse3) return { byteSwap32SSSE3, unitFloatsFromBytesSSE2, "ssse3" };
+#if defined(__x86_64__) || defined(_M_X64)
+    return { byteSwap32Scalar, unitFloatsFromBytesSSE2, "sse2" }; // x86-64 总是支持 SSE2
+#endif
+#elif defined(PLYTOOBJ_SIMD_NEON)
+    return { byteSwap32NEON, unitFloatsFromBytesNEON, "neon" };
+#endif
+    return { byteSwap32Scalar, unitFloatsFromBytesScalar, "scalar" };
+}
+
+const KernelTable& kernels() {
+    static const KernelTable table = selectKernels(); // 线程安全的一次性初始化
+    return table;
+}
+
+} // namespace
+
+void byteSwap32Block(const void* src, void* dst, size_t count) {
+    kernels().byteSwap32(src, dst, count);
+}
+
+void unitFloatsFromBytes(const uint8_t* src, float* dst, size_t count) {
+    kernels().unitFloats(src, dst, count);
+}
+
+const char* simdKernelName() {
+    return kernels().name;
+}
@@ -0,0 +1,16 @@
+﻿// SimdKernels.h : 批量字节序交换与颜色转换内核 (SSE/AVX2/NEON，运行时选择)
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 将 count 个 32 位字从 src 复制到 dst 并逐个交换字节序。
+// src 与 dst 可以相同 (就地交换)，不要求对齐。
+void byteSwap32Block(const void* src, void* dst, size_t count);
+
+// 将 count 个 uchar 转换为 0-1 的 float (v / 255.0f)，结果与标量除法逐位一致。
+void unitFloatsFromBytes(const uint8_t* src, float* dst, size_t count);
+
+// 当前进程选用的内核实现名称 ("avx2", "ssse3", "sse2", "neon" 或 "scalar")
+const char* simdKernelName();
@@ -0,0 +1,475 @@
+﻿// StreamConvert.cpp : 流式转换的实现
+//
+
+#include "StreamConvert.h"
+#include "PlyDecode.h"
+
+#include <iostream>
+#include <istream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <cstdio>      // for std::remove
+#include <cstring>     // for memchr
+
+#include "InputStream.h"
+#include "MappedFile.h"
+#include "ParallelChunks.h"
+#include "Profile.h"
+
+using namespace std;
+
+// ---- 流式转换 ----
+// 不把整个网格载入内存：先对映射的数据体做一次轻量的索引扫描 (每块的起始偏移和三角形总数)，
+// 再按块解码并立即格式化输出。vt/vn 段直接重新解码映射输入中的顶点块，不需要临时文件。
+// 任何时刻内存中只有 2 * 线程数 个块的解码结果和文本，块的大小由 bufferBytes 决定。
+
+// 数据体中的一块：从 offset 开始、长 bytes 字节的 count 个元素 (二进制记录或ASCII行)，
+// first 是块中第一个元素的序号
+struct BodyChunk {
+    size_t offset, bytes, count, first;
+};
+
+struct StreamIndex {
+    vector<BodyChunk> vertexChunks;
+    vector<BodyChunk> faceChunks;
+    size_t triangleCount = 0;
+    size_t polygonCount = 0; // 顶点数不少于3的面数 (保留多边形时的输出面数)
+};
+
+// 二进制数据体：顶点块按定长记录直接计算，面记录需要逐条读取计数来确定边界
+bool indexBinaryBody(const char* body, const char* bodyEnd, const PlyHeader& header, const VertexDecodePlan& vplan,
+    const FaceDecodePlan& fplan, size_t vertexBatch, size_t faceBatch, StreamIndex& index) {
+    const size_t bodySize = static_cast<size_t>(bodyEnd - body);
+    const size_t vertexCount = static_cast<size_t>(header.vertexCount);
+    const size_t faceCount = static_cast<size_t>(header.faceCount);
+
+    if (vplan.stride > 0 && vertexCount > bodySize / vplan.stride) {
+        cerr << "错误: 读取二进制顶点数据时意外结束 (顶点 " << bodySize / vplan.stride << "/" << vertexCount << ")" << endl;
+        return false;
+    }
+    for (size_t first = 0; first < vertexCount; first += vertexBatch) {
+        const size_t count = std::min(vertexBatch, vertexCount - first);
+        index.vertexChunks.push_back({ first * vplan.stride, count * vplan.stride, count, first });
+    }
+
+    size_t offset = vertexCount * vplan.stride;
+    for (size_t f = 0; f < faceCount; ) {
+        BodyChunk chunk = { offset, 0, 0, f };
+        for (; f < faceCount && chunk.count < faceBatch; ++f, ++chunk.count) {
+            const size_t head = fplan.skipBefore + fplan.countSize;
+            int64_t n = -1;
+            if (bodySize - offset >= head) {
+                n = loadScalarAsInt(body + offset + fplan.skipBefore, fplan.countType, fplan.swap);
+            }
+            const size_t record = n < 0 ? 0 : head + static_cast<size_t>(n) * fplan.indexSize + fplan.skipAfter;
+            if (n < 0 || bodySize - offset < record) {
+                cerr << "错误: 读取二进制面数据时意外结束或面记录无效 (面 " << f << "/" << faceCount << ")" << endl;
+                return false;
+            }
+            offset += record;
+            if (n >= 3) {
+                index.triangleCount += static_cast<size_t>(n - 2);
+                ++index.polygonCount;
+            }
+        }
+        chunk.bytes = offset - chunk.offset;
+        index.faceChunks.push_back(chunk);
+    }
+    return true;
+}
+
+// 读取面行中的顶点数 (在 fieldsBefore 中的其他属性之后)，无法解析时返回0
+int asciiFaceVertexCount(const char* p, const char* lineEnd, const vector<bool>& fieldsBefore) {
+    const char* first;
+    const char* last;
+    for (bool isList : fieldsBefore) {
+        if (!skipAsciiField(p, lineEnd, isList)) return 0;
+    }
+    int n = 0;
+    if (!nextToken(p, lineEnd, first, last) || !parseNumber(first, last, n)) return 0;
+    return n;
+}
+
+// ASCII数据体：逐行扫描记录每块的起始位置，并累计每个面三角化后的三角形数
+bool indexASCIIBody(const char* body, const char* bodyEnd, const PlyHeader& header, const vector<bool>& faceFieldsBefore,
+    size_t vertexBatch, size_t faceBatch, StreamIndex& index) {
+    const char* p = body;
+    auto indexLines = [&](size_t total, size_t batch, vector<BodyChunk>& chunks, bool faces) {
+        for (size_t i = 0; i < total; ++i) {
+            if (p >= bodyEnd) {
+                if (faces) cerr << "错误: 读取ASCII面数据时意外结束 (面 " << i << "/" << total << ")" << endl;
+                else cerr << "错误: 读取ASCII顶点数据时意外结束 (顶点 " << i << "/" << total << ")" << endl;
+                return false;
+            }
+            if (i % batch == 0) {
+                chunks.push_back({ static_cast<size_t>(p - body), 0, 0, i });
+            }
+            const char* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(bodyEnd - p)));
+            const char* lineEnd = nl ? nl : bodyEnd;
+            if (faces) {
+                int n = asciiFaceVertexCount(p, lineEnd, faceFieldsBefore);
+                if (n >= 3) {
+                    index.triangleCount += static_cast<size_t>(n - 2);
+                    ++index.polygonCount;
+                }
+            }
+            p = nl ? nl + 1 : bodyEnd;
+            BodyChunk& chunk = chunks.back();
+            chunk.count++;
+            chunk.bytes = static_cast<size_t>(p - body) - chunk.offset;
+        }
+        return true;
+    };
+    return indexLines(static_cast<size_t>(header.vertexCount), vertexBatch, index.vertexChunks, false) &&
+        indexLines(static_cast<size_t>(header.faceCount), faceBatch, index.faceChunks, true);
+}
+
+// 一块ASCII顶点中无效或超出范围的属性值个数与第一个这样的顶点
+struct VertexChunkWarnings {
+    int64_t badValues = 0;
+    int64_t firstBadLine = -1;
+};
+
+// 按块随机访问映射的数据体并解码。各方法只读共享状态，可以在多个线程上同时调用。
+struct StreamingDecoder {
+    const char* body;
+    const PlyHeader& header;
+    const VertexDecodePlan& vplan;
+    const FaceDecodePlan& fplan;
+    vector<int> fieldOps; // ASCII: 字段序号 -> 计划步骤
+
+    // warnings 非空时统计ASCII顶点中被忽略的无效值 (与整体读取时一样只警告，不视为错误)
+    bool decodeVertices(const BodyChunk& chunk, Mesh& out, DecodeScratch& scratch, string& error,
+        VertexChunkWarnings* warnings) const {
+        out.resetVertices(chunk.count, vplan.presence);
+        const char* p = body + chunk.offset;
+        if (!header.isASCII) {
+            decodeVertexBatch(vplan, p, chunk.count, out.streams(), scratch);
+            return true;
+        }
+        const VertexFloatStreams vertexOut(out.streams());
+        const char* end = p + chunk.bytes;
+        for (size_t k = 0; k < chunk.count; ++k) {
+            const size_t line = chunk.first + k;
+            const char* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+            const char* lineEnd = nl ? nl : end;
+            if (lineEnd == p) {
+                if (line + 1 < static_cast<size_t>(header.vertexCount)) {
+                    error = "错误: 读取ASCII顶点数据时遇到空行 (顶点 " + to_string(line) + "/" + to_string(header.vertexCount) + ")";
+                    return false;
+                }
+            }
+            else if (!parseAsciiVertexLine(p, lineEnd, vplan, fieldOps, vertexOut, k) && warnings != nullptr) {
+                if (warnings->badValues++ == 0) warnings->firstBadLine = static_cast<int64_t>(line);
+            }
+            p = nl ? nl + 1 : end;
+        }
+        return true;
+    }
+
+    // 解码一块面记录，out 中对应的数组先被清空
+    bool decodeFaces(const BodyChunk& chunk, const FaceOutput& out, string& error) const {
+        out.triangles->clear();
+        if (out.polygons != nullptr) out.polygons->clear();
+        const char* p = body + chunk.offset;
+        const char* end = p + chunk.bytes;
+        if (!header.isASCII) {
+            MemorySource src{ p, end };
+            if (!decodeBinaryFaces(src, fplan, static_cast<int64_t>(chunk.first), static_cast<int64_t>(chunk.count), out)) {
+                error = "错误: 解码二进制面数据失败 (面 " + to_string(chunk.first) + " 起)";
+                return false;
+            }
+            return true;
+        }
+        for (size_t k = 0; k < chunk.count; ++k) {
+            const size_t face = chunk.first + k;
+            const char* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+            const char* lineEnd = nl ? nl : end;
+            if (lineEnd == p) {
+                if (face + 1 < static_cast<size_t>(header.faceCount)) {
+                    error = "错误: 读取ASCII面数据时遇到空行 (面 " + to_string(face) + "/" + to_string(header.faceCount) + ")";
+                    return false;
+                }
+            }
+            else if (!parseAsciiFaceLine(p, lineEnd, fplan.fieldsBefore, out)) {
+                error = "错误: 读取ASCII面 " + to_string(face) + " 的顶点索引时出错。";
+                return false;
+            }
+            p = nl ? nl + 1 : end;
+        }
+        return true;
+    }
+};
+
+// 每页读取一个字节，把映射的输入页读入内存。返回值只用于防止读取被优化掉。
+unsigned touchPages(const char* p, size_t bytes) {
+    const size_t kPageBytes = 4096;
+    unsigned sum = 0;
+    for (size_t offset = 0; offset < bytes; offset += kPageBytes) sum += static_cast<unsigned char>(p[offset]);
+    return sum;
+}
+
+bool convertPLYToOBJStreaming(const string& plyPath, const string& objPath, const PlyReadOptions& readOptions,
+    const ObjWriteOptions& writeOptions, const StreamOptions& streamOptions,
+    size_t& vertexCount_out, size_t& triangleCount_out,
+    bool& has_normals, bool& has_colors, bool& has_texCoords, StreamStats* stats) {
+    typedef std::chrono::steady_clock Clock;
+    auto nanosecondsSince = [](Clock::time_point start) {
+        return static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    };
+
+    PlyHeader header;
+    streamoff bodyOffset = -1;
+    {
+        InputStream input;
+        if (!input.open(plyPath)) return false;
+        if (!input.isPlainFile()) {
+            cerr << "错误: 流式转换需要内存映射输入文件，不支持标准输入和压缩文件 " << plyPath << endl;
+            return false;
+        }
+        ProfileScope scope(ProfileStage::HeaderParse);
+        if (!readPLYHeader(input.stream(), header, has_normals, has_colors, has_texCoords)) {
+            return false;
+        }
+        bodyOffset = input.stream().tellg();
+    }
+
+    const bool systemIsLE = isSystemLittleEndian();
+    VertexDecodePlan vplan;
+    FaceDecodePlan fplan;
+    if (!buildVertexDecodePlan(header, systemIsLE, vplan, readOptions.attributes)) return false;
+    selectAttributes(readOptions.attributes, has_normals, has_colors, has_texCoords);
+    if (header.faceCount > 0 && !buildFaceDecodePlan(header, systemIsLE, fplan)) return false;
+
+    MappedFile mapped;
+    if (!mapped.open(plyPath)) {
+        cerr << "错误: 流式转换需要内存映射输入文件，但无法映射 " << plyPath << endl;
+        return false;
+    }
+    if (bodyOffset < 0 || static_cast<size_t>(bodyOffset) > mapped.size()) {
+        cerr << "错误: 无法定位PLY数据体。" << endl;
+        return false;
+    }
+    const char* body = mapped.data() + bodyOffset;
+    const char* bodyEnd = mapped.data() + mapped.size();
+
+    // 每块的元素数：让 2 * 线程数 个块的解码结果与文本 (每行约128字节) 不超过缓冲区上限
+    const size_t window = static_cast<size_t>(std::max(1u, writeOptions.threadCount)) * 2;
+    const size_t perChunk = std::max<size_t>(streamOptions.bufferBytes / window, 1);
+    const size_t vertexBatch = std::max<size_t>(perChunk / (Mesh::vertexBytes(vplan.presence) + 128), 1024);
+    const size_t faceBatch = std::max<size_t>(perChunk / (2 * (sizeof(Triangle) + 128)), 1024);
+
+    auto indexStart = Clock::now();
+    StreamIndex index;
+    bool indexed;
+    {
+        ProfileScope scope(ProfileStage::BodyIndex);
+        indexed = header.isASCII
+            ? indexASCIIBody(body, bodyEnd, header, fplan.fieldsBefore, vertexBatch, faceBatch, index)
+            : indexBinaryBody(body, bodyEnd, header, vplan, fplan, vertexBatch, faceBatch, index);
+    }
+    if (!indexed) return false;
+    const long long indexNanoseconds = nanosecondsSince(indexStart);
+
+    StreamingDecoder decoder{ body, header, vplan, fplan, vector<int>() };
+    if (header.isASCII) decoder.fieldOps = buildAsciiFieldOps(header, vplan);
+
+    // 输出任务：文件头、各段的块。某段没有块时用 kNoChunk 只输出段尾的空行。
+    const size_t kNoChunk = static_cast<size_t>(-1);
+    struct StreamJob { ObjSection section; size_t chunk; bool endsSection; };
+    vector<StreamJob> jobs;
+    jobs.push_back({ ObjSection::Header, kNoChunk, false });
+    auto addSection = [&jobs, kNoChunk](ObjSection section, size_t chunkCount) {
+        if (chunkCount == 0) jobs.push_back({ section, kNoChunk, true });
+        for (size_t c = 0; c < chunkCount; ++c) jobs.push_back({ section, c, c + 1 == chunkCount });
+    };
+    addSection(ObjSection::Vertices, index.vertexChunks.size());
+    if (has_texCoords) addSection(ObjSection::TexCoords, index.vertexChunks.size());
+    if (has_normals) addSection(ObjSection::Normals, index.vertexChunks.size());
+    for (size_t c = 0; c < index.faceChunks.size(); ++c) jobs.push_back({ ObjSection::Faces, c, false });
+
+    // 任务对应的输入块，文件头等没有输入的任务为空
+    auto jobInput = [&](const StreamJob& job) -> const BodyChunk* {
+        if (job.chunk == kNoChunk || job.section == ObjSection::Header) return nullptr;
+        return job.section == ObjSection::Faces ? &index.faceChunks[job.chunk] : &index.vertexChunks[job.chunk];
+    };
+
+    const size_t vertexCount = static_cast<size_t>(header.vertexCount);
+    const bool keepPolygons = readOptions.keepPolygons;
+    const size_t faceCount = keepPolygons ? index.polygonCount : index.triangleCount;
+    uint64_t sizeHint = 0;
+    if (writeOptions.asyncWrite.enabled) {
+        // 多边形的顶点总数 = 三角形数 + 2 * 多边形数
+        const double corners = keepPolygons ? static_cast<double>(index.triangleCount + 2 * index.polygonCount)
+            : 3.0 * static_cast<double>(index.triangleCount);
+        sizeHint = estimateOBJBytes(vertexCount, static_cast<double>(faceCount), corners, vplan.presence,
+            has_normals, has_texCoords, writeOptions.floatFormat);
+    }
+    unique_ptr<OutputSink> out = openOutputSink(objPath, writeOptions.compression, streamOptions.pipeline,
+        writeOptions.asyncWrite, sizeHint);
+    if (!out) {
+        cerr << "错误: 无法创建OBJ文件 " << objPath << endl;
+        return false;
+    }
+
+    std::atomic<bool> failed(false);
+    std::mutex errorMutex;
+    string firstError;
+    // 每个顶点块在 v、vt、vn 段各解码一次，只在输出 v 段时统计无效值
+    vector<VertexChunkWarnings> vertexWarnings(header.isASCII ? index.vertexChunks.size() : 0);
+    std::atomic<long long> decodeNanoseconds(0), formatNanoseconds(0);
+    long long writeNanoseconds = 0, prefetchNanoseconds = 0;
+
+    // 预读线程：按任务顺序读入输入页，最多领先已输出的任务 2 * window 个
+    std::mutex prefetchMutex;
+    std::condition_variable prefetchAdvanced;
+    size_t consumedJobs = 0;
+    bool prefetchStop = false;
+    std::thread prefetcher;
+    if (streamOptions.pipeline) {
+        prefetcher = std::thread([&] {
+            volatile unsigned sink = 0;
+            for (size_t j = 0; j < jobs.size(); ++j) {
+                {
+                    std::unique_lock<std::mutex> lock(prefetchMutex);
+                    prefetchAdvanced.wait(lock, [&] { return prefetchStop || j < consumedJobs + 2 * window; });
+                    if (prefetchStop) break;
+                }
+                const BodyChunk* chunk = jobInput(jobs[j]);
+                if (chunk == nullptr) continue;
+                auto start = Clock::now();
+                ProfileScope scope(ProfileStage::Prefetch);
+                sink = sink + touchPages(body + chunk->offset, chunk->bytes);
+                prefetchNanoseconds += nanosecondsSince(start);
+            }
+        });
+    }
+
+    bool ok = processChunksInOrder(jobs.size(), writeOptions.threadCount,
+        [&](size_t j, string& buffer) {
+            if (failed) return;
+            const StreamJob& job = jobs[j];
+            TextBuffer text(buffer, writeOptions.floatFormat);
+            if (job.section == ObjSection::Header) {
+                formatOBJHeader(text, vertexCount, faceCount, has_normals, has_colors, has_texCoords);
+                return;
+            }
+
+            thread_local Mesh vertices; // 只使用顶点数组
+            thread_local vector<Triangle> triangles;
+            thread_local PolygonFaces polygons;
+            thread_local DecodeScratch scratch;
+            string error;
+            bool decoded = true;
+            if (job.chunk != kNoChunk) {
+                auto decodeStart = Clock::now();
+                Clock::time_point formatStart;
+                ProfileScope scope(job.section == ObjSection::Faces ? ProfileStage::FaceDecode : ProfileStage::VertexDecode);
+                if (job.section == ObjSection::Faces) {
+                    decoded = decoder.decodeFaces(index.faceChunks[job.chunk], { &triangles, keepPolygons ? &polygons : nullptr }, error);
+                    formatStart = Clock::now();
+                    scope.restart(ProfileStage::Format);
+                    if (decoded && keepPolygons) formatPolygonLines(text, polygons, 0, polygons.faceCount(), has_normals, has_texCoords);
+                    else if (decoded) formatFaceLines(text, triangles.data(), triangles.size(), has_normals, has_texCoords);
+                }
+                else {
+                    VertexChunkWarnings* warnings = header.isASCII && job.section == ObjSection::Vertices
+                        ? &vertexWarnings[job.chunk] : nullptr;
+                    decoded = decoder.decodeVertices(index.vertexChunks[job.chunk], vertices, scratch, error, warnings);
+                    formatStart = Clock::now();
+                    scope.restart(ProfileStage::Format);
+                    if (decoded) {
+                        const size_t count = vertices.vertexCount();
+                        if (job.section == ObjSection::Vertices) {
+                            formatVertexLines(text, vertices.positions.data(), attributeFrom(vertices.colors, 0), count);
+                        }
+                        else if (job.section == ObjSection::TexCoords) formatTexCoordLines(text, attributeFrom(vertices.texCoords, 0), count);
+                        else formatNormalLines(text, attributeFrom(vertices.normals, 0), count);
+                    }
+                }
+                decodeNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(formatStart - decodeStart).count();
+                formatNanoseconds += nanosecondsSince(formatStart);
+            }
+            if (!decoded) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!failed.exchange(true)) firstError = error;
+                return;
+            }
+            if (job.endsSection) text.put('\n');
+        },
+        [&](const string& buffer) {
+            if (failed) return false;
+            if (streamOptions.pipeline) {
+                std::lock_guard<std::mutex> lock(prefetchMutex);
+                ++consumedJobs;
+                prefetchAdvanced.notify_one();
+            }
+            auto start = Clock::now();
+            ProfileScope scope(ProfileStage::OutputWait);
+            const bool written = out->write(buffer.data(), buffer.size());
+            writeNanoseconds += nanosecondsSince(start);
+            return written;
+        });
+    if (prefetcher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            prefetchStop = true;
+        }
+        prefetchAdvanced.notify_one();
+        prefetcher.join();
+    }
+    auto finishStart = Clock::now();
+    bool finished;
+    {
+        ProfileScope scope(ProfileStage::OutputWait);
+        finished = out->finish();
+    }
+    writeNanoseconds += nanosecondsSince(finishStart);
+    out.reset();
+    if (stats != nullptr) {
+        stats->indexMs = indexNanoseconds / 1000000;
+        stats->prefetchMs = prefetchNanoseconds / 1000000;
+        stats->decodeMs = decodeNanoseconds / 1000000;
+        stats->formatMs = formatNanoseconds / 1000000;
+        stats->writeMs = writeNanoseconds / 1000000;
+    }
+
+    // 与整体读取时相同的警告：第一个含无效值的顶点和总数
+    int64_t badValues = 0;
+    for (const VertexChunkWarnings& warnings : vertexWarnings) {
+        if (warnings.badValues > 0 && badValues == 0) {
+            cerr << "警告: ASCII顶点 " << warnings.firstBadLine << " 中有无效或超出范围的属性值，已忽略。" << endl;
+        }
+        badValues += warnings.badValues;
+    }
+    if (badValues > 1) {
+        cerr << "警告: 共有 " << badValues << " 个ASCII顶点包含无效的属性值。" << endl;
+    }
+
+    // 失败时不保留写了一半的OBJ文件
+    if (failed) {
+        cerr << firstError << endl;
+        std::remove(objPath.c_str());
+        return false;
+    }
+    if (!ok || !finished) {
+        cerr << "错误: 写入OBJ文件 " << objPath << " 失败" << endl;
+        std::remove(objPath.c_str());
+        return false;
+    }
+    if (profilingEnabled()) {
+        profileAdd(ProfileCounter::BytesRead, mapped.size());
+        profileAdd(ProfileCounter::FacesIn, static_cast<uint64_t>(header.faceCount));
+        profileAdd(keepPolygons ? ProfileCounter::PolygonsOut : ProfileCounter::TrianglesOut, faceCount);
+    }
+    vertexCount_out = vertexCount;
+    triangleCount_out = faceCount;
+    return true;
+}
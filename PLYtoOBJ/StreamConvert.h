@@ -0,0 +1,33 @@
+﻿// StreamConvert.h : 不把整个网格载入内存的流式 PLY -> OBJ 转换
+//
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "ObjWriter.h"
+#include "PlyReader.h"
+
+struct StreamOptions {
+    size_t bufferBytes = size_t(256) << 20; // 解码结果与格式化文本占用内存的近似上限
+    // 流水线模式：预读线程提前把后续块的输入页读入内存，输出在单独的写入线程上写入文件，
+    // 读取、解码与格式化、写入三者重叠进行
+    bool pipeline = false;
+};
+
+// 流式转换各阶段的耗时 (毫秒)。解码和格式化是各工作线程的累计时间。
+struct StreamStats {
+    long long indexMs = 0;    // 扫描数据体、划分块
+    long long prefetchMs = 0; // 预读线程读入输入页 (仅流水线模式)
+    long long decodeMs = 0;
+    long long formatMs = 0;
+    long long writeMs = 0;    // 按顺序交给输出流，包括等待压缩 / 写入线程的时间
+};
+
+// 流式地把PLY转换为OBJ，输出与 readPLY + writeOBJ 完全相同。需要能够内存映射输入文件。
+// triangleCount_out 为输出的面数 (保留多边形时为多边形数)。stats 非空时填入各阶段耗时。
+// 开始写入后失败时删除写了一半的OBJ文件。
+bool convertPLYToOBJStreaming(const std::string& plyPath, const std::string& objPath, const PlyReadOptions& readOptions,
+    const ObjWriteOptions& writeOptions, const StreamOptions& streamOptions,
+    size_t& vertexCount_out, size_t& triangleCount_out,
+    bool& has_normals, bool& has_colors, bool& has_texCoords, StreamStats* stats = nullptr);
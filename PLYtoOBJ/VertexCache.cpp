@@ -0,0 +1,177 @@
+﻿// VertexCache.cpp : Tipsify 三角形重排与顶点读取顺序重排
+//
+
+#include "VertexCache.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "Profile.h"
+
+using namespace std;
+
+const uint32_t kNoIndex = 0xFFFFFFFFu;
+
+inline bool validTriangle(const Triangle& t, size_t vertexCount) {
+    return t.v0 >= 0 && t.v1 >= 0 && t.v2 >= 0 &&
+        static_cast<size_t>(t.v0) < vertexCount && static_cast<size_t>(t.v1) < vertexCount && static_cast<size_t>(t.v2) < vertexCount;
+}
+
+double computeACMR(const vector<Triangle>& triangles, size_t vertexCount, unsigned cacheSize) {
+    if (triangles.empty()) return 0.0;
+    // stamp[v] 为 v 进入缓存时的未命中计数；FIFO 缓存中只保留最近 cacheSize 次未命中载入的顶点
+    vector<uint64_t> stamp(vertexCount, 0);
+    uint64_t misses = 0;
+    for (const Triangle& t : triangles) {
+        for (MeshIndex index : { t.v0, t.v1, t.v2 }) {
+            if (index < 0 || static_cast<size_t>(index) >= vertexCount) {
+                ++misses;
+                continue;
+            }
+            uint64_t& s = stamp[index];
+            if (s == 0 || misses + 1 - s > cacheSize) {
+                ++misses;
+                s = misses;
+            }
+        }
+    }
+    return static_cast<double>(misses) / static_cast<double>(triangles.size());
+}
+
+// 顶点到三角形的邻接表 (CSR)。只包含索引全部有效的三角形。
+struct VertexAdjacency {
+    vector<uint32_t> offsets;   // 顶点 v 的三角形为 triangles[offsets[v], offsets[v + 1])
+    vector<uint32_t> triangles;
+
+    VertexAdjacency(const vector<Triangle>& tris, const vector<uint8_t>& valid, size_t vertexCount)
+        : offsets(vertexCount + 1, 0) {
+        for (size_t t = 0; t < tris.size(); ++t) {
+            if (!valid[t]) continue;
+            offsets[tris[t].v0 + 1]++; offsets[tris[t].v1 + 1]++; offsets[tris[t].v2 + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+        triangles.resize(offsets[vertexCount]);
+        vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < tris.size(); ++t) {
+            if (!valid[t]) continue;
+            for (MeshIndex v : { tris[t].v0, tris[t].v1, tris[t].v2 }) triangles[cursor[v]++] = static_cast<uint32_t>(t);
+        }
+    }
+};
+
+// Tipsify：从当前扇心 f 输出其所有未输出的三角形，再在刚用到的顶点中选择下一个扇心，
+// 优先选择仍在缓存中、且剩余三角形输出后不会被挤出缓存的顶点；没有候选时从死端栈回溯。
+vector<uint32_t> tipsifyOrder(const vector<Triangle>& tris, const vector<uint8_t>& valid, size_t vertexCount, unsigned cacheSize) {
+    const VertexAdjacency adjacency(tris, valid, vertexCount);
+    vector<uint32_t> live(vertexCount); // 尚未输出的相邻三角形数
+    for (size_t v = 0; v < vertexCount; ++v) live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+    vector<int64_t> cacheTime(vertexCount, 0);
+    vector<uint8_t> emitted(tris.size(), 0);
+    vector<uint32_t> deadEnd;
+    vector<uint32_t> candidates;
+    vector<uint32_t> order;
+    order.reserve(tris.size());
+
+    const int64_t k = cacheSize;
+    int64_t s = k + 1;
+    size_t cursor = 0; // 顺序扫描的位置，死端栈为空时从这里继续
+    auto nextLive = [&]() -> uint32_t {
+        while (!deadEnd.empty()) {
+            const uint32_t d = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[d] > 0) return d;
+        }
+        for (; cursor < vertexCount; ++cursor) {
+            if (live[cursor] > 0) return static_cast<uint32_t>(cursor);
+        }
+        return kNoIndex;
+    };
+
+    for (uint32_t f = nextLive(); f != kNoIndex; ) {
+        candidates.clear();
+        for (uint32_t a = adjacency.offsets[f]; a < adjacency.offsets[f + 1]; ++a) {
+            const uint32_t t = adjacency.triangles[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+            order.push_back(t);
+            for (MeshIndex index : { tris[t].v0, tris[t].v1, tris[t].v2 }) {
+                const uint32_t v = static_cast<uint32_t>(index);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (s - cacheTime[v] > k) cacheTime[v] = s++;
+            }
+        }
+
+        uint32_t best = kNoIndex;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+            int64_t priority = 0;
+            if (s - cacheTime[v] + 2 * static_cast<int64_t>(live[v]) <= k) priority = s - cacheTime[v];
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+        f = best != kNoIndex ? best : nextLive();
+    }
+    return order;
+}
+
+VertexCacheStats optimizeVertexCache(Mesh& mesh, const VertexCacheOptions& options) {
+    ProfileScope scope(ProfileStage::CacheOptimize);
+    VertexCacheStats stats;
+    const size_t vertexCount = mesh.vertexCount();
+    const unsigned cacheSize = std::max(3u, options.cacheSize);
+    vector<Triangle>& tris = mesh.triangles;
+    stats.acmrBefore = computeACMR(tris, vertexCount, cacheSize);
+    // 邻接表用32位偏移，每个三角形占3项：三角形数超过 kNoIndex / 3 时不处理
+    if (tris.empty() || vertexCount >= kNoIndex || tris.size() > kNoIndex / 3) {
+        stats.acmrAfter = stats.acmrBefore;
+        return stats;
+    }
+
+    vector<uint8_t> valid(tris.size());
+    for (size_t t = 0; t < tris.size(); ++t) valid[t] = validTriangle(tris[t], vertexCount);
+
+    vector<uint32_t> order = tipsifyOrder(tris, valid, vertexCount, cacheSize);
+    for (size_t t = 0; t < tris.size(); ++t) {
+        if (!valid[t]) order.push_back(static_cast<uint32_t>(t));
+    }
+    vector<Triangle> reordered(tris.size());
+    for (size_t k = 0; k < order.size(); ++k) reordered[k] = tris[order[k]];
+    tris.swap(reordered);
+
+    if (options.reorderVertices) {
+        // 按首次使用的顺序分配新序号，未被使用的顶点保持原顺序排在最后
+        vector<uint32_t> newIndex(vertexCount, kNoIndex);
+        uint32_t next = 0;
+        for (Triangle& t : tris) {
+            for (MeshIndex* index : { &t.v0, &t.v1, &t.v2 }) {
+                if (*index < 0 || static_cast<size_t>(*index) >= vertexCount) continue;
+                uint32_t& n = newIndex[*index];
+                if (n == kNoIndex) n = next++;
+                *index = static_cast<MeshIndex>(n);
+            }
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (newIndex[v] == kNoIndex) newIndex[v] = next++;
+        }
+        auto permute = [&newIndex](auto& values) {
+            if (values.empty()) return;
+            std::remove_reference_t<decltype(values)> out(values.size());
+            for (size_t v = 0; v < values.size(); ++v) out[newIndex[v]] = values[v];
+            values.swap(out);
+        };
+        permute(mesh.positions);
+        permute(mesh.normals);
+        permute(mesh.colors);
+        permute(mesh.texCoords);
+    }
+
+    stats.acmrAfter = computeACMR(tris, vertexCount, cacheSize);
+    return stats;
+}
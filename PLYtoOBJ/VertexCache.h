@@ -0,0 +1,26 @@
+﻿// VertexCache.h : 面向 GPU 顶点后变换缓存的三角形重排 (Tipsify) 与顶点重编号
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Mesh.h"
+
+struct VertexCacheOptions {
+    unsigned cacheSize = 16;     // 模拟的 FIFO 缓存大小
+    bool reorderVertices = true; // 重排三角形后按首次使用的顺序重新编号顶点，改善顶点读取的局部性
+};
+
+struct VertexCacheStats {
+    double acmrBefore = 0.0; // 平均每个三角形的缓存未命中数 (ACMR)，越接近 0.5 越好，最差为 3
+    double acmrAfter = 0.0;
+};
+
+// 用大小为 cacheSize 的 FIFO 缓存模拟计算 ACMR。超出范围的索引按未命中计。
+double computeACMR(const std::vector<Triangle>& triangles, size_t vertexCount, unsigned cacheSize);
+
+// 用 Tipsify 算法 (Sander 等, 2007) 重排三角形，时间与三角形数成线性关系；
+// 可选地再按首次使用的顺序重排顶点数组。包含超出范围索引的三角形保持原顺序放在最后。
+// 顶点数不小于 2^32 - 1 或三角形数超过 (2^32 - 1) / 3 的网格保持不变 (acmrAfter 等于 acmrBefore)。
+VertexCacheStats optimizeVertexCache(Mesh& mesh, const VertexCacheOptions& options);
@@ -0,0 +1,240 @@
+﻿// VertexNormals.cpp : 按顶点区间划分的并行法线累加
+//
+// 每个任务负责一段连续的顶点，只把面对这些顶点的贡献累加到 mesh.normals 中属于自己的部分，
+// 不需要原子操作，也不需要每个线程一份顶点大小的累加数组。先用两遍并行扫描把每个面的序号放入
+// 其顶点所属任务的桶中 (一个面最多进入其顶点数个桶)，任务只遍历自己桶中的面，
+// 总工作量与线程数和面的顺序无关。桶内的面保持原有顺序，每个顶点总是按面的顺序累加，所以结果与线程数无关。
+
+#include "VertexNormals.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "ParallelChunks.h"
+#include "Profile.h"
+
+using namespace std;
+
+// 每个面块包含的面数
+const size_t kNormalFaceBlock = 1 << 16;
+const size_t kNormalVertexBlock = 1 << 16;
+
+inline Vec3 subtract(const Vec3& a, const Vec3& b) {
+    return Vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline Vec3 cross(const Vec3& a, const Vec3& b) {
+    return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline float dot(const Vec3& a, const Vec3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline void addScaled(Vec3& sum, const Vec3& v, float scale) {
+    sum.x += v.x * scale;
+    sum.y += v.y * scale;
+    sum.z += v.z * scale;
+}
+
+bool parseNormalWeighting(const string& name, NormalWeighting& weighting) {
+    if (name == "area") weighting = NormalWeighting::Area;
+    else if (name == "angle") weighting = NormalWeighting::Angle;
+    else return false;
+    return true;
+}
+
+// 依次访问面 [first, last) 的三角形 (多边形按扇形展开)
+template<typename Visit>
+void forEachTriangle(const Mesh& mesh, size_t first, size_t last, Visit&& visit) {
+    if (mesh.hasPolygons()) {
+        const PolygonFaces& polygons = mesh.polygons;
+        for (size_t f = first; f < last; ++f) {
+            const size_t begin = polygons.offsets[f], end = polygons.offsets[f + 1];
+            for (size_t k = begin + 1; k + 1 < end; ++k) {
+                visit(polygons.indices[begin], polygons.indices[k], polygons.indices[k + 1]);
+            }
+        }
+        return;
+    }
+    for (size_t f = first; f < last; ++f) {
+        const Triangle& tri = mesh.triangles[f];
+        visit(tri.v0, tri.v1, tri.v2);
+    }
+}
+
+// 按任务分桶的面列表 (CSR)：任务 t 需要处理的面为 faces[offsets[t * blockCount + b]] 起、逐块相接的一段，
+// 即引用了其顶点区间内至少一个顶点的面，按面的顺序排列
+template<typename FaceId>
+struct TaskFaceBuckets {
+    vector<size_t> offsets; // (taskCount * blockCount + 1) 项
+    vector<FaceId> faces;
+};
+
+// 顶点 v 所属的任务 v / span。每个角都要计算一次，用乘以倒数代替整数除法，再修正浮点舍入的误差
+struct VertexOwner {
+    size_t span;
+    double inverseSpan;
+    explicit VertexOwner(size_t s) : span(s), inverseSpan(1.0 / static_cast<double>(s)) {}
+    size_t operator()(uint64_t v) const {
+        size_t task = static_cast<size_t>(static_cast<double>(v) * inverseSpan);
+        if (task * span > v) --task;
+        else if ((task + 1) * span <= v) ++task;
+        return task;
+    }
+};
+
+// 对面块中的每个面，依次以面序号和每个不同的所属任务调用 visit (索引超出范围的顶点不属于任何任务)
+template<typename Visit>
+void forEachFaceOwner(const Mesh& mesh, size_t first, size_t last, size_t vertexCount, const VertexOwner& owner,
+    vector<size_t>& lastFace, Visit&& visit) {
+    auto touch = [&](size_t f, MeshIndex v) {
+        if (static_cast<uint64_t>(v) >= vertexCount) return;
+        const size_t task = owner(static_cast<uint64_t>(v));
+        if (lastFace[task] == f) return;
+        lastFace[task] = f;
+        visit(f, task);
+    };
+    if (mesh.hasPolygons()) {
+        const PolygonFaces& polygons = mesh.polygons;
+        for (size_t f = first; f < last; ++f) {
+            for (size_t k = polygons.offsets[f]; k < polygons.offsets[f + 1]; ++k) touch(f, polygons.indices[k]);
+        }
+        return;
+    }
+    for (size_t f = first; f < last; ++f) {
+        const Triangle& tri = mesh.triangles[f];
+        touch(f, tri.v0);
+        touch(f, tri.v1);
+        touch(f, tri.v2);
+    }
+}
+
+// 两遍并行扫描所有面：先统计每个面块落入各任务的面数，再按前缀和写入各任务的桶
+template<typename FaceId>
+void buildTaskFaceBuckets(const Mesh& mesh, size_t vertexCount, size_t span, size_t taskCount, unsigned threadCount,
+    TaskFaceBuckets<FaceId>& buckets) {
+    const VertexOwner owner(span);
+    const size_t faceCount = mesh.faceCount();
+    const size_t blockCount = (faceCount + kNormalFaceBlock - 1) / kNormalFaceBlock;
+    auto blockRange = [faceCount](size_t block, size_t& first, size_t& last) {
+        first = block * kNormalFaceBlock;
+        last = std::min(faceCount, first + kNormalFaceBlock);
+    };
+    vector<size_t> counts(blockCount * taskCount, 0); // 下标为 block * taskCount + task
+    runParallel(blockCount, threadCount, [&](size_t block) {
+        size_t first, last;
+        blockRange(block, first, last);
+        vector<size_t> lastFace(taskCount, SIZE_MAX);
+        size_t* blockCounts = &counts[block * taskCount];
+        forEachFaceOwner(mesh, first, last, vertexCount, owner, lastFace, [blockCounts](size_t, size_t task) { ++blockCounts[task]; });
+    });
+
+    buckets.offsets.assign(taskCount * blockCount + 1, 0);
+    size_t total = 0;
+    for (size_t task = 0; task < taskCount; ++task) {
+        for (size_t block = 0; block < blockCount; ++block) {
+            buckets.offsets[task * blockCount + block] = total;
+            total += counts[block * taskCount + task];
+        }
+    }
+    buckets.offsets[taskCount * blockCount] = total;
+    buckets.faces.resize(total);
+
+    runParallel(blockCount, threadCount, [&](size_t block) {
+        size_t first, last;
+        blockRange(block, first, last);
+        vector<size_t> lastFace(taskCount, SIZE_MAX);
+        vector<size_t> cursor(taskCount);
+        for (size_t task = 0; task < taskCount; ++task) cursor[task] = buckets.offsets[task * blockCount + block];
+        FaceId* faces = buckets.faces.data();
+        forEachFaceOwner(mesh, first, last, vertexCount, owner, lastFace, [&](size_t f, size_t task) {
+            faces[cursor[task]++] = static_cast<FaceId>(f);
+        });
+    });
+}
+
+template<typename FaceId>
+size_t accumulateNormals(Mesh& mesh, const NormalOptions& options) {
+    const size_t vertexCount = mesh.vertexCount();
+    const Vec3* positions = mesh.positions.data();
+    Vec3* normals = mesh.normals.data();
+    // 有符号索引转为无符号后与顶点数比较，负数也被判为超出范围
+    auto valid = [vertexCount](MeshIndex v) { return static_cast<uint64_t>(v) < vertexCount; };
+
+    const size_t taskCount = std::max<size_t>(std::min<size_t>(options.threadCount,
+        (vertexCount + kNormalVertexBlock - 1) / kNormalVertexBlock), 1);
+    const size_t span = std::max<size_t>((vertexCount + taskCount - 1) / taskCount, 1);
+    // 只有一个任务时它拥有所有顶点，直接按顺序遍历所有面，不需要分桶
+    TaskFaceBuckets<FaceId> buckets;
+    if (taskCount > 1) buildTaskFaceBuckets(mesh, vertexCount, span, taskCount, options.threadCount, buckets);
+    const size_t blockCount = taskCount > 1 ? (buckets.offsets.size() - 1) / taskCount : 0;
+
+    const bool angleWeighted = options.weighting == NormalWeighting::Angle;
+    vector<size_t> isolated(taskCount, 0);
+    runParallel(taskCount, options.threadCount, [&](size_t task) {
+        const uint64_t begin = std::min(vertexCount, task * span), end = std::min(vertexCount, (task + 1) * span);
+        auto owned = [begin, end](MeshIndex v) { return static_cast<uint64_t>(v) - begin < end - begin; };
+        auto accumulate = [&](size_t first, size_t last) {
+            forEachTriangle(mesh, first, last, [&](MeshIndex a, MeshIndex b, MeshIndex c) {
+                const bool ownA = owned(a), ownB = owned(b), ownC = owned(c);
+                if (!(ownA || ownB || ownC) || !valid(a) || !valid(b) || !valid(c)) return;
+                const Vec3& p0 = positions[a];
+                const Vec3& p1 = positions[b];
+                const Vec3& p2 = positions[c];
+                const Vec3 e01 = subtract(p1, p0), e02 = subtract(p2, p0), e12 = subtract(p2, p1);
+                const Vec3 n = cross(e01, e02); // 长度为面积的两倍
+                if (!angleWeighted) {
+                    if (ownA) addScaled(normals[a], n, 1.0f);
+                    if (ownB) addScaled(normals[b], n, 1.0f);
+                    if (ownC) addScaled(normals[c], n, 1.0f);
+                    return;
+                }
+                // 三个角的正弦都与 |n| 成正比，角度 = atan2(|n|, 两条邻边的点积)
+                const float length = std::sqrt(dot(n, n));
+                if (!(length > 0.0f)) return;
+                const float scale = 1.0f / length;
+                if (ownA) addScaled(normals[a], n, std::atan2(length, dot(e01, e02)) * scale);
+                if (ownB) addScaled(normals[b], n, std::atan2(length, -dot(e01, e12)) * scale);
+                if (ownC) addScaled(normals[c], n, std::atan2(length, dot(e02, e12)) * scale);
+            });
+        };
+        if (taskCount == 1) accumulate(0, mesh.faceCount());
+        else {
+            for (size_t i = buckets.offsets[task * blockCount]; i < buckets.offsets[(task + 1) * blockCount]; ++i) {
+                const size_t f = static_cast<size_t>(buckets.faces[i]);
+                accumulate(f, f + 1);
+            }
+        }
+        for (uint64_t v = begin; v < end; ++v) {
+            Vec3& normal = normals[v];
+            const float length = std::sqrt(dot(normal, normal));
+            if (length > 0.0f && std::isfinite(length)) {
+                const float scale = 1.0f / length;
+                normal = Vec3(normal.x * scale, normal.y * scale, normal.z * scale);
+            }
+            else {
+                normal = Vec3(0.0f, 0.0f, 1.0f);
+                ++isolated[task];
+            }
+        }
+    });
+    size_t total = 0;
+    for (size_t n : isolated) total += n;
+    return total;
+}
+
+NormalStats computeVertexNormals(Mesh& mesh, const NormalOptions& options) {
+    NormalStats stats;
+    if (mesh.hasNormals() && !options.overwrite) return stats;
+    ProfileScope scope(ProfileStage::Normals);
+    stats.computed = true;
+
+    mesh.normals.assign(mesh.vertexCount(), Vec3());
+    mesh.presence |= kPresenceNormal;
+    // 面数能用32位表示时桶中的面序号只占4字节
+    stats.isolatedVertices = mesh.faceCount() <= UINT32_MAX ? accumulateNormals<uint32_t>(mesh, options)
+        : accumulateNormals<uint64_t>(mesh, options);
+    return stats;
+}
@@ -0,0 +1,33 @@
+﻿// VertexNormals.h : 由面计算顶点法线
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Mesh.h"
+
+// 面法线对顶点法线的权重
+enum class NormalWeighting : uint8_t {
+    Area, // 按面积加权 (未归一化的面法线直接相加)
+    Angle // 按面在该顶点处的角度加权，不受面细分方式的影响
+};
+
+struct NormalOptions {
+    NormalWeighting weighting = NormalWeighting::Area;
+    bool overwrite = false; // 网格已有法线时也重新计算 (默认只在缺少法线时计算)
+    unsigned threadCount = 1;
+};
+
+struct NormalStats {
+    bool computed = false;       // 网格已有法线且未要求重新计算时为 false
+    size_t isolatedVertices = 0; // 没有被非退化的面引用的顶点，法线为 0 0 1 (与缺少法线时的默认值相同)
+};
+
+// 解析 "area" 或 "angle"
+bool parseNormalWeighting(const std::string& name, NormalWeighting& weighting);
+
+// 计算并归一化顶点法线，写入 mesh.normals。保留了多边形时按扇形三角化后的三角形计算。
+// 索引超出范围的面被忽略。每个顶点按面的顺序累加，结果与线程数无关。
+NormalStats computeVertexNormals(Mesh& mesh, const NormalOptions& options);
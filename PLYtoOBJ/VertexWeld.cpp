@@ -0,0 +1,342 @@
+﻿// VertexWeld.cpp : 基于开放寻址哈希表与均匀网格的顶点焊接
+//
+// 精确焊接：按哈希值的高位把顶点分到若干分片，各分片在工作线程上用各自的开放寻址表并行去重。
+// 近似焊接：位置量化到边长为 2 * epsilon 的网格，半径 epsilon 的邻域最多覆盖 2x2x2 个格子，
+// 新顶点只与这些格子中已保留的顶点比较；
+// 这一步按顶点顺序贪心进行，保持结果确定，在单线程上执行，哈希、压缩和重映射仍然并行。
+
+#include "VertexWeld.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "ParallelChunks.h"
+#include "Profile.h"
+
+using namespace std;
+
+// 并行任务的粒度 (顶点或三角形个数)
+const size_t kWeldBlock = 1 << 16;
+const uint32_t kNoVertex = 0xFFFFFFFFu;
+// 近似焊接时坐标除以单元边长后允许的最大绝对值：超过 2^52 时 double 已无法表示单元内的位置，
+// 再大还会超出 int64_t 的范围
+const double kMaxWeldCell = 4503599627370496.0;
+
+// 浮点数的位模式，-0 与 +0 视为相同
+inline uint32_t floatKey(float value) {
+    if (value == 0.0f) return 0;
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline uint64_t mixHash(uint64_t h, uint32_t value) {
+    h ^= value;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+inline uint64_t finishHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 33);
+}
+
+inline uint64_t hashVec3(uint64_t h, const Vec3& v) {
+    return mixHash(mixHash(mixHash(h, floatKey(v.x)), floatKey(v.y)), floatKey(v.z));
+}
+
+inline bool sameVec3(const Vec3& a, const Vec3& b) {
+    return floatKey(a.x) == floatKey(b.x) && floatKey(a.y) == floatKey(b.y) && floatKey(a.z) == floatKey(b.z);
+}
+
+// 参与比较的顶点属性
+struct WeldKey {
+    const Mesh& mesh;
+    bool attributes; // 是否比较法线、颜色和纹理坐标
+
+    uint64_t attributeHash(size_t v) const {
+        uint64_t h = 0x2545F4914F6CDD1Dull;
+        if (!attributes) return h;
+        if (mesh.hasNormals()) h = hashVec3(h, mesh.normals[v]);
+        if (mesh.hasColors()) h = hashVec3(h, mesh.colors[v]);
+        if (mesh.hasTexCoords()) {
+            h = mixHash(mixHash(h, floatKey(mesh.texCoords[v].u)), floatKey(mesh.texCoords[v].v));
+        }
+        return h;
+    }
+    bool sameAttributes(size_t a, size_t b) const {
+        if (!attributes) return true;
+        if (mesh.hasNormals() && !sameVec3(mesh.normals[a], mesh.normals[b])) return false;
+        if (mesh.hasColors() && !sameVec3(mesh.colors[a], mesh.colors[b])) return false;
+        if (mesh.hasTexCoords() && (floatKey(mesh.texCoords[a].u) != floatKey(mesh.texCoords[b].u) ||
+            floatKey(mesh.texCoords[a].v) != floatKey(mesh.texCoords[b].v))) return false;
+        return true;
+    }
+};
+
+size_t tableCapacity(size_t count) {
+    size_t capacity = 16;
+    while (capacity < count * 2) capacity <<= 1;
+    return capacity;
+}
+
+// 精确焊接：representative[v] 为与 v 完全相同的序号最小的顶点
+void findExactDuplicates(const WeldKey& key, unsigned threadCount, vector<uint32_t>& representative) {
+    const Mesh& mesh = key.mesh;
+    const size_t n = mesh.vertexCount();
+    const size_t blocks = (n + kWeldBlock - 1) / kWeldBlock;
+
+    vector<uint64_t> hashes(n);
+    runParallel(blocks, threadCount, [&](size_t b) {
+        const size_t end = std::min(n, (b + 1) * kWeldBlock);
+        for (size_t v = b * kWeldBlock; v < end; ++v) {
+            hashes[v] = finishHash(hashVec3(key.attributeHash(v), mesh.positions[v]));
+        }
+    });
+
+    // 按哈希的高位分片。每个分片内的顶点保持原来的顺序，保证保留的是序号最小的顶点。
+    unsigned shardBits = 0;
+    while (threadCount > 1 && (1u << shardBits) < threadCount * 4 && shardBits < 12) ++shardBits;
+    const size_t shardCount = size_t(1) << shardBits;
+    auto shardOf = [shardBits](uint64_t h) { return shardBits == 0 ? size_t(0) : static_cast<size_t>(h >> (64 - shardBits)); };
+
+    vector<size_t> counts(blocks * shardCount, 0); // counts[b * shardCount + s]
+    runParallel(blocks, threadCount, [&](size_t b) {
+        const size_t end = std::min(n, (b + 1) * kWeldBlock);
+        for (size_t v = b * kWeldBlock; v < end; ++v) counts[b * shardCount + shardOf(hashes[v])]++;
+    });
+    vector<size_t> shardBegin(shardCount + 1, 0);
+    vector<size_t> offsets(blocks * shardCount, 0);
+    for (size_t s = 0, total = 0; s < shardCount; ++s) {
+        shardBegin[s] = total;
+        for (size_t b = 0; b < blocks; ++b) {
+            offsets[b * shardCount + s] = total;
+            total += counts[b * shardCount + s];
+        }
+        shardBegin[s + 1] = total;
+    }
+    vector<uint32_t> order(n);
+    runParallel(blocks, threadCount, [&](size_t b) {
+        size_t* cursor = &offsets[b * shardCount];
+        const size_t end = std::min(n, (b + 1) * kWeldBlock);
+        for (size_t v = b * kWeldBlock; v < end; ++v) order[cursor[shardOf(hashes[v])]++] = static_cast<uint32_t>(v);
+    });
+
+    representative.resize(n);
+    runParallel(shardCount, threadCount, [&](size_t s) {
+        const size_t count = shardBegin[s + 1] - shardBegin[s];
+        const size_t capacity = tableCapacity(count);
+        const size_t mask = capacity - 1;
+        vector<uint32_t> table(capacity, kNoVertex); // 线性探测，存放已保留的顶点
+        for (size_t k = shardBegin[s]; k < shardBegin[s + 1]; ++k) {
+            const uint32_t v = order[k];
+            const uint64_t h = hashes[v];
+            size_t slot = static_cast<size_t>(h) & mask;
+            uint32_t found = kNoVertex;
+            for (; table[slot] != kNoVertex; slot = (slot + 1) & mask) {
+                const uint32_t u = table[slot];
+                if (hashes[u] == h && sameVec3(mesh.positions[u], mesh.positions[v]) && key.sameAttributes(u, v)) {
+                    found = u;
+                    break;
+                }
+            }
+            if (found == kNoVertex) {
+                table[slot] = v;
+                found = v;
+            }
+            representative[v] = found;
+        }
+    });
+}
+
+// 网格单元的开放寻址表，每个单元记录其中已保留顶点组成的链表
+struct GridCells {
+    struct Cell {
+        int64_t x, y, z;
+        uint32_t head;
+    };
+    vector<Cell> cells;
+    size_t mask;
+
+    explicit GridCells(size_t count) : cells(tableCapacity(count), Cell{ 0, 0, 0, kNoVertex }), mask(cells.size() - 1) {}
+
+    static size_t hashCell(int64_t x, int64_t y, int64_t z) {
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        h = mixHash(h, static_cast<uint32_t>(x)); h = mixHash(h, static_cast<uint32_t>(x >> 32));
+        h = mixHash(h, static_cast<uint32_t>(y)); h = mixHash(h, static_cast<uint32_t>(y >> 32));
+        h = mixHash(h, static_cast<uint32_t>(z)); h = mixHash(h, static_cast<uint32_t>(z >> 32));
+        return static_cast<size_t>(finishHash(h));
+    }
+    // 查找单元，insert 为 true 时不存在则创建。返回 nullptr 表示不存在。
+    Cell* find(int64_t x, int64_t y, int64_t z, bool insert) {
+        for (size_t slot = hashCell(x, y, z) & mask; ; slot = (slot + 1) & mask) {
+            Cell& c = cells[slot];
+            if (c.head == kNoVertex) {
+                if (!insert) return nullptr;
+                c.x = x; c.y = y; c.z = z;
+                return &c;
+            }
+            if (c.x == x && c.y == y && c.z == z) return &c;
+        }
+    }
+};
+
+// 近似焊接：representative[v] 为位置距离不超过 epsilon、其余属性相同的最早保留的顶点。
+// 位置含 NaN 或无穷大的顶点不与任何顶点合并。epsilon 相对坐标过小、无法量化到网格时返回 false。
+bool findNearDuplicates(const WeldKey& key, float epsilon, unsigned threadCount, vector<uint32_t>& representative) {
+    const Mesh& mesh = key.mesh;
+    const size_t n = mesh.vertexCount();
+    const size_t blocks = (n + kWeldBlock - 1) / kWeldBlock;
+    const double inv = 0.5 / epsilon;
+    const double eps2 = static_cast<double>(epsilon) * epsilon;
+
+    // 所在单元，以及每个轴上邻域伸入的相邻单元方向 (位于单元的前半部分时为 -1，否则为 +1)
+    struct CellCoord { int64_t x, y, z; int8_t sx, sy, sz; bool finite; };
+    vector<CellCoord> coords(n);
+    std::atomic<bool> tooFine(false);
+    runParallel(blocks, threadCount, [&](size_t b) {
+        const size_t end = std::min(n, (b + 1) * kWeldBlock);
+        for (size_t v = b * kWeldBlock; v < end; ++v) {
+            const Vec3& p = mesh.positions[v];
+            if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+                coords[v] = { 0, 0, 0, 0, 0, 0, false };
+                continue;
+            }
+            const double x = p.x * inv, y = p.y * inv, z = p.z * inv;
+            if (!(std::fabs(x) <= kMaxWeldCell && std::fabs(y) <= kMaxWeldCell && std::fabs(z) <= kMaxWeldCell)) {
+                tooFine.store(true, std::memory_order_relaxed);
+                coords[v] = { 0, 0, 0, 0, 0, 0, false };
+                continue;
+            }
+            const double fx = std::floor(x), fy = std::floor(y), fz = std::floor(z);
+            coords[v] = { static_cast<int64_t>(fx), static_cast<int64_t>(fy), static_cast<int64_t>(fz),
+                static_cast<int8_t>(x - fx < 0.5 ? -1 : 1), static_cast<int8_t>(y - fy < 0.5 ? -1 : 1),
+                static_cast<int8_t>(z - fz < 0.5 ? -1 : 1), true };
+        }
+    });
+    if (tooFine) return false;
+
+    GridCells grid(n);
+    vector<uint32_t> next(n, kNoVertex); // 同一单元中下一个保留的顶点
+    representative.resize(n);
+    for (size_t v = 0; v < n; ++v) {
+        const Vec3& p = mesh.positions[v];
+        const CellCoord& c = coords[v];
+        if (!c.finite) {
+            representative[v] = static_cast<uint32_t>(v);
+            continue;
+        }
+        uint32_t found = kNoVertex;
+        for (int dx = 0; dx <= 1 && found == kNoVertex; ++dx) {
+            for (int dy = 0; dy <= 1 && found == kNoVertex; ++dy) {
+                for (int dz = 0; dz <= 1 && found == kNoVertex; ++dz) {
+                    const GridCells::Cell* cell = grid.find(c.x + dx * c.sx, c.y + dy * c.sy, c.z + dz * c.sz, false);
+                    for (uint32_t u = cell ? cell->head : kNoVertex; u != kNoVertex; u = next[u]) {
+                        const Vec3& q = mesh.positions[u];
+                        const double ddx = q.x - p.x, ddy = q.y - p.y, ddz = q.z - p.z;
+                        if (ddx * ddx + ddy * ddy + ddz * ddz <= eps2 && key.sameAttributes(u, v)) {
+                            found = u;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        if (found == kNoVertex) {
+            GridCells::Cell* cell = grid.find(c.x, c.y, c.z, true);
+            next[v] = cell->head;
+            cell->head = static_cast<uint32_t>(v);
+            found = static_cast<uint32_t>(v);
+        }
+        representative[v] = found;
+    }
+    return true;
+}
+
+WeldStats weldVertices(Mesh& mesh, const WeldOptions& options) {
+    ProfileScope scope(ProfileStage::Weld);
+    WeldStats stats;
+    const size_t n = mesh.vertexCount();
+    stats.verticesBefore = stats.verticesAfter = n;
+    if (n == 0 || n >= kNoVertex) return stats;
+
+    const unsigned threadCount = std::max(1u, options.threadCount);
+    const WeldKey key{ mesh, !options.positionOnly };
+    vector<uint32_t> representative;
+    if (!(options.epsilon > 0.0f)) findExactDuplicates(key, threadCount, representative);
+    else if (!findNearDuplicates(key, options.epsilon, threadCount, representative)) {
+        cerr << "警告: 焊接容差 " << options.epsilon << " 相对顶点坐标过小，改为只合并完全相同的顶点" << endl;
+        findExactDuplicates(key, threadCount, representative);
+    }
+
+    // 保留的顶点按原顺序分配新序号：先并行统计每块的保留数，前缀和即为每块的起始序号
+    const size_t blocks = (n + kWeldBlock - 1) / kWeldBlock;
+    vector<size_t> blockStart(blocks + 1, 0);
+    runParallel(blocks, threadCount, [&](size_t b) {
+        const size_t end = std::min(n, (b + 1) * kWeldBlock);
+        size_t kept = 0;
+        for (size_t v = b * kWeldBlock; v < end; ++v) kept += (representative[v] == v);
+        blockStart[b + 1] = kept;
+    });
+    for (size_t b = 0; b < blocks; ++b) blockStart[b + 1] += blockStart[b];
+    const size_t kept = blockStart[blocks];
+
+    Mesh welded;
+    welded.resetVertices(kept, mesh.presence);
+    vector<uint32_t> newIndex(n);
+    runParallel(blocks, threadCount, [&](size_t b) {
+        const size_t end = std::min(n, (b + 1) * kWeldBlock);
+        size_t k = blockStart[b];
+        for (size_t v = b * kWeldBlock; v < end; ++v) {
+            if (representative[v] != v) continue;
+            newIndex[v] = static_cast<uint32_t>(k);
+            welded.positions[k] = mesh.positions[v];
+            if (mesh.hasNormals()) welded.normals[k] = mesh.normals[v];
+            if (mesh.hasColors()) welded.colors[k] = mesh.colors[v];
+            if (mesh.hasTexCoords()) welded.texCoords[k] = mesh.texCoords[v];
+            ++k;
+        }
+    });
+    // 保留的顶点总在它的重复项之前，representative 已经确定新序号
+    runParallel(blocks, threadCount, [&](size_t b) {
+        const size_t end = std::min(n, (b + 1) * kWeldBlock);
+        for (size_t v = b * kWeldBlock; v < end; ++v) {
+            if (representative[v] != v) newIndex[v] = newIndex[representative[v]];
+        }
+    });
+
+    const size_t triangleBlocks = (mesh.triangles.size() + kWeldBlock - 1) / kWeldBlock;
+    runParallel(triangleBlocks, threadCount, [&](size_t b) {
+        const size_t end = std::min(mesh.triangles.size(), (b + 1) * kWeldBlock);
+        for (size_t t = b * kWeldBlock; t < end; ++t) {
+            Triangle& tri = mesh.triangles[t];
+            for (MeshIndex* index : { &tri.v0, &tri.v1, &tri.v2 }) {
+                if (*index >= 0 && static_cast<size_t>(*index) < n) *index = static_cast<MeshIndex>(newIndex[*index]);
+            }
+        }
+    });
+
+    vector<MeshIndex>& polygonIndices = mesh.polygons.indices;
+    const size_t polygonBlocks = (polygonIndices.size() + kWeldBlock - 1) / kWeldBlock;
+    runParallel(polygonBlocks, threadCount, [&](size_t b) {
+        const size_t end = std::min(polygonIndices.size(), (b + 1) * kWeldBlock);
+        for (size_t k = b * kWeldBlock; k < end; ++k) {
+            MeshIndex& index = polygonIndices[k];
+            if (index >= 0 && static_cast<size_t>(index) < n) index = static_cast<MeshIndex>(newIndex[index]);
+        }
+    });
+
+    welded.triangles.swap(mesh.triangles);
+    std::swap(welded.polygons, mesh.polygons);
+    mesh = std::move(welded);
+    stats.verticesAfter = kept;
+    return stats;
+}
@@ -0,0 +1,25 @@
+﻿// VertexWeld.h : 顶点焊接 (合并重复顶点并重映射三角形索引)
+//
+#pragma once
+
+#include <cstddef>
+
+#include "Mesh.h"
+
+// 焊接选项
+struct WeldOptions {
+    float epsilon = 0.0f;      // 0 表示只合并完全相同的顶点；> 0 时合并位置距离不超过 epsilon 的顶点
+    bool positionOnly = false; // 只比较位置，合并后保留第一个顶点的法线、颜色和纹理坐标
+    unsigned threadCount = 1;
+};
+
+struct WeldStats {
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+};
+
+// 合并重复顶点。每组重复顶点保留序号最小的一个，新序号按保留顶点在原网格中的顺序分配，
+// 因此结果与线程数无关。不比较位置时 (positionOnly 为 false) 法线、颜色和纹理坐标也必须完全相同，
+// 以免合并纹理接缝两侧的顶点。超出范围的三角形索引保持不变。
+// 近似焊接时位置含 NaN 或无穷大的顶点不参与合并；坐标与 epsilon 之比超过 2^52 时输出警告并改为精确焊接。
+WeldStats weldVertices(Mesh& mesh, const WeldOptions& options);
@@ -0,0 +1,326 @@
+﻿// PLYtoOBJBench.cpp : 基准测试程序。生成合成PLY文件，依次运行各读取 / 写入 / 转换引擎，
+// 每次测量输出一行JSON (吞吐量、顶点速率、峰值内存)，便于脚本比较不同版本。
+//
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+
+#include "Converter.h"
+#include "MeshBinary.h"
+#include "ObjWriter.h"
+#include "ParallelChunks.h"
+#include "PlyReader.h"
+#include "Profile.h"
+#include "StreamConvert.h"
+#include "SyntheticPly.h"
+
+using namespace std;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// 重置峰值常驻内存。Linux 上通过 /proc/self/clear_refs 重置，得到单次运行的峰值；
+// 其他平台无法重置，得到的是进程启动以来的峰值。
+bool resetPeakRss() {
+#if defined(__linux__)
+    ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.close();
+    return !clearRefs.fail();
+#else
+    return false;
+#endif
+}
+
+uint64_t fileBytes(const string& path) {
+    std::error_code ec;
+    const uintmax_t size = fs::file_size(path, ec);
+    return ec ? 0 : static_cast<uint64_t>(size);
+}
+
+bool readFileBytes(const string& path, vector<char>& data) {
+    ifstream file(path, ios::in | ios::binary);
+    if (!file.is_open()) return false;
+    data.resize(static_cast<size_t>(fileBytes(path)));
+    return data.empty() || static_cast<bool>(file.read(data.data(), static_cast<streamsize>(data.size())));
+}
+
+string jsonString(const string& text) {
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted.push_back('\\');
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+struct BenchSettings {
+    double scale = 1.0;   // 顶点数相对默认规模 (每个用例约 100 万个顶点) 的倍数
+    unsigned repeat = 3;  // 每个测量重复的次数，报告最快的一次
+    unsigned threadCount = 1;
+    string directory;     // 合成文件所在目录
+    bool keepFiles = false;
+    string filter;        // 非空时只运行名称 (用例/引擎) 中包含该子串的测量
+};
+
+// 一个读取 / 写入 / 转换引擎。run 返回 false 表示失败；bytes 为吞吐量计算使用的字节数
+struct BenchEngine {
+    string name;
+    function<bool(uint64_t& bytes)> run;
+};
+
+struct BenchResult {
+    double seconds = 0.0;
+    uint64_t bytes = 0;
+    long long peakRssKb = 0;
+};
+
+// 运行 repeat 次，返回最快的一次；峰值内存取各次中的最大值
+bool measure(const BenchEngine& engine, unsigned repeat, BenchResult& best) {
+    best = BenchResult();
+    best.seconds = -1.0;
+    for (unsigned i = 0; i < repeat; ++i) {
+        resetPeakRss();
+        uint64_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        if (!engine.run(bytes)) return false;
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best.peakRssKb = std::max(best.peakRssKb, static_cast<long long>(peakResidentBytes() / 1024));
+        if (best.seconds < 0.0 || seconds < best.seconds) {
+            best.seconds = seconds;
+            best.bytes = bytes;
+        }
+    }
+    return true;
+}
+
+// 默认的用例：覆盖三种格式、不同的属性组合和面的顶点数
+vector<SyntheticSpec> defaultCases(double scale) {
+    struct CaseDesc { SyntheticFormat format; SyntheticAttributes attributes; SyntheticValence valence; };
+    const CaseDesc descs[] = {
+        { SyntheticFormat::BinaryLittleEndian, SyntheticAttributes::Position, SyntheticValence::Triangles },
+        { SyntheticFormat::BinaryLittleEndian, SyntheticAttributes::Full, SyntheticValence::Triangles },
+        { SyntheticFormat::BinaryLittleEndian, SyntheticAttributes::Extra, SyntheticValence::Mixed },
+        { SyntheticFormat::BinaryLittleEndian, SyntheticAttributes::PositionColor, SyntheticValence::Quads },
+        { SyntheticFormat::BinaryBigEndian, SyntheticAttributes::PositionNormal, SyntheticValence::Triangles },
+        { SyntheticFormat::BinaryBigEndian, SyntheticAttributes::Full, SyntheticValence::Mixed },
+        { SyntheticFormat::Ascii, SyntheticAttributes::Position, SyntheticValence::Triangles },
+        { SyntheticFormat::Ascii, SyntheticAttributes::Full, SyntheticValence::Quads },
+        { SyntheticFormat::Ascii, SyntheticAttributes::PositionColor, SyntheticValence::Mixed },
+    };
+    const size_t side = std::max<size_t>(2, static_cast<size_t>(std::lround(1000.0 * std::sqrt(scale))));
+    vector<SyntheticSpec> specs;
+    uint32_t seed = 1;
+    for (const CaseDesc& desc : descs) {
+        SyntheticSpec spec;
+        spec.format = desc.format;
+        spec.attributes = desc.attributes;
+        spec.valence = desc.valence;
+        spec.gridWidth = spec.gridHeight = side;
+        spec.seed = seed++;
+        spec.name = string(syntheticFormatName(desc.format)) + "-" + syntheticAttributesName(desc.attributes) + "-" +
+            syntheticValenceName(desc.valence);
+        specs.push_back(spec);
+    }
+    return specs;
+}
+
+void printUsage(const char* program) {
+    cerr << "用法: " << program << " [--quick] [--scale 倍数] [--repeat 次数] [--threads 线程数]" << endl;
+    cerr << "       [--dir 临时目录] [--keep] [--filter 子串] [--output 结果文件]" << endl;
+    cerr << "  --quick          小规模、只运行一次 (用于冒烟测试)" << endl;
+    cerr << "  --scale 倍数     每个用例的顶点数为 100 万 * 倍数 (默认 1)" << endl;
+    cerr << "  --repeat 次数    每个测量重复的次数，报告最快的一次 (默认 3)" << endl;
+    cerr << "  --threads 线程数 读取 / 写入使用的线程数 (默认 1)" << endl;
+    cerr << "  --filter 子串    只运行 \"用例/引擎\" 中包含该子串的测量" << endl;
+    cerr << "  --output 文件    把JSON结果写入文件 (默认输出到标准输出)" << endl;
+    cerr << "每次测量输出一行JSON，字段: case format attributes valence engine threads vertices faces" << endl;
+    cerr << "  bytes seconds mb_per_s vertices_per_s peak_rss_kb peak_rss_scope" << endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchSettings settings;
+    string outputPath;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--quick") {
+            settings.scale = 0.05;
+            settings.repeat = 1;
+        }
+        else if (arg == "--scale" && i + 1 < argc) {
+            settings.scale = atof(argv[++i]);
+            if (!(settings.scale > 0.0)) {
+                cerr << "错误: 无效的规模 " << argv[i] << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--repeat" && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            settings.repeat = n > 0 ? static_cast<unsigned>(n) : 1;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            settings.threadCount = n > 0 ? static_cast<unsigned>(n) : 1;
+        }
+        else if (arg == "--dir" && i + 1 < argc) settings.directory = argv[++i];
+        else if (arg == "--keep") settings.keepFiles = true;
+        else if (arg == "--filter" && i + 1 < argc) settings.filter = argv[++i];
+        else if (arg == "--output" && i + 1 < argc) outputPath = argv[++i];
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    if (settings.directory.empty()) settings.directory = (fs::temp_directory_path(ec) / "plytoobj_bench").string();
+    fs::create_directories(settings.directory, ec);
+    if (!fs::is_directory(settings.directory)) {
+        cerr << "错误: 无法创建目录 " << settings.directory << endl;
+        return 1;
+    }
+
+    ofstream outputFile;
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath, ios::out | ios::trunc);
+        if (!outputFile.is_open()) {
+            cerr << "错误: 无法创建结果文件 " << outputPath << endl;
+            return 1;
+        }
+    }
+    ostream& report = outputPath.empty() ? cout : outputFile;
+    const char* rssScope = resetPeakRss() ? "run" : "process";
+
+    PlyReadOptions readOptions;
+    readOptions.threadCount = settings.threadCount;
+    ObjWriteOptions writeOptions;
+    writeOptions.threadCount = settings.threadCount;
+
+    bool failed = false;
+    for (const SyntheticSpec& spec : defaultCases(settings.scale)) {
+        const string plyPath = (fs::path(settings.directory) / (spec.name + ".ply")).string();
+        const string objPath = (fs::path(settings.directory) / (spec.name + ".obj")).string();
+        const string binaryPath = (fs::path(settings.directory) / (spec.name + ".pmesh")).string();
+
+        SyntheticStats synthetic;
+        cerr << "生成用例 " << spec.name << " ..." << endl;
+        if (!writeSyntheticPLY(plyPath, spec, synthetic)) return 1;
+
+        // 写入类引擎使用预先读入的网格，不计入读取时间
+        Mesh mesh;
+        bool has_normals = false, has_colors = false, has_texCoords = false;
+        const uint64_t plyBytes = synthetic.fileBytes;
+
+        vector<BenchEngine> engines;
+        engines.push_back({ "read_mmap", [&](uint64_t& bytes) {
+            PlyReadOptions options = readOptions;
+            options.useMemoryMap = true;
+            bytes = plyBytes;
+            return readPLY(plyPath, mesh, has_normals, has_colors, has_texCoords, options);
+        } });
+        engines.push_back({ "read_stream", [&](uint64_t& bytes) {
+            PlyReadOptions options = readOptions;
+            options.useMemoryMap = false;
+            bytes = plyBytes;
+            return readPLY(plyPath, mesh, has_normals, has_colors, has_texCoords, options);
+        } });
+        engines.push_back({ "read_polygons", [&](uint64_t& bytes) {
+            PlyReadOptions options = readOptions;
+            options.keepPolygons = true;
+            bytes = plyBytes;
+            Mesh polygonMesh;
+            bool n, c, t;
+            return readPLY(plyPath, polygonMesh, n, c, t, options);
+        } });
+        engines.push_back({ "write_obj", [&](uint64_t& bytes) {
+            if (mesh.vertexCount() == 0 && !readPLY(plyPath, mesh, has_normals, has_colors, has_texCoords, readOptions)) {
+                return false;
+            }
+            if (!writeOBJ(objPath, mesh, has_normals, has_colors, has_texCoords, writeOptions)) return false;
+            bytes = fileBytes(objPath);
+            return true;
+        } });
+        engines.push_back({ "write_binary", [&](uint64_t& bytes) {
+            if (mesh.vertexCount() == 0 && !readPLY(plyPath, mesh, has_normals, has_colors, has_texCoords, readOptions)) {
+                return false;
+            }
+            if (!writeMeshBinaryOutput(binaryPath, mesh, has_normals, has_colors, has_texCoords)) return false;
+            bytes = fileBytes(binaryPath);
+            return true;
+        } });
+        engines.push_back({ "read_binary", [&](uint64_t& bytes) {
+            Mesh binaryMesh;
+            uint8_t sourceFlags = 0;
+            bytes = fileBytes(binaryPath);
+            return readMeshBinary(binaryPath, binaryMesh, sourceFlags);
+        } });
+        // 内存中的PLY转换为内存中的OBJ：转换器对象与输出字符串在各次运行之间复用
+        PlyToObjConverter converter(readOptions, writeOptions);
+        vector<char> plyData;
+        string objText;
+        engines.push_back({ "convert_memory", [&](uint64_t& bytes) {
+            if (plyData.empty() && !readFileBytes(plyPath, plyData)) return false;
+            bytes = plyBytes;
+            return converter.convert(plyData.data(), plyData.size(), objText);
+        } });
+        for (bool pipeline : { false, true }) {
+            engines.push_back({ pipeline ? "convert_pipeline" : "convert_stream", [&, pipeline](uint64_t& bytes) {
+                StreamOptions streamOptions;
+                streamOptions.pipeline = pipeline;
+                size_t vertexCount = 0, faceCount = 0;
+                bool n, c, t;
+                bytes = plyBytes;
+                return convertPLYToOBJStreaming(plyPath, objPath, readOptions, writeOptions, streamOptions,
+                    vertexCount, faceCount, n, c, t);
+            } });
+        }
+
+        for (const BenchEngine& engine : engines) {
+            const string label = spec.name + "/" + engine.name;
+            if (!settings.filter.empty() && label.find(settings.filter) == string::npos) continue;
+            // read_binary 依赖 write_binary 的输出
+            if (engine.name == "read_binary" && fileBytes(binaryPath) == 0) continue;
+            cerr << "  " << label << endl;
+            BenchResult result;
+            if (!measure(engine, settings.repeat, result)) {
+                cerr << "错误: " << label << " 运行失败" << endl;
+                failed = true;
+                continue;
+            }
+            const double seconds = std::max(result.seconds, 1e-9);
+            report << "{\"case\":" << jsonString(spec.name)
+                << ",\"format\":" << jsonString(syntheticFormatName(spec.format))
+                << ",\"attributes\":" << jsonString(syntheticAttributesName(spec.attributes))
+                << ",\"valence\":" << jsonString(syntheticValenceName(spec.valence))
+                << ",\"engine\":" << jsonString(engine.name)
+                << ",\"threads\":" << settings.threadCount
+                << ",\"vertices\":" << synthetic.vertexCount
+                << ",\"faces\":" << synthetic.faceCount
+                << ",\"bytes\":" << result.bytes
+                << ",\"seconds\":" << result.seconds
+                << ",\"mb_per_s\":" << static_cast<double>(result.bytes) / (1024.0 * 1024.0) / seconds
+                << ",\"vertices_per_s\":" << static_cast<double>(synthetic.vertexCount) / seconds
+                << ",\"peak_rss_kb\":" << result.peakRssKb
+                << ",\"peak_rss_scope\":" << jsonString(rssScope) << "}" << endl;
+        }
+
+        if (!settings.keepFiles) {
+            fs::remove(plyPath, ec);
+            fs::remove(objPath, ec);
+            fs::remove(binaryPath, ec);
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,248 @@
+﻿// SyntheticPly.cpp : 合成PLY文件的生成
+//
+
+#include "SyntheticPly.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+
+using namespace std;
+
+const char* syntheticFormatName(SyntheticFormat format) {
+    switch (format) {
+    case SyntheticFormat::Ascii: return "ascii";
+    case SyntheticFormat::BinaryLittleEndian: return "binary_little_endian";
+    default: return "binary_big_endian";
+    }
+}
+
+const char* syntheticAttributesName(SyntheticAttributes attributes) {
+    switch (attributes) {
+    case SyntheticAttributes::Position: return "xyz";
+    case SyntheticAttributes::PositionNormal: return "xyzn";
+    case SyntheticAttributes::PositionColor: return "xyzc";
+    case SyntheticAttributes::Full: return "full";
+    case SyntheticAttributes::Extra: return "extra";
+    default: return "extralist";
+    }
+}
+
+const char* syntheticValenceName(SyntheticValence valence) {
+    switch (valence) {
+    case SyntheticValence::Triangles: return "tri";
+    case SyntheticValence::Quads: return "quad";
+    default: return "mixed";
+    }
+}
+
+const char* syntheticCountTypeName(SyntheticCountType countType) {
+    switch (countType) {
+    case SyntheticCountType::UChar: return "uchar";
+    case SyntheticCountType::UShort: return "ushort";
+    default: return "uint";
+    }
+}
+
+// 确定性的伪随机数 (xorshift32)，用于扰动网格顶点
+struct SyntheticRandom {
+    uint32_t state;
+    explicit SyntheticRandom(uint32_t seed) : state(seed ? seed : 1) {}
+    float next() { // [0, 1)
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+// 按目标字节序追加二进制值或ASCII文本
+class RecordWriter {
+public:
+    RecordWriter(SyntheticFormat format, string& out) : format_(format), out_(out) {}
+
+    template<typename T>
+    void value(T v) {
+        if (format_ == SyntheticFormat::Ascii) {
+            char text[32];
+            const auto result = std::to_chars(text, text + sizeof(text), v);
+            if (!fieldStart_) out_.push_back(' ');
+            out_.append(text, result.ptr);
+            fieldStart_ = false;
+            return;
+        }
+        char bytes[sizeof(T)];
+        memcpy(bytes, &v, sizeof(T));
+        if (format_ == SyntheticFormat::BinaryBigEndian) std::reverse(bytes, bytes + sizeof(T));
+        out_.append(bytes, sizeof(T));
+    }
+    void endRecord() {
+        if (format_ == SyntheticFormat::Ascii) out_.push_back('\n');
+        fieldStart_ = true;
+    }
+
+private:
+    SyntheticFormat format_;
+    string& out_;
+    bool fieldStart_ = true;
+};
+
+// 第 cell 个网格单元 (左下角顶点为 x, y) 输出的面。Mixed 模式下每三个单元一组：
+// 四边形、两个三角形、再与右侧单元合并的六边形 (右侧单元因此不单独输出)。
+template<typename Emit>
+void emitCellFaces(const SyntheticSpec& spec, size_t x, size_t y, Emit&& emit) {
+    const int w = static_cast<int>(spec.gridWidth);
+    const int a = static_cast<int>(y) * w + static_cast<int>(x);
+    const int b = a + 1, c = a + w + 1, d = a + w;
+    switch (spec.valence) {
+    case SyntheticValence::Triangles: {
+        const int t0[3] = { a, b, c }, t1[3] = { a, c, d };
+        emit(t0, 3);
+        emit(t1, 3);
+        break;
+    }
+    case SyntheticValence::Quads: {
+        const int q[4] = { a, b, c, d };
+        emit(q, 4);
+        break;
+    }
+    case SyntheticValence::Mixed: {
+        const size_t phase = x % 4;
+        if (phase == 0) {
+            const int q[4] = { a, b, c, d };
+            emit(q, 4);
+        }
+        else if (phase == 1) {
+            const int t0[3] = { a, b, c }, t1[3] = { a, c, d };
+            emit(t0, 3);
+            emit(t1, 3);
+        }
+        else if (phase == 2 && x + 2 < spec.gridWidth) {
+            const int h[6] = { a, b, b + 1, c + 1, c, d };
+            emit(h, 6);
+        }
+        else if (phase == 2) {
+            const int q[4] = { a, b, c, d };
+            emit(q, 4);
+        }
+        break;
+    }
+    }
+}
+
+bool writeSyntheticPLY(const string& path, const SyntheticSpec& spec, SyntheticStats& stats) {
+    if (spec.gridWidth < 2 || spec.gridHeight < 2) {
+        cerr << "错误: 合成网格至少需要 2 x 2 个顶点" << endl;
+        return false;
+    }
+    ofstream file(path, ios::out | ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        cerr << "错误: 无法创建合成PLY文件 " << path << endl;
+        return false;
+    }
+
+    const bool normals = spec.attributes == SyntheticAttributes::PositionNormal || spec.attributes == SyntheticAttributes::Full;
+    const bool colors = spec.attributes == SyntheticAttributes::PositionColor || spec.attributes == SyntheticAttributes::Full;
+    const bool texCoords = spec.attributes == SyntheticAttributes::Full;
+    const bool faceLists = spec.attributes == SyntheticAttributes::ExtraLists;
+    const bool extra = spec.attributes == SyntheticAttributes::Extra || faceLists;
+
+    stats = SyntheticStats();
+    stats.vertexCount = spec.gridWidth * spec.gridHeight;
+    for (size_t x = 0; x + 1 < spec.gridWidth; ++x) {
+        emitCellFaces(spec, x, 0, [&stats](const int*, size_t) { ++stats.faceCount; });
+    }
+    stats.faceCount *= spec.gridHeight - 1;
+
+    string header = "ply\nformat ";
+    header += syntheticFormatName(spec.format);
+    header += " 1.0\ncomment synthetic benchmark mesh " + spec.name + "\n";
+    header += "element vertex " + to_string(stats.vertexCount) + "\n";
+    header += "property float x\nproperty float y\nproperty float z\n";
+    if (normals) header += "property float nx\nproperty float ny\nproperty float nz\n";
+    if (extra) header += "property double quality\n";
+    if (colors) header += "property uchar red\nproperty uchar green\nproperty uchar blue\n";
+    if (texCoords) header += "property float u\nproperty float v\n";
+    header += "element face " + to_string(stats.faceCount) + "\n";
+    header += string("property list ") + syntheticCountTypeName(spec.countType) + " int vertex_indices\n";
+    if (faceLists) header += "property list uchar float texcoord\n";
+    if (extra) header += "property int material\n";
+    header += "end_header\n";
+    file.write(header.data(), header.size());
+
+    // 按行生成并分块写出，内存占用与网格大小无关
+    const size_t kFlushBytes = 1 << 22;
+    string buffer;
+    buffer.reserve(kFlushBytes + 4096);
+    RecordWriter out(spec.format, buffer);
+    auto flush = [&](bool force) {
+        if (buffer.size() >= kFlushBytes || (force && !buffer.empty())) {
+            file.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    };
+
+    SyntheticRandom random(spec.seed);
+    const float step = 1.0f / static_cast<float>(std::max(spec.gridWidth, spec.gridHeight));
+    for (size_t y = 0; y < spec.gridHeight; ++y) {
+        for (size_t x = 0; x < spec.gridWidth; ++x) {
+            const float jitter = (random.next() - 0.5f) * step * 0.25f;
+            out.value(static_cast<float>(x) * step + jitter);
+            out.value(static_cast<float>(y) * step - jitter);
+            out.value(random.next() * 0.1f);
+            if (normals) {
+                out.value(jitter);
+                out.value(-jitter);
+                out.value(1.0f);
+            }
+            if (extra) out.value(static_cast<double>(random.next()));
+            if (colors) {
+                out.value(static_cast<uint8_t>(x * 7));
+                out.value(static_cast<uint8_t>(y * 3));
+                out.value(static_cast<uint8_t>(random.next() * 255.0f));
+            }
+            if (texCoords) {
+                out.value(static_cast<float>(x) * step);
+                out.value(static_cast<float>(y) * step);
+            }
+            out.endRecord();
+            flush(false);
+        }
+    }
+    for (size_t y = 0; y + 1 < spec.gridHeight; ++y) {
+        for (size_t x = 0; x + 1 < spec.gridWidth; ++x) {
+            emitCellFaces(spec, x, y, [&](const int* indices, size_t n) {
+                if (spec.format == SyntheticFormat::Ascii) out.value(static_cast<unsigned>(n));
+                else if (spec.countType == SyntheticCountType::UChar) out.value(static_cast<uint8_t>(n));
+                else if (spec.countType == SyntheticCountType::UShort) out.value(static_cast<uint16_t>(n));
+                else out.value(static_cast<uint32_t>(n));
+                for (size_t k = 0; k < n; ++k) out.value(static_cast<int32_t>(indices[k]));
+                if (faceLists) {
+                    if (spec.format == SyntheticFormat::Ascii) out.value(static_cast<unsigned>(2 * n));
+                    else out.value(static_cast<uint8_t>(2 * n));
+                    for (size_t k = 0; k < n; ++k) {
+                        out.value(static_cast<float>(indices[k] % spec.gridWidth) * step);
+                        out.value(static_cast<float>(indices[k] / spec.gridWidth) * step);
+                    }
+                }
+                if (extra) out.value(static_cast<int32_t>(x % 8));
+                out.endRecord();
+            });
+            flush(false);
+        }
+    }
+    flush(true);
+    file.close();
+    if (file.fail()) {
+        cerr << "错误: 写入合成PLY文件 " << path << " 失败" << endl;
+        return false;
+    }
+    std::error_code ec;
+    stats.fileBytes = static_cast<uint64_t>(filesystem::file_size(path, ec));
+    return true;
+}
@@ -0,0 +1,56 @@
+﻿// SyntheticPly.h : 生成用于基准测试和回归测试 (PLYtoOBJTest) 的合成PLY文件
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class SyntheticFormat : uint8_t { Ascii, BinaryLittleEndian, BinaryBigEndian };
+
+// 顶点属性组合
+enum class SyntheticAttributes : uint8_t {
+    Position,       // x y z
+    PositionNormal, // x y z nx ny nz
+    PositionColor,  // x y z red green blue (uchar)
+    Full,           // 位置、法线、uchar 颜色和纹理坐标
+    Extra,          // 位置加上未使用的 double 属性，面记录带额外的 int 属性 (测试跳过路径)
+    ExtraLists      // 同 Extra，面记录在索引列表之后另带每个角的纹理坐标列表 (MeshLab 的 texcoord)。
+                    // 只有ASCII文件能跳过该列表，二进制文件应被所有引擎拒绝
+};
+
+// 面的顶点数
+enum class SyntheticValence : uint8_t {
+    Triangles, // 每个网格单元两个三角形
+    Quads,     // 每个网格单元一个四边形
+    Mixed      // 四边形、三角形对与六边形 (相邻两个单元合并) 交替
+};
+
+// 面列表中顶点数的类型 (property list <类型> int vertex_indices)
+enum class SyntheticCountType : uint8_t { UChar, UShort, UInt };
+
+// 合成网格：gridWidth * gridHeight 个顶点排成规则网格，面连接相邻顶点
+struct SyntheticSpec {
+    std::string name;
+    SyntheticFormat format = SyntheticFormat::BinaryLittleEndian;
+    SyntheticAttributes attributes = SyntheticAttributes::Position;
+    SyntheticValence valence = SyntheticValence::Triangles;
+    SyntheticCountType countType = SyntheticCountType::UChar;
+    size_t gridWidth = 1000;
+    size_t gridHeight = 1000;
+    uint32_t seed = 1;
+};
+
+struct SyntheticStats {
+    size_t vertexCount = 0;
+    size_t faceCount = 0;
+    uint64_t fileBytes = 0;
+};
+
+// 写入合成PLY文件。内容只由 spec 决定，同一 spec 总是生成相同的文件。失败时输出错误并返回 false。
+bool writeSyntheticPLY(const std::string& path, const SyntheticSpec& spec, SyntheticStats& stats);
+
+const char* syntheticFormatName(SyntheticFormat format);
+const char* syntheticAttributesName(SyntheticAttributes attributes);
+const char* syntheticValenceName(SyntheticValence valence);
+const char* syntheticCountTypeName(SyntheticCountType countType);
@@ -0,0 +1,749 @@
+﻿// PLYtoOBJTest.cpp : 回归测试与吞吐量对比。在合成PLY语料上运行所有读取 / 写入 / 转换引擎，
+// 检查结果与参考实现 (单线程、不映射的 readPLY 和单线程的 writeOBJ) 逐位一致，
+// 输出各引擎相对参考实现的加速比，并可与保存的基线比较吞吐量。带面列表属性的二进制用例应被所有引擎拒绝。
+// 另有几个固定的小文件 (ASCII 与两种字节序) 与期望的OBJ输出比较，用于发现各引擎共有的解析错误。
+//
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+
+#include "Converter.h"
+#include "MeshBinary.h"
+#include "MeshCache.h"
+#include "ObjWriter.h"
+#include "ParallelChunks.h"
+#include "PlyReader.h"
+#include "SimdKernels.h"
+#include "StreamConvert.h"
+#include "SyntheticPly.h"
+
+using namespace std;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+uint64_t fileBytes(const string& path) {
+    std::error_code ec;
+    const uintmax_t size = fs::file_size(path, ec);
+    return ec ? 0 : static_cast<uint64_t>(size);
+}
+
+bool readFileBytes(const string& path, string& data) {
+    ifstream file(path, ios::in | ios::binary);
+    if (!file.is_open()) return false;
+    data.resize(static_cast<size_t>(fileBytes(path)));
+    return data.empty() || static_cast<bool>(file.read(&data[0], static_cast<streamsize>(data.size())));
+}
+
+string jsonString(const string& text) {
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted.push_back('\\');
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+// 把 text 补足到 width 列。UTF-8 的多字节字符 (这里只有汉字) 按两列计算，setw 按字节计算无法对齐。
+string padded(const string& text, size_t width, bool alignRight = false) {
+    size_t columns = 0;
+    for (unsigned char c : text) {
+        if (c < 0x80) ++columns;
+        else if (c >= 0xC0) columns += 2;
+    }
+    const string fill(columns < width ? width - columns : 0, ' ');
+    return alignRight ? fill + text : text + fill;
+}
+
+// 从本程序输出的一行JSON中取出字段的值 (字符串去掉引号，数字原样返回)
+bool jsonField(const string& line, const string& key, string& value) {
+    const string pattern = "\"" + key + "\":";
+    const size_t start = line.find(pattern);
+    if (start == string::npos) return false;
+    size_t pos = start + pattern.size();
+    if (pos < line.size() && line[pos] == '"') {
+        const size_t end = line.find('"', pos + 1);
+        if (end == string::npos) return false;
+        value = line.substr(pos + 1, end - pos - 1);
+        return true;
+    }
+    const size_t end = line.find_first_of(",}", pos);
+    value = line.substr(pos, end == string::npos ? string::npos : end - pos);
+    return !value.empty();
+}
+
+struct TestSettings {
+    size_t gridSide = 1000; // 每个用例的网格边长 (顶点数为其平方)
+    unsigned repeat = 3;    // 每个引擎计时的次数，报告最快的一次
+    unsigned threadCount = std::max(2u, defaultThreadCount()); // 多线程引擎使用的线程数
+    string directory;       // 合成文件与输出所在目录
+    bool keepFiles = false;
+    string filter;          // 非空时只运行名称 (用例/引擎) 中包含该子串的引擎
+    double tolerance = 0.15; // 吞吐量低于基线的比例超过此值时视为退化
+};
+
+// 语料：覆盖 ASCII 与两种字节序、三角形 / 四边形 / 多边形面、uchar / ushort / uint 的列表长度类型，
+// 以及需要跳过的额外属性 (标量与面的列表属性)
+vector<SyntheticSpec> corpusCases(size_t side) {
+    struct CaseDesc { SyntheticFormat format; SyntheticAttributes attributes; SyntheticValence valence; SyntheticCountType count; };
+    const CaseDesc descs[] = {
+        { SyntheticFormat::Ascii, SyntheticAttributes::Position, SyntheticValence::Triangles, SyntheticCountType::UChar },
+        { SyntheticFormat::Ascii, SyntheticAttributes::Full, SyntheticValence::Mixed, SyntheticCountType::UInt },
+        { SyntheticFormat::Ascii, SyntheticAttributes::Extra, SyntheticValence::Quads, SyntheticCountType::UShort },
+        { SyntheticFormat::Ascii, SyntheticAttributes::ExtraLists, SyntheticValence::Mixed, SyntheticCountType::UChar },
+        { SyntheticFormat::BinaryLittleEndian, SyntheticAttributes::Position, SyntheticValence::Triangles, SyntheticCountType::UChar },
+        { SyntheticFormat::BinaryLittleEndian, SyntheticAttributes::PositionColor, SyntheticValence::Quads, SyntheticCountType::UChar },
+        { SyntheticFormat::BinaryLittleEndian, SyntheticAttributes::Full, SyntheticValence::Mixed, SyntheticCountType::UShort },
+        { SyntheticFormat::BinaryLittleEndian, SyntheticAttributes::Extra, SyntheticValence::Mixed, SyntheticCountType::UInt },
+        { SyntheticFormat::BinaryLittleEndian, SyntheticAttributes::ExtraLists, SyntheticValence::Triangles, SyntheticCountType::UChar },
+        { SyntheticFormat::BinaryBigEndian, SyntheticAttributes::PositionNormal, SyntheticValence::Triangles, SyntheticCountType::UInt },
+        { SyntheticFormat::BinaryBigEndian, SyntheticAttributes::Full, SyntheticValence::Mixed, SyntheticCountType::UChar },
+        { SyntheticFormat::BinaryBigEndian, SyntheticAttributes::Extra, SyntheticValence::Quads, SyntheticCountType::UShort },
+        { SyntheticFormat::BinaryBigEndian, SyntheticAttributes::ExtraLists, SyntheticValence::Quads, SyntheticCountType::UShort },
+    };
+    vector<SyntheticSpec> specs;
+    uint32_t seed = 1;
+    for (const CaseDesc& desc : descs) {
+        SyntheticSpec spec;
+        spec.format = desc.format;
+        spec.attributes = desc.attributes;
+        spec.valence = desc.valence;
+        spec.countType = desc.count;
+        spec.gridWidth = spec.gridHeight = side;
+        spec.seed = seed++;
+        spec.name = string(syntheticFormatName(desc.format)) + "-" + syntheticAttributesName(desc.attributes) + "-" +
+            syntheticValenceName(desc.valence) + "-" + syntheticCountTypeName(desc.count);
+        specs.push_back(spec);
+    }
+    return specs;
+}
+
+// 二进制文件中面的列表属性无法按固定大小跳过，读取器应报错而不是产生错位的结果
+bool expectRejected(const SyntheticSpec& spec) {
+    return spec.attributes == SyntheticAttributes::ExtraLists && spec.format != SyntheticFormat::Ascii;
+}
+
+// 引擎的结果：读取类引擎产生网格，写入 / 转换类引擎产生OBJ文本
+struct EngineOutput {
+    Mesh mesh;
+    bool has_normals = false, has_colors = false, has_texCoords = false;
+    string obj;
+};
+
+enum class EngineKind : uint8_t { Read, Write, Convert };
+
+struct TestEngine {
+    string name;
+    EngineKind kind;
+    bool polygons;        // 与保留多边形的参考结果比较
+    string outputPath;    // 非空时引擎把OBJ写入该文件，计时结束后读回比较
+    vector<string> baseline; // 计算加速比时作为对照的引擎，耗时取其总和
+    function<bool(EngineOutput& out)> run;
+};
+
+// 运行 repeat 次，返回最快一次的秒数，失败时返回负数。out 保留最后一次的结果。
+double measure(const TestEngine& engine, unsigned repeat, EngineOutput& out) {
+    double best = -1.0;
+    for (unsigned i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        if (!engine.run(out)) return -1.0;
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (best < 0.0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+template<typename T>
+bool sameArray(const vector<T>& a, const vector<T>& b) {
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+// 逐位比较两个网格，返回第一处差异的描述，完全相同时返回空串
+string compareMeshes(const EngineOutput& expected, const EngineOutput& actual) {
+    const Mesh& a = expected.mesh;
+    const Mesh& b = actual.mesh;
+    if (expected.has_normals != actual.has_normals || expected.has_colors != actual.has_colors ||
+        expected.has_texCoords != actual.has_texCoords) return "文件属性标志不同";
+    if (a.presence != b.presence) return "网格中的属性不同";
+    if (a.vertexCount() != b.vertexCount()) {
+        return "顶点数不同 (" + to_string(a.vertexCount()) + " / " + to_string(b.vertexCount()) + ")";
+    }
+    if (a.faceCount() != b.faceCount()) {
+        return "面数不同 (" + to_string(a.faceCount()) + " / " + to_string(b.faceCount()) + ")";
+    }
+    if (!sameArray(a.positions, b.positions)) return "顶点位置不同";
+    if (!sameArray(a.normals, b.normals)) return "法线不同";
+    if (!sameArray(a.colors, b.colors)) return "颜色不同";
+    if (!sameArray(a.texCoords, b.texCoords)) return "纹理坐标不同";
+    if (!sameArray(a.triangles, b.triangles)) return "三角形不同";
+    if (!sameArray(a.polygons.offsets, b.polygons.offsets) || !sameArray(a.polygons.indices, b.polygons.indices)) {
+        return "多边形不同";
+    }
+    return string();
+}
+
+// 逐字节比较OBJ文本，返回第一处差异所在的行
+string compareObj(const string& expected, const string& actual) {
+    if (expected == actual) return string();
+    const size_t n = std::min(expected.size(), actual.size());
+    size_t pos = 0;
+    while (pos < n && expected[pos] == actual[pos]) ++pos;
+    const size_t line = 1 + static_cast<size_t>(std::count(expected.begin(), expected.begin() + pos, '\n'));
+    return "OBJ第 " + to_string(line) + " 行不同 (长度 " + to_string(expected.size()) + " / " + to_string(actual.size()) + ")";
+}
+
+// 基线：键为 "用例/引擎@线程数"，值为 MB/s
+bool loadBaseline(const string& path, map<string, double>& baseline) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        cerr << "错误: 无法打开基线文件 " << path << endl;
+        return false;
+    }
+    string line;
+    while (getline(file, line)) {
+        string caseName, engine, threads, rate;
+        if (!jsonField(line, "case", caseName) || !jsonField(line, "engine", engine) ||
+            !jsonField(line, "threads", threads) || !jsonField(line, "mb_per_s", rate)) continue;
+        baseline[caseName + "/" + engine + "@" + threads] = atof(rate.c_str());
+    }
+    return true;
+}
+
+// 固定的小文件与期望的OBJ输出。合成语料的参考结果由当前的 readPLY 产生，各引擎共用的解析代码出错时
+// 参考结果也会随之改变；固定的期望输出能发现这类问题。期望输出取自最初的读取器，
+// 最初的读取器解析有误的文件 (见各用例的说明) 按PLY规范手工核对。
+struct GoldenCase {
+    const char* name;
+    string ply;
+    const char* obj;
+};
+
+// 按字节序追加二进制值 (与 SyntheticPly 一样假定本机为小端序)
+template<typename T>
+void appendBinary(string& out, T value, bool bigEndian) {
+    char bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    if (bigEndian) std::reverse(bytes, bytes + sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+vector<GoldenCase> goldenCases() {
+    vector<GoldenCase> cases;
+    const float corners[5][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1.5f, 0.75f, 0 }, { 1, 1.5f, 0.25f }, { 0, 1, -0.5f } };
+    // 小端序：法线、uchar 颜色、需要跳过的 short、纹理坐标；ushort 计数与 uint 索引，
+    // 五边形与四边形按扇形三角化，只有两个索引的面被忽略
+    {
+        string ply = "ply\nformat binary_little_endian 1.0\nelement vertex 5\n"
+            "property float x\nproperty float y\nproperty float z\nproperty float nx\nproperty float ny\nproperty float nz\n"
+            "property uchar red\nproperty uchar green\nproperty uchar blue\nproperty short flags\nproperty float u\nproperty float v\n"
+            "element face 4\nproperty list ushort uint vertex_indices\nend_header\n";
+        for (int i = 0; i < 5; ++i) {
+            const float* p = corners[i];
+            for (float value : { p[0], p[1], p[2], 0.0f, 0.0f, 1.0f }) appendBinary(ply, value, false);
+            for (uint8_t value : { uint8_t(255), uint8_t(i * 50), uint8_t(0) }) appendBinary(ply, value, false);
+            appendBinary(ply, static_cast<int16_t>(-i), false);
+            appendBinary(ply, p[0] / 2, false);
+            appendBinary(ply, p[1] / 2, false);
+        }
+        const vector<vector<uint32_t>> faces = { { 0, 1, 2, 3, 4 }, { 0, 1, 2 }, { 1, 3 }, { 4, 3, 2, 0 } };
+        for (const vector<uint32_t>& face : faces) {
+            appendBinary(ply, static_cast<uint16_t>(face.size()), false);
+            for (uint32_t index : face) appendBinary(ply, index, false);
+        }
+        cases.push_back({ "binary-le-attributes-polygons", ply,
+            "# Converted from PLY to OBJ by PLYtoOBJ_Converter\n# Vertices: 5\n# Faces: 6\n# Has Normals\n"
+            "# Has Vertex Colors (appended to 'v' lines as r g b)\n# Has Texture Coordinates\n\n"
+            "v 0 0 0 1 0 0\nv 1 0 0 1 0.196078 0\nv 1.5 0.75 0 1 0.392157 0\nv 1 1.5 0.25 1 0.588235 0\n"
+            "v 0 1 -0.5 1 0.784314 0\n\nvt 0 0\nvt 0.5 0\nvt 0.75 0.375\nvt 0.5 0.75\nvt 0 0.5\n\nvn 0 0 1\n"
+            "vn 0 0 1\nvn 0 0 1\nvn 0 0 1\nvn 0 0 1\n\nf 1/1/1 2/2/2 3/3/3\nf 1/1/1 3/3/3 4/4/4\n"
+            "f 1/1/1 4/4/4 5/5/5\nf 1/1/1 2/2/2 3/3/3\nf 5/5/5 4/4/4 3/3/3\nf 5/5/5 3/3/3 1/1/1\n" });
+    }
+    // 大端序：颜色之前需要跳过的 double，忽略的 alpha；uchar 计数与 uchar 索引
+    {
+        string ply = "ply\nformat binary_big_endian 1.0\nelement vertex 4\n"
+            "property float x\nproperty float y\nproperty float z\nproperty double quality\n"
+            "property uchar red\nproperty uchar green\nproperty uchar blue\nproperty uchar alpha\n"
+            "element face 2\nproperty list uchar uchar vertex_indices\nend_header\n";
+        for (int i = 0; i < 4; ++i) {
+            for (int k = 0; k < 3; ++k) appendBinary(ply, corners[i][k], true);
+            appendBinary(ply, i * 0.25, true);
+            for (uint8_t value : { uint8_t(10 * i), uint8_t(20 * i), uint8_t(30 * i), uint8_t(255) }) appendBinary(ply, value, true);
+        }
+        for (uint8_t value : { 3, 0, 1, 2, 3, 0, 2, 3 }) appendBinary(ply, value, true);
+        cases.push_back({ "binary-be-skipped-double", ply,
+            "# Converted from PLY to OBJ by PLYtoOBJ_Converter\n# Vertices: 4\n# Faces: 2\n"
+            "# Has Vertex Colors (appended to 'v' lines as r g b)\n\nv 0 0 0 0 0 0\n"
+            "v 1 0 0 0.0392157 0.0784314 0.117647\nv 1.5 0.75 0 0.0784314 0.156863 0.235294\n"
+            "v 1 1.5 0.25 0.117647 0.235294 0.352941\n\nf 1 2 3\nf 1 3 4\n" });
+    }
+    // ASCII：法线、uchar 颜色与纹理坐标，六边形与四边形
+    cases.push_back({ "ascii-attributes-polygons",
+        "ply\nformat ascii 1.0\nelement vertex 7\n"
+        "property float x\nproperty float y\nproperty float z\nproperty float nx\nproperty float ny\nproperty float nz\n"
+        "property uchar red\nproperty uchar green\nproperty uchar blue\nproperty float u\nproperty float v\n"
+        "element face 3\nproperty list uchar int vertex_indices\nend_header\n"
+        "0 0 0 0 0 1 0 255 128 0 0\n1 0 0 0 0 1 40 215 128 0.5 0\n2 0.5 0 0 0 1 80 175 128 1 0.25\n"
+        "2 1.5 0 0 0 1 120 135 128 1 0.75\n1 2 0 0 0 1 160 95 128 0.5 1\n0 1.5 0 0 0 1 200 55 128 0 0.75\n"
+        "1 1 0.5 0 0 1 240 15 128 0.5 0.5\n"
+        "6 0 1 2 3 4 5\n4 0 1 6 5\n3 1 2 6\n",
+        "# Converted from PLY to OBJ by PLYtoOBJ_Converter\n# Vertices: 7\n# Faces: 7\n# Has Normals\n"
+        "# Has Vertex Colors (appended to 'v' lines as r g b)\n# Has Texture Coordinates\n\n"
+        "v 0 0 0 0 1 0.501961\nv 1 0 0 0.156863 0.843137 0.501961\nv 2 0.5 0 0.313726 0.686275 0.501961\n"
+        "v 2 1.5 0 0.470588 0.529412 0.501961\nv 1 2 0 0.627451 0.372549 0.501961\n"
+        "v 0 1.5 0 0.784314 0.215686 0.501961\nv 1 1 0.5 0.941176 0.0588235 0.501961\n\nvt 0 0\n"
+        "vt 0.5 0\nvt 1 0.25\nvt 1 0.75\nvt 0.5 1\nvt 0 0.75\nvt 0.5 0.5\n\nvn 0 0 1\nvn 0 0 1\n"
+        "vn 0 0 1\nvn 0 0 1\nvn 0 0 1\nvn 0 0 1\nvn 0 0 1\n\nf 1/1/1 2/2/2 3/3/3\nf 1/1/1 3/3/3 4/4/4\n"
+        "f 1/1/1 4/4/4 5/5/5\nf 1/1/1 5/5/5 6/6/6\nf 1/1/1 2/2/2 7/7/7\nf 1/1/1 7/7/7 6/6/6\n"
+        "f 2/2/2 3/3/3 7/7/7\n" });
+    // MeshLab 导出的带纹理网格：面在索引列表之后带有纹理坐标列表
+    cases.push_back({ "ascii-face-texcoord",
+        "ply\nformat ascii 1.0\ncomment TextureFile tex.png\nelement vertex 4\n"
+        "property float x\nproperty float y\nproperty float z\n"
+        "element face 2\nproperty list uchar int vertex_indices\nproperty list uchar float texcoord\nend_header\n"
+        "0 0 0\n1 0 0\n1 1 0\n0 1 0\n"
+        "3 0 1 2 6 0 0 1 0 1 1\n3 0 2 3 6 0 0 1 1 0 1\n",
+        "# Converted from PLY to OBJ by PLYtoOBJ_Converter\n# Vertices: 4\n# Faces: 2\n\n"
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n\nf 1 2 3\nf 1 3 4\n" });
+    // 索引列表之前的列表与标量属性、顶点中的列表属性 (最初的读取器把面行的第一个记号当作计数，
+    // 并把顶点列表当作一个字段，期望输出为手工核对的结果)
+    cases.push_back({ "ascii-lists-before-indices",
+        "ply\nformat ascii 1.0\nelement vertex 3\n"
+        "property float x\nproperty list uchar int tags\nproperty float y\nproperty float z\n"
+        "element face 1\nproperty list uchar float texcoord\nproperty int flags\n"
+        "property list uchar int vertex_indices\nproperty uchar quality\nend_header\n"
+        "0 2 7 8 0 0\n1 0 0 0\n1 1 9 1 0\n"
+        "6 0 0 1 0 1 1 5 3 0 1 2 255\n",
+        "# Converted from PLY to OBJ by PLYtoOBJ_Converter\n# Vertices: 3\n# Faces: 1\n\n"
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\n\nf 1 2 3\n" });
+    return cases;
+}
+
+// 用所有以文件为输入的引擎转换固定的小文件，与期望的OBJ逐字节比较
+void runGoldenCases(const TestSettings& settings, size_t& mismatches, size_t& failures) {
+    const unsigned threads = settings.threadCount;
+    typedef function<bool(const string& plyPath, const string& plyData, const string& objPath, string& obj)> Converter;
+    auto readAndWrite = [](bool memoryMap, unsigned threadCount) -> Converter {
+        return [memoryMap, threadCount](const string& plyPath, const string&, const string& objPath, string& obj) {
+            PlyReadOptions options;
+            options.useMemoryMap = memoryMap;
+            options.threadCount = threadCount;
+            Mesh mesh;
+            bool n, c, t;
+            return readPLY(plyPath, mesh, n, c, t, options) && writeOBJ(objPath, mesh, n, c, t) && readFileBytes(objPath, obj);
+        };
+    };
+    auto streaming = [](bool pipeline, unsigned threadCount) -> Converter {
+        return [pipeline, threadCount](const string& plyPath, const string&, const string& objPath, string& obj) {
+            PlyReadOptions readOptions;
+            readOptions.threadCount = threadCount;
+            ObjWriteOptions writeOptions;
+            writeOptions.threadCount = threadCount;
+            StreamOptions streamOptions;
+            streamOptions.pipeline = pipeline;
+            size_t vertexCount = 0, faceCount = 0;
+            bool n, c, t;
+            return convertPLYToOBJStreaming(plyPath, objPath, readOptions, writeOptions, streamOptions,
+                vertexCount, faceCount, n, c, t) && readFileBytes(objPath, obj);
+        };
+    };
+    const pair<const char*, Converter> converters[] = {
+        { "read_reference", readAndWrite(false, 1) },
+        { "read_mmap", readAndWrite(true, 1) },
+        { "read_mmap_mt", readAndWrite(true, threads) },
+        { "read_stream_mt", readAndWrite(false, threads) },
+        { "convert_memory_mt", [threads](const string&, const string& plyData, const string&, string& obj) {
+            PlyReadOptions readOptions;
+            readOptions.threadCount = threads;
+            ObjWriteOptions writeOptions;
+            writeOptions.threadCount = threads;
+            return PlyToObjConverter(readOptions, writeOptions).convert(plyData.data(), plyData.size(), obj);
+        } },
+        { "convert_stream", streaming(false, 1) },
+        { "convert_stream_mt", streaming(false, threads) },
+        { "convert_pipeline_mt", streaming(true, threads) },
+    };
+
+    for (const GoldenCase& golden : goldenCases()) {
+        const string plyPath = (fs::path(settings.directory) / (string("golden-") + golden.name + ".ply")).string();
+        const string objPath = (fs::path(settings.directory) / (string("golden-") + golden.name + ".obj")).string();
+        std::error_code ec;
+        bool header = false;
+        for (const auto& converter : converters) {
+            const string label = string("golden/") + golden.name + "/" + converter.first;
+            if (!settings.filter.empty() && label.find(settings.filter) == string::npos) continue;
+            if (!header) {
+                ofstream file(plyPath, ios::out | ios::binary | ios::trunc);
+                file.write(golden.ply.data(), static_cast<streamsize>(golden.ply.size()));
+                cout << endl << "固定用例 " << golden.name << endl;
+                header = true;
+            }
+            string obj;
+            fs::remove(objPath, ec);
+            if (!converter.second(plyPath, golden.ply, objPath, obj)) {
+                ++failures;
+                cout << "  " << padded(converter.first, 36) << "失败" << endl;
+                continue;
+            }
+            const string difference = compareObj(golden.obj, obj);
+            if (!difference.empty()) ++mismatches;
+            cout << "  " << padded(converter.first, 36) << (difference.empty() ? "一致" : "不一致") << endl;
+            if (!difference.empty()) cout << "    " << difference << endl;
+        }
+        if (!settings.keepFiles) {
+            fs::remove(plyPath, ec);
+            fs::remove(objPath, ec);
+        }
+    }
+}
+
+void printUsage(const char* program) {
+    cerr << "用法: " << program << " [--quick] [--size 边长] [--repeat 次数] [--threads 线程数]" << endl;
+    cerr << "       [--dir 临时目录] [--keep] [--filter 子串] [--output 结果文件] [--baseline 基线文件] [--tolerance 百分比]" << endl;
+    cerr << "  --quick            小规模、只运行一次 (用于 ctest)" << endl;
+    cerr << "  --size 边长        每个用例的网格边长，顶点数为其平方 (默认 " << TestSettings().gridSide << ")" << endl;
+    cerr << "  --repeat 次数      每个引擎计时的次数，报告最快的一次 (默认 3)" << endl;
+    cerr << "  --threads 线程数   多线程引擎使用的线程数 (默认: 硬件并发数，至少 2)" << endl;
+    cerr << "  --filter 子串      只运行 \"用例/引擎\" 中包含该子串的引擎 (参考结果总是计算)" << endl;
+    cerr << "  --output 文件      把每个引擎的结果写成一行JSON，可作为以后运行的 --baseline" << endl;
+    cerr << "  --baseline 文件    与之前 --output 的结果比较，吞吐量下降超过容差时报告退化并返回失败" << endl;
+    cerr << "  --tolerance 百分比 允许的吞吐量下降 (默认 15)" << endl;
+    cerr << "结果与参考实现不一致、引擎运行失败或吞吐量退化时返回 1" << endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    TestSettings settings;
+    string outputPath, baselinePath;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--quick") {
+            settings.gridSide = 301; // 各引擎在此规模下都会分成多块并行处理
+            settings.repeat = 1;
+        }
+        else if (arg == "--size" && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            if (n < 2) {
+                cerr << "错误: 无效的网格边长 " << argv[i] << endl;
+                return 1;
+            }
+            settings.gridSide = static_cast<size_t>(n);
+        }
+        else if (arg == "--repeat" && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            settings.repeat = n > 0 ? static_cast<unsigned>(n) : 1;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            settings.threadCount = n > 0 ? static_cast<unsigned>(n) : 1;
+        }
+        else if (arg == "--dir" && i + 1 < argc) settings.directory = argv[++i];
+        else if (arg == "--keep") settings.keepFiles = true;
+        else if (arg == "--filter" && i + 1 < argc) settings.filter = argv[++i];
+        else if (arg == "--output" && i + 1 < argc) outputPath = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc) baselinePath = argv[++i];
+        else if (arg == "--tolerance" && i + 1 < argc) {
+            settings.tolerance = atof(argv[++i]) / 100.0;
+            if (!(settings.tolerance >= 0.0)) {
+                cerr << "错误: 无效的容差 " << argv[i] << endl;
+                return 1;
+            }
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    if (settings.directory.empty()) settings.directory = (fs::temp_directory_path(ec) / "plytoobj_test").string();
+    fs::create_directories(settings.directory, ec);
+    if (!fs::is_directory(settings.directory)) {
+        cerr << "错误: 无法创建目录 " << settings.directory << endl;
+        return 1;
+    }
+
+    map<string, double> baseline;
+    if (!baselinePath.empty() && !loadBaseline(baselinePath, baseline)) return 1;
+    ofstream outputFile;
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath, ios::out | ios::trunc);
+        if (!outputFile.is_open()) {
+            cerr << "错误: 无法创建结果文件 " << outputPath << endl;
+            return 1;
+        }
+    }
+
+    const unsigned threads = settings.threadCount;
+    const string cacheDirectory = (fs::path(settings.directory) / "cache").string();
+    cout << "多线程引擎使用 " << threads << " 个线程，SIMD 内核: " << simdKernelName() << endl;
+
+    size_t mismatches = 0, failures = 0, regressions = 0;
+    runGoldenCases(settings, mismatches, failures);
+    for (const SyntheticSpec& spec : corpusCases(settings.gridSide)) {
+        const string plyPath = (fs::path(settings.directory) / (spec.name + ".ply")).string();
+        const string objPath = (fs::path(settings.directory) / (spec.name + ".obj")).string();
+        const string binaryPath = (fs::path(settings.directory) / (spec.name + ".pmesh")).string();
+
+        // 参考结果 (下标为是否保留多边形) 与内存中的PLY在生成用例后填入，引擎只引用它们
+        EngineOutput expected[2];
+        string plyData;
+        vector<TestEngine> engines;
+        // 读取：与参考网格逐位比较
+        struct ReadVariant { const char* name; bool memoryMap; unsigned threadCount; };
+        const ReadVariant readVariants[] = {
+            { "read_reference", false, 1 },
+            { "read_mmap", true, 1 },
+            { "read_mmap_mt", true, threads },
+            { "read_stream_mt", false, threads },
+        };
+        for (int polygons = 0; polygons < 2; ++polygons) {
+            const string suffix = polygons ? "_poly" : "";
+            const vector<string> readBaseline = { "read_reference" + suffix };
+            for (const ReadVariant& variant : readVariants) {
+                PlyReadOptions options;
+                options.useMemoryMap = variant.memoryMap;
+                options.threadCount = variant.threadCount;
+                options.keepPolygons = polygons != 0;
+                engines.push_back({ variant.name + suffix, EngineKind::Read, polygons != 0, "", readBaseline,
+                    [&plyPath, options](EngineOutput& out) {
+                        return readPLY(plyPath, out.mesh, out.has_normals, out.has_colors, out.has_texCoords, options);
+                    } });
+            }
+            PlyReadOptions memoryOptions;
+            memoryOptions.threadCount = threads;
+            memoryOptions.keepPolygons = polygons != 0;
+            engines.push_back({ "read_memory_mt" + suffix, EngineKind::Read, polygons != 0, "", readBaseline,
+                [&plyData, memoryOptions](EngineOutput& out) {
+                    return readPLYMemory(plyData.data(), plyData.size(), out.mesh,
+                        out.has_normals, out.has_colors, out.has_texCoords, memoryOptions);
+                } });
+        }
+        // 二进制网格与网格缓存只保存三角形网格
+        engines.push_back({ "read_binary", EngineKind::Read, false, "", { "read_reference" },
+            [&binaryPath](EngineOutput& out) {
+                uint8_t sourceFlags = 0;
+                if (!readMeshBinary(binaryPath, out.mesh, sourceFlags)) return false;
+                out.has_normals = (sourceFlags & kPresenceNormal) != 0;
+                out.has_colors = (sourceFlags & kPresenceColor) != 0;
+                out.has_texCoords = (sourceFlags & kPresenceTexCoord) != 0;
+                return true;
+            } });
+        MeshCacheOptions cacheOptions;
+        cacheOptions.directory = cacheDirectory;
+        PlyReadOptions cachedRead;
+        cachedRead.threadCount = threads;
+        engines.push_back({ "read_cache_hit", EngineKind::Read, false, "", { "read_reference" },
+            [&plyPath, cacheOptions, cachedRead](EngineOutput& out) {
+                bool cacheHit = false;
+                return readPLYCached(plyPath, out.mesh, out.has_normals, out.has_colors, out.has_texCoords,
+                    cachedRead, cacheOptions, cacheHit) && cacheHit;
+            } });
+
+        // 写入：由参考网格写出，与参考OBJ逐字节比较
+        for (int polygons = 0; polygons < 2; ++polygons) {
+            const string suffix = polygons ? "_poly" : "";
+            const EngineOutput& source = expected[polygons];
+            const vector<string> writeBaseline = { "write_reference" + suffix };
+            ObjWriteOptions single, multi, async;
+            multi.threadCount = threads;
+            async.threadCount = threads;
+            async.asyncWrite.enabled = true;
+            const pair<const char*, ObjWriteOptions> writeVariants[] = {
+                { "write_reference", single }, { "write_mt", multi }, { "write_async_mt", async },
+            };
+            for (const auto& variant : writeVariants) {
+                const ObjWriteOptions options = variant.second;
+                engines.push_back({ variant.first + suffix, EngineKind::Write, polygons != 0, objPath, writeBaseline,
+                    [&objPath, &source, options](EngineOutput&) {
+                        return writeOBJ(objPath, source.mesh, source.has_normals, source.has_colors, source.has_texCoords, options);
+                    } });
+            }
+            engines.push_back({ "write_string_mt" + suffix, EngineKind::Write, polygons != 0, "", writeBaseline,
+                [&source, multi](EngineOutput& out) {
+                    StringSink sink(out.obj);
+                    out.obj.clear();
+                    return ObjMeshWriter(multi).write(source.mesh, source.has_normals, source.has_colors, source.has_texCoords, sink);
+                } });
+        }
+
+        // 转换：与参考的读取 + 写入比较
+        for (int polygons = 0; polygons < 2; ++polygons) {
+            const string suffix = polygons ? "_poly" : "";
+            const vector<string> convertBaseline = { "read_reference" + suffix, "write_reference" + suffix };
+            PlyReadOptions readOptions;
+            readOptions.keepPolygons = polygons != 0;
+            struct StreamVariant { const char* name; unsigned threadCount; bool pipeline; size_t bufferBytes; };
+            const StreamVariant streamVariants[] = {
+                { "convert_stream", 1, false, StreamOptions().bufferBytes },
+                { "convert_stream_mt", threads, false, StreamOptions().bufferBytes },
+                { "convert_stream_mt_small_buffer", threads, false, size_t(1) << 20 }, // 分多遍解码与输出
+                { "convert_pipeline_mt", threads, true, StreamOptions().bufferBytes },
+            };
+            for (const StreamVariant& variant : streamVariants) {
+                PlyReadOptions streamRead = readOptions;
+                streamRead.threadCount = variant.threadCount;
+                ObjWriteOptions streamWrite;
+                streamWrite.threadCount = variant.threadCount;
+                StreamOptions streamOptions;
+                streamOptions.pipeline = variant.pipeline;
+                streamOptions.bufferBytes = variant.bufferBytes;
+                engines.push_back({ variant.name + suffix, EngineKind::Convert, polygons != 0, objPath, convertBaseline,
+                    [&plyPath, &objPath, streamRead, streamWrite, streamOptions](EngineOutput&) {
+                        size_t vertexCount = 0, faceCount = 0;
+                        bool n, c, t;
+                        return convertPLYToOBJStreaming(plyPath, objPath, streamRead, streamWrite, streamOptions,
+                            vertexCount, faceCount, n, c, t);
+                    } });
+            }
+            PlyReadOptions memoryRead = readOptions;
+            memoryRead.threadCount = threads;
+            ObjWriteOptions memoryWrite;
+            memoryWrite.threadCount = threads;
+            engines.push_back({ "convert_memory_mt" + suffix, EngineKind::Convert, polygons != 0, "", convertBaseline,
+                [&plyData, memoryRead, memoryWrite](EngineOutput& out) {
+                    PlyToObjConverter converter(memoryRead, memoryWrite);
+                    return converter.convert(plyData.data(), plyData.size(), out.obj);
+                } });
+        }
+
+        auto selected = [&](const TestEngine& engine) {
+            return settings.filter.empty() || (spec.name + "/" + engine.name).find(settings.filter) != string::npos;
+        };
+        if (std::none_of(engines.begin(), engines.end(), selected)) continue;
+
+        SyntheticStats synthetic;
+        if (!writeSyntheticPLY(plyPath, spec, synthetic)) return 1;
+        if (!readFileBytes(plyPath, plyData)) return 1;
+
+        // 期望被拒绝的用例：每个读取PLY的引擎都应失败，不计时；写入引擎与 read_binary 依赖参考结果，不运行
+        if (expectRejected(spec)) {
+            cout << endl << "用例 " << spec.name << ": " << synthetic.faceCount << " 个面, 期望所有引擎拒绝" << endl;
+            for (const TestEngine& engine : engines) {
+                if (!selected(engine) || engine.kind == EngineKind::Write || engine.name == "read_binary") continue;
+                EngineOutput out;
+                const bool accepted = engine.run(out);
+                if (accepted) ++mismatches;
+                cout << "  " << padded(engine.name, 36) << (accepted ? "未拒绝" : "已拒绝") << endl;
+            }
+            if (!settings.keepFiles) {
+                fs::remove(plyPath, ec);
+                fs::remove(objPath, ec);
+            }
+            continue;
+        }
+
+        // 参考结果：单线程、不使用内存映射读取，单线程写入
+        PlyReadOptions referenceRead;
+        referenceRead.useMemoryMap = false;
+        for (int polygons = 0; polygons < 2; ++polygons) {
+            PlyReadOptions options = referenceRead;
+            options.keepPolygons = polygons != 0;
+            EngineOutput& ref = expected[polygons];
+            if (!readPLY(plyPath, ref.mesh, ref.has_normals, ref.has_colors, ref.has_texCoords, options) ||
+                !writeOBJ(objPath, ref.mesh, ref.has_normals, ref.has_colors, ref.has_texCoords) ||
+                !readFileBytes(objPath, ref.obj)) {
+                cerr << "错误: 用例 " << spec.name << " 的参考转换失败" << endl;
+                return 1;
+            }
+        }
+        const EngineOutput& triangulated = expected[0];
+        if (!writeMeshBinaryOutput(binaryPath, triangulated.mesh,
+            triangulated.has_normals, triangulated.has_colors, triangulated.has_texCoords)) return 1;
+
+        // 先读取一次写入缓存，计时的是缓存命中后的读取
+        {
+            EngineOutput warm;
+            bool cacheHit = false;
+            readPLYCached(plyPath, warm.mesh, warm.has_normals, warm.has_colors, warm.has_texCoords,
+                cachedRead, cacheOptions, cacheHit);
+        }
+
+        cout << endl << "用例 " << spec.name << ": " << synthetic.vertexCount << " 个顶点, " << synthetic.faceCount
+            << " 个面, " << synthetic.fileBytes << " 字节" << endl;
+        cout << "  " << padded("引擎", 36) << padded("结果", 8) << padded("毫秒", 12, true) << padded("MB/s", 10, true)
+            << padded("加速比", 10, true) << padded("基线比", 10, true) << endl;
+        map<string, double> seconds;
+        for (const TestEngine& engine : engines) {
+            if (!selected(engine)) continue;
+            const string label = spec.name + "/" + engine.name;
+
+            EngineOutput out;
+            double elapsed = measure(engine, settings.repeat, out);
+            if (elapsed >= 0.0 && !engine.outputPath.empty() && !readFileBytes(engine.outputPath, out.obj)) elapsed = -1.0;
+            if (elapsed < 0.0) {
+                ++failures;
+                cout << "  " << padded(engine.name, 36) << "失败" << endl;
+                continue;
+            }
+            const EngineOutput& reference = expected[engine.polygons ? 1 : 0];
+            const string difference = engine.kind == EngineKind::Read ? compareMeshes(reference, out) : compareObj(reference.obj, out.obj);
+            if (!difference.empty()) ++mismatches;
+            seconds[engine.name] = elapsed;
+
+            // 读取按PLY的字节数计算吞吐量，写入按OBJ的字节数，转换按两者之和
+            uint64_t bytes = synthetic.fileBytes;
+            if (engine.kind == EngineKind::Write) bytes = reference.obj.size();
+            else if (engine.kind == EngineKind::Convert) bytes += reference.obj.size();
+            const double rate = static_cast<double>(bytes) / (1024.0 * 1024.0) / std::max(elapsed, 1e-9);
+            // 对照引擎被 --filter 排除或运行失败时不计算加速比
+            double baselineSeconds = 0.0;
+            for (const string& name : engine.baseline) {
+                auto it = seconds.find(name);
+                if (it == seconds.end()) {
+                    baselineSeconds = 0.0;
+                    break;
+                }
+                baselineSeconds += it->second;
+            }
+            const double speedup = baselineSeconds > 0.0 ? baselineSeconds / std::max(elapsed, 1e-9) : 0.0;
+            auto stored = baseline.find(label + "@" + to_string(threads));
+            const double ratio = stored != baseline.end() && stored->second > 0.0 ? rate / stored->second : 0.0;
+            const bool regressed = ratio > 0.0 && ratio < 1.0 - settings.tolerance;
+            if (regressed) ++regressions;
+
+            cout << "  " << padded(engine.name, 36) << padded(difference.empty() ? "一致" : "不一致", 8)
+                << fixed << setprecision(2) << setw(12) << elapsed * 1000.0 << setw(10) << setprecision(1) << rate;
+            if (speedup > 0.0) cout << setw(9) << setprecision(2) << speedup << "x";
+            else cout << setw(10) << "-";
+            if (ratio > 0.0) cout << setw(9) << setprecision(2) << ratio << "x" << (regressed ? "  退化" : "");
+            else cout << setw(10) << "-";
+            cout << defaultfloat << endl;
+            if (!difference.empty()) cout << "    " << difference << endl;
+
+            if (outputFile.is_open()) {
+                outputFile << "{\"case\":" << jsonString(spec.name)
+                    << ",\"engine\":" << jsonString(engine.name)
+                    << ",\"threads\":" << threads
+                    << ",\"match\":" << (difference.empty() ? "true" : "false")
+                    << ",\"seconds\":" << elapsed
+                    << ",\"mb_per_s\":" << rate
+                    << ",\"speedup\":" << speedup << "}" << endl;
+            }
+        }
+
+        if (!settings.keepFiles) {
+            fs::remove(plyPath, ec);
+            fs::remove(objPath, ec);
+            fs::remove(binaryPath, ec);
+        }
+    }
+    if (!settings.keepFiles) fs::remove_all(cacheDirectory, ec);
+
+    cout << endl << "不一致: " << mismatches << ", 失败: " << failures;
+    if (!baseline.empty()) cout << ", 吞吐量退化: " << regressions << " (容差 " << settings.tolerance * 100.0 << "%)";
+    cout << endl;
+    return mismatches == 0 && failures == 0 && regressions == 0 ? 0 : 1;
+}